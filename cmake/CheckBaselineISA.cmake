@@ -0,0 +1,26 @@
+# Fails if BINARY contains vex or evex encoded instructions, which only
+# the avx2 and avx512 variants of the dsp may use
+#
+# cmake -DOBJDUMP=<objdump> -DBINARY=<binary> -P CheckBaselineISA.cmake
+
+execute_process(
+	COMMAND ${OBJDUMP} -d --no-show-raw-insn ${BINARY}
+	OUTPUT_VARIABLE DISASSEMBLY
+	RESULT_VARIABLE RESULT
+)
+if (NOT RESULT EQUAL 0)
+	message(FATAL_ERROR "Failed to disassemble ${BINARY}")
+endif()
+
+# avx, fma and avx512 instructions all start with a v, the mask register
+# instructions of avx512 with a k, bmi is also vex encoded
+string(REGEX MATCHALL
+	"\t(v[a-z0-9]+|k(add|and|mov|not|or|shift|test|unpck|xnor|xor)[a-z]*|andn|bextr|blsi|blsmsk|blsr|bzhi|mulx|pdep|pext|rorx|sarx|shlx|shrx)[ \t\n][^\n]*"
+	MATCHES "${DISASSEMBLY}"
+)
+list(LENGTH MATCHES COUNT)
+if (COUNT GREATER 0)
+	string(REPLACE ";" "\n" LISTING "${MATCHES}")
+	string(SUBSTRING "${LISTING}" 0 1000 LISTING)
+	message(FATAL_ERROR "${BINARY} contains ${COUNT} vex or evex encoded instructions:\n${LISTING}")
+endif()
@@ -1,11 +1,16 @@
 #include <algorithm>
+#include <cassert>
 #include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <new>
 #include <utility>
 
 // Lv2
 #include <lv2/atom/util.h>
 
 #include "aether_dsp.hpp"
+#include "utils/fastmath.hpp"
 #include "utils/math.hpp"
 #include "../common/parameters.hpp"
 #include "../common/utils.hpp"
@@ -13,32 +18,64 @@
 
 namespace {
 	float dBtoGain(float db) noexcept {
-		return std::pow(10.f, db/20.f);
+		return fastmath::db_to_gain(db);
 	}
+
+	// every atom in a sequence is padded to 8 bytes
+	size_t padded(size_t size) noexcept {
+		return lv2_atom_pad_size(static_cast<uint32_t>(size));
+	}
+
+	// parameters that determine the size of the late delay memory
+	constexpr size_t late_delay_idx = offsetof(Aether::DSP::Parameters<float>, late_delay)/sizeof(float);
+	constexpr size_t late_diffusion_delay_idx = offsetof(Aether::DSP::Parameters<float>, late_diffusion_delay)/sizeof(float);
 }
 
 namespace Aether {
-	DSP::DSP(float rate) :
-		m_l_predelay(rate),
-		m_r_predelay(rate),
-		m_l_early_filters(rate),
-		m_r_early_filters(rate),
-		m_l_early_multitap(rate),
-		m_r_early_multitap(rate),
-		m_l_early_diffuser(rate, rng),
-		m_r_early_diffuser(rate, rng),
-		m_l_late_rev(rate, rng),
-		m_r_late_rev(rate, rng),
-		m_rate{rate}
+	DSP::DSP(float rate, const LV2_Worker_Schedule* schedule) :
+		m_late_sizes{schedule
+			? late_buffer_sizes(rate,
+				parameter_infos[late_delay_idx+6].dflt,
+				parameter_infos[late_diffusion_delay_idx+6].dflt)
+			: LateRev::max_buffer_sizes(rate)
+		},
+		m_arena(memory_required(rate, m_late_sizes)),
+		m_predelay(rate, m_arena),
+		m_early_filters(rate),
+		m_early_multitap(rate, m_arena),
+		m_early_diffuser(rate, rng, m_arena),
+		m_late_rev(rate, rng, m_late_sizes, m_arena),
+		m_rate{rate},
+		m_schedule{schedule},
+		// an eighth of a second, several frames of the ui
+		m_audio_tap(static_cast<size_t>(rate/static_cast<float>(ui_decimation(rate))/8.f),
+			static_cast<int32_t>(rate) / static_cast<int32_t>(ui_decimation(rate)))
 	{
-		for (size_t i = 0; i != param_targets.size(); ++i)
-			param_targets[i] = params[i] = parameter_infos[i+6].dflt;
+		assert(m_arena.used() <= m_arena.capacity());
+
+		// take every page fault now rather than on the audio thread
+		m_arena.prefault();
+	#ifdef LOCK_MEMORY
+		m_memory_locked = m_arena.lock();
+	#endif
+
+		// a quarter of a second leaves room for several late snapshots
+		const uint32_t decimation = ui_decimation(rate);
+		for (StreamBuffer& stream : m_ui_streams)
+			stream = StreamBuffer(static_cast<size_t>(rate/static_cast<float>(decimation)/4.f), decimation);
+
+		for (size_t p = 0; p != params.size(); ++p) {
+			params[p] = parameter_infos[p+6].dflt;
+			m_smoother.reset(p, params[p]);
+		}
 
 		for (bool& modified : params_modified)
 			modified = true;
 
 		apply_parameters();
+		params_modified = {};
 
+		Parameters<float> param_smooth = {};
 		param_smooth.mix = 50.f;
 
 		param_smooth.dry_level = 50.f;
@@ -67,30 +104,68 @@ namespace Aether {
 
 		param_smooth.seed_crossmix = 5000.f;
 
-		for (float& smooth : param_smooth) {
+		for (size_t p = 0; p < param_smooth.size(); ++p) {
 			constexpr float pi = constants::pi_v<float>;
+			float smooth = param_smooth[p];
 			if (smooth != 0.f)
-				smooth = std::exp(-2*pi / (0.0001f*smooth * rate));
+				smooth = fastmath::exp(-2*pi / (0.0001f*smooth * rate));
+
+			// changes smaller than this fraction of the range are not applied
+			constexpr float threshold = 1e-5f;
+			const ParameterInfo& info = parameter_infos[p+6];
+			m_smoother.set_smoothing(p, smooth, info.integer ? 0.f : threshold*info.range());
 		}
 	}
 
+	DSP::~DSP() {
+		// memory the host never passed to the worker or back
+		delete m_replacing_memory;
+		delete m_retired_memory;
+		delete m_grown_memory.load();
+		delete m_freed_memory.load();
+	}
+
+	size_t DSP::memory_required(float rate, LateRev::BufferSizes late_sizes) noexcept {
+		return DelayBank<float, channels>::memory_required(rate)
+			+ MultitapDelayBank<channels>::memory_required(rate)
+			+ AllpassDiffuserBank<float, channels>::memory_required(rate)
+			+ LateRev::memory_required(late_sizes);
+	}
+
+	uint32_t DSP::ui_decimation(float rate) noexcept {
+		return std::max(static_cast<uint32_t>(rate/ui_min_rate), uint32_t{1});
+	}
+
+	size_t DSP::delay_memory() const noexcept {
+		// the initial late buffers stay in the arena once they have been replaced
+		return m_arena.capacity() + m_late_rev.replaced_memory();
+	}
+
+	void DSP::set_threads(uint32_t threads, int priority) {
+		m_pool = threads ? std::make_unique<WorkerPool>(threads, priority) : nullptr;
+		m_late_rev.set_parallel(threads != 0);
+	}
+
 	void DSP::map_uris(LV2_URID_Map* map) noexcept {
 		lv2_atom_forge_init(&atom_forge, map);
 		uris.atom_Object = map->map(map->handle, LV2_ATOM__Object);
 		uris.atom_Float = map->map(map->handle, LV2_ATOM__Float);
 
-		uris.ui_open = map->map(map->handle, join_v<URI, ui_open_URI>);
-		uris.ui_close = map->map(map->handle, join_v<URI, ui_close_URI>);
+		uris.ui_open = map->map(map->handle, join_v<uri::plugin, uri::ui_open>);
+		uris.ui_close = map->map(map->handle, join_v<uri::plugin, uri::ui_close>);
 
-		uris.peak_data = map->map(map->handle, join_v<URI, peak_data_URI>);
-		uris.sample_count = map->map(map->handle, join_v<URI, sample_count_URI>);
-		uris.peaks = map->map(map->handle, join_v<URI, peaks_URI>);
+		uris.peak_data = map->map(map->handle, join_v<uri::plugin, uri::peak_data>);
+		uris.sample_count = map->map(map->handle, join_v<uri::plugin, uri::sample_count>);
+		uris.peaks = map->map(map->handle, join_v<uri::plugin, uri::peaks>);
 
-		uris.sample_data = map->map(map->handle, join_v<URI, sample_data_URI>);
-		uris.rate        = map->map(map->handle, join_v<URI, rate_URI>);
-		uris.channel     = map->map(map->handle, join_v<URI, channel_URI>);
-		uris.l_samples   = map->map(map->handle, join_v<URI, l_samples_URI>);
-		uris.r_samples   = map->map(map->handle, join_v<URI, r_samples_URI>);
+		uris.profile_data = map->map(map->handle, join_v<uri::plugin, uri::profile_data>);
+		uris.profile_stats = map->map(map->handle, join_v<uri::plugin, uri::profile_stats>);
+
+		uris.sample_data = map->map(map->handle, join_v<uri::plugin, uri::sample_data>);
+		uris.rate        = map->map(map->handle, join_v<uri::plugin, uri::rate>);
+		uris.channel     = map->map(map->handle, join_v<uri::plugin, uri::channel>);
+		uris.l_samples   = map->map(map->handle, join_v<uri::plugin, uri::l_samples>);
+		uris.r_samples   = map->map(map->handle, join_v<uri::plugin, uri::r_samples>);
 	}
 
 	void DSP::process(uint32_t n_samples) noexcept {
@@ -98,204 +173,506 @@ namespace Aether {
 			LV2_ATOM_SEQUENCE_FOREACH(ports.control, event) {
 				if (event->body.type == uris.atom_Object) {
 					const auto obj = reinterpret_cast<LV2_Atom_Object*>(&event->body);
-					if (obj->body.otype == uris.ui_open)
+					if (obj->body.otype == uris.ui_open) {
+						// the first snapshot holds only what was played since
+						if (!ui_open) {
+							for (StreamBuffer& stream : m_ui_streams)
+								stream.clear();
+							m_peaks = {};
+							m_ui_elapsed = 0;
+							m_ui_pending = false;
+						}
 						ui_open = true;
-					else if (obj->body.otype == uris.ui_close)
+					} else if (obj->body.otype == uris.ui_close) {
 						ui_open = false;
+					}
 				}
 			}
 		}
 
+		auto profile_start = Profiler::now();
 		LV2_Atom_Forge_Frame seq_frame;
 		bool notify_ui = ports.notify ? ui_open : false;
 		if (notify_ui) {
+			// the samples are sent in whatever space is left
 			const size_t seq_capacity = ports.notify->atom.size;
 			size_t min_seq_capacity = sizeof(LV2_Atom_Sequence)
-				+ sizeof_peak_data_atom() + 2*sizeof_sample_data_atom(n_samples);
+				+ sizeof_peak_data_atom() + sizeof_profile_data_atom();
 			notify_ui = seq_capacity >= min_seq_capacity;
 
 			if (notify_ui) {
 				lv2_atom_forge_set_buffer(&atom_forge, reinterpret_cast<uint8_t*>(ports.notify), seq_capacity);
 				lv2_atom_forge_sequence_head(&atom_forge, &seq_frame, 0);
-				write_sample_data_atom(0, static_cast<int>(m_rate), n_samples, ports.audio_in_left, ports.audio_in_right);
 			}
 		}
 
-		std::pair<float, float> peak_dry = {0,0},
-			peak_dry_stage = {0,0},
-			peak_predelay_stage = {0,0},
-			peak_early_stage = {0,0},
-			peak_late_stage = {0,0},
-			peak_out = {0,0};
+		// the samples go through the tap instead while the ui reads it
+		const bool tap_ui = ui_open && m_audio_tap.attached();
+		// a sleeping instance only outputs zeros for silent input, which the
+		// ui has already been sent while it was falling asleep
+		const bool idle = m_sleeping && input_silent(0, n_samples);
+		const bool stream_ui = (notify_ui || tap_ui) && !idle;
+		// copied before the host can overwrite the input with the output
+		if (stream_ui)
+			m_ui_streams[0].push(ports.audio_in_left, ports.audio_in_right, n_samples);
+		// the time of the atoms written before and after processing is added up
+		const auto atoms_time = Profiler::now() - profile_start;
 
 		update_parameter_targets();
-		for (uint32_t sample = 0; sample < n_samples; ++sample) {
-			update_parameters();
-
-			// Dry
-			float dry_level = params.dry_level/100.f;
-			float dry_left = ports.audio_in_left[sample];
-			float dry_right = ports.audio_in_right[sample];
-			{
-				ports.audio_out_left[sample] = dry_level*dry_left;
-				ports.audio_out_right[sample] = dry_level*dry_right;
+		if (m_retired_memory)
+			free_retired_memory();
+		grow_late_memory();
+
+		// with nothing left to change the pool is only woken once per span,
+		// forking and joining every block is slower than not using it at all
+		const bool span = m_pool && n_samples >= parallel_min_samples && can_span();
+		m_active_pool = span ? m_pool.get() : nullptr;
+		if (m_active_pool)
+			m_active_pool->wake();
+		for (uint32_t offset = 0; span && offset < n_samples; offset += max_span_size) {
+			const uint32_t n = std::min(max_span_size, n_samples - offset);
+
+			// checked before the host can overwrite the input with the output
+			std::array<bool, max_span_size/max_block_size> silent;
+			for (uint32_t block = 0; block < n; block += max_block_size)
+				silent[block/max_block_size] = input_silent(offset + block, std::min(max_block_size, n - block));
+
+			process_span(offset, n, notify_ui);
+			for (uint32_t block = 0; block < n; block += max_block_size)
+				track_silence(block, std::min(max_block_size, n - block), silent[block/max_block_size]);
+		}
+
+		for (uint32_t offset = 0; !span && offset < n_samples; offset += max_block_size) {
+			const uint32_t n = std::min(max_block_size, n_samples - offset);
+			const auto block_start = Profiler::now();
+			update_parameters(n);
+			m_profiler.lap(ProfileStage::parameters, block_start);
+
+			// the delay lines are left untouched while sleeping
+			const bool silent = input_silent(offset, n);
+			if (m_sleeping && silent) {
+				std::fill_n(ports.audio_out_left + offset, n, 0.f);
+				std::fill_n(ports.audio_out_right + offset, n, 0.f);
+				continue;
 			}
 
-			// Predelay
-			float predelay_level = params.predelay_level/100.f;
-			float predelay_left = dry_left;
-			float predelay_right = dry_right;
+			process_block(offset, n, notify_ui);
+			track_silence(0, n, silent);
+		}
+
+		if (m_active_pool)
+			m_active_pool->sleep();
+
+		profile_start = Profiler::now();
+		if (stream_ui)
+			m_ui_streams[1].push(ports.audio_out_left, ports.audio_out_right, n_samples);
+		if (tap_ui)
+			write_audio_tap();
+		if (notify_ui)
+			m_ui_elapsed += n_samples;
+
+		const bool snapshot = m_ui_pending || static_cast<float>(m_ui_elapsed) >= m_rate/ui_update_rate;
+		if (notify_ui && snapshot) {
+			// write peak data
+			lv2_atom_forge_frame_time(&atom_forge, 0);
 			{
-				float width = 0.5f-params.width/200.f;
-				predelay_left  = dry_left  + width * (dry_right - dry_left);
-				predelay_right = dry_right - width * (dry_right - dry_left);
+				LV2_Atom_Forge_Frame obj_frame;
+				lv2_atom_forge_object(&atom_forge, &obj_frame, 0, uris.peak_data);
+
+				lv2_atom_forge_key(&atom_forge, uris.sample_count);
+				lv2_atom_forge_int(&atom_forge, static_cast<int32_t>(m_ui_elapsed));
 
-				// predelay in samples
-				uint32_t delay = static_cast<uint32_t>(params.predelay/1000.f*m_rate);
-				predelay_left = m_l_predelay.push(predelay_left, delay);
-				predelay_right = m_r_predelay.push(predelay_right, delay);
+				const std::array<float, 12> peaks = {
+					m_peaks.dry.first				, m_peaks.dry.second,
+					m_peaks.dry_stage.first			, m_peaks.dry_stage.second,
+					m_peaks.predelay_stage.first	, m_peaks.predelay_stage.second,
+					m_peaks.early_stage.first		, m_peaks.early_stage.second,
+					m_peaks.late_stage.first		, m_peaks.late_stage.second,
+					m_peaks.out.first				, m_peaks.out.second
+				};
+
+				lv2_atom_forge_key(&atom_forge, uris.peaks);
+				lv2_atom_forge_vector(&atom_forge, sizeof(float), uris.atom_Float, peaks.size(), peaks.data());
 
-				ports.audio_out_left[sample] += predelay_level*predelay_left;
-				ports.audio_out_right[sample] += predelay_level*predelay_right;
+				lv2_atom_forge_pop(&atom_forge, &obj_frame);
 			}
 
-			// Early Reflections
-			float early_level = params.early_level/100.f;
-			float early_left = predelay_left;
-			float early_right = predelay_right;
-			{
-				// Filtering
-				if (params.early_low_cut_enabled > 0.f) {
-					early_left = m_l_early_filters.highpass.push(early_left);
-					early_right = m_r_early_filters.highpass.push(early_right);
-				}
+			m_peaks = {};
+			m_ui_elapsed = 0;
+		}
 
-				if (params.early_high_cut_enabled > 0.f) {
-					early_left = m_l_early_filters.lowpass.push(early_left);
-					early_right = m_r_early_filters.lowpass.push(early_right);
+		if (notify_ui) {
+			if constexpr (Profiler::enabled) {
+				if (m_profile_countdown <= n_samples) {
+					write_profile_data_atom();
+					m_profile_countdown = static_cast<uint32_t>(m_rate/10.f);
+				} else {
+					m_profile_countdown -= n_samples;
 				}
+			}
 
-				{ // multitap delay
-					uint32_t taps = static_cast<uint32_t>(params.early_taps);
-					float length = params.early_tap_length/1000.f*m_rate;
+			// write sample data, after everything else as it takes up the remaining space
+			if (snapshot && !tap_ui)
+				m_ui_pending = !write_sample_data_atoms();
 
-					float multitap_left = m_l_early_multitap.push(early_left, taps, length);
-					float multitap_right = m_r_early_multitap.push(early_right, taps, length);
+			lv2_atom_forge_pop(&atom_forge, &seq_frame);
+		}
+		if (notify_ui)
+			m_profiler.lap(ProfileStage::atoms, profile_start - atoms_time);
+	}
 
-					float tap_mix = params.early_tap_mix/100.f;
-					early_left  += tap_mix * (multitap_left  - early_left );
-					early_right += tap_mix * (multitap_right - early_right);
-				}
+	template <class ForEachBuffer, class Reset>
+	bool DSP::update_stage(Stage& stage, bool needed, ForEachBuffer&& for_each_buffer, Reset&& reset) noexcept {
+		if (!needed) {
+			if (stage.active)
+				stage.clear.start();
+			stage.active = false;
+			stage.clear.step(for_each_buffer, clear_budget);
+			return false;
+		}
+
+		if (!stage.active) {
+			if (stage.decays)
+				stage.clear.stop();
+			else
+				stage.clear.finish(for_each_buffer);
+			reset();
+		}
+		stage.active = true;
+		return true;
+	}
 
-				{ // allpass diffuser
-					AllpassDiffuser<float>::PushInfo info = {};
-					info.stages = static_cast<uint32_t>(params.early_diffusion_stages);
-					info.feedback = params.early_diffusion_feedback;
-					info.interpolate = true;
+	void DSP::process_block(uint32_t offset, uint32_t n, bool track_peaks) noexcept {
+		process_early(offset, n, 0);
+		process_late(n);
+		process_mix(offset, n, track_peaks);
+	}
 
-					early_left = m_l_early_diffuser.push(early_left, info);
-					early_right = m_r_early_diffuser.push(early_right, info);
-				}
+	void DSP::process_span(uint32_t offset, uint32_t n, bool track_peaks) noexcept {
+		for (uint32_t block = 0; block < n; block += max_block_size)
+			process_early(offset + block, std::min(max_block_size, n - block), block);
+		process_late(n);
+		process_mix(offset, n, track_peaks);
+	}
 
-				ports.audio_out_left[sample] += early_level*early_left;
-				ports.audio_out_right[sample] += early_level*early_right;
-			}
+	bool DSP::can_span() const noexcept {
+		// the parameters are constant for the whole call and the late
+		// stage applies no deferred changes whose timing depends on n
+		return m_smoother.active_count() == 0
+			&& m_late_stage.active
+			&& m_late_rev.settled()
+			&& !m_sleeping;
+	}
 
-			// Late Reverberations
-			float late_level = params.late_level/100.f;
-			float late_left = early_left;
-			float late_right = early_right;
-			{
-				AllpassDiffuser<double>::PushInfo diffuser_info = {};
-				diffuser_info.stages = static_cast<uint32_t>(params.late_diffusion_stages);
-				diffuser_info.feedback = params.late_diffusion_feedback;
-				diffuser_info.interpolate = params.interpolate > 0;
-
-				Delayline::Filters::PushInfo damping_info = {};
-				damping_info.ls_enable = params.late_low_shelf_enabled > 0;
-				damping_info.hs_enable = params.late_high_shelf_enabled > 0;
-				damping_info.hc_enable = params.late_high_cut_enabled > 0;
-
-				Delayline::PushInfo push_info = {};
-				push_info.order = static_cast<Delayline::Order>(params.late_order);
-				push_info.diffuser_info = diffuser_info;
-				push_info.damping_info = damping_info;
-
-				late_left = m_l_late_rev.push(late_left, push_info);
-				late_right = m_r_late_rev.push(late_right, push_info);
-				ports.audio_out_left[sample] += late_level*late_left;
-				ports.audio_out_right[sample] += late_level*late_right;
+	void DSP::process_early(uint32_t offset, uint32_t n, uint32_t buf) noexcept {
+		auto profile_start = Profiler::now();
+
+		Frame* dry = m_dry_buf.data() + buf;
+		Frame* predelay = m_predelay_buf.data() + buf;
+
+		// Dry
+		// copy the input as the host may reuse it for the output
+		for (uint32_t i = 0; i < n; ++i) {
+			dry[i][0] = ports.audio_in_left[offset+i];
+			dry[i][1] = ports.audio_in_right[offset+i];
+		}
+
+		// a stage contributes to the output if its level or a later stage does
+		const bool wet = params.mix > 0.f;
+		const bool late_needed = wet && params.late_level > 0.f;
+		const bool early_needed = late_needed || (wet && params.early_level > 0.f);
+		const bool predelay_needed = early_needed || (wet && params.predelay_level > 0.f);
+		const bool multitap_needed = early_needed && params.early_tap_mix > 0.f;
+
+		// Predelay
+		if (!update_stage(m_predelay_stage, predelay_needed,
+			[this](auto&& f) { m_predelay.for_each_buffer(f); }, []{}
+		)) {
+			std::fill_n(predelay, n, Frame{});
+		} else {
+			float width = 0.5f-params.width/200.f;
+			for (uint32_t i = 0; i < n; ++i) {
+				const float dry_left = dry[i][0];
+				const float dry_right = dry[i][1];
+				predelay[i][0] = dry_left  + width * (dry_right - dry_left);
+				predelay[i][1] = dry_right - width * (dry_right - dry_left);
 			}
 
-			{
-				float mix = params.mix/100.f;
-				ports.audio_out_left[sample] = math::lerp(dry_left, ports.audio_out_left[sample], mix);
-				ports.audio_out_right[sample] = math::lerp(dry_right, ports.audio_out_right[sample], mix);
+			// predelay in samples
+			uint32_t delay = static_cast<uint32_t>(params.predelay/1000.f*m_rate);
+			m_predelay.process_block(predelay, predelay, n, delay);
+		}
+		profile_start = m_profiler.lap(ProfileStage::predelay, profile_start);
+
+		// Early Reflections
+		const bool early_active = update_stage(m_early_stage, early_needed,
+			[this](auto&& f) { m_early_diffuser.for_each_buffer(f); },
+			[this]{
+				m_early_filters.lowpass.clear();
+				m_early_filters.highpass.clear();
+			}
+		);
+		const bool multitap_active = update_stage(m_multitap_stage, multitap_needed,
+			[this](auto&& f) { m_early_multitap.for_each_buffer(f); }, []{}
+		);
+		Frame* early = m_early_buf.data() + buf;
+		if (!early_active) {
+			std::fill_n(early, n, Frame{});
+		} else {
+			// Filtering
+			if (params.early_low_cut_enabled > 0.f)
+				m_early_filters.highpass.process_block(predelay, early, n);
+			else
+				std::copy_n(predelay, n, early);
+
+			if (params.early_high_cut_enabled > 0.f)
+				m_early_filters.lowpass.process_block(early, early, n);
+			profile_start = m_profiler.lap(ProfileStage::early_filters, profile_start);
+
+			if (multitap_active) { // multitap delay
+				uint32_t taps = static_cast<uint32_t>(params.early_taps);
+				float length = params.early_tap_length/1000.f*m_rate;
+
+				Frame* multitap = m_multitap_buf.data();
+				m_early_multitap.process_block(early, multitap, n, taps, length);
+
+				float tap_mix = params.early_tap_mix/100.f;
+				for (uint32_t i = 0; i < n; ++i)
+					for (size_t c = 0; c < channels; ++c)
+						early[i][c] += tap_mix * (multitap[i][c] - early[i][c]);
+				profile_start = m_profiler.lap(ProfileStage::multitap, profile_start);
 			}
 
-			if (notify_ui) {
-				peak_dry.first = std::max(peak_dry.first, std::abs(dry_left));
-				peak_dry.second = std::max(peak_dry.second, std::abs(dry_right));
-				peak_dry_stage.first = std::max(peak_dry_stage.first, std::abs(dry_left*dry_level));
-				peak_dry_stage.second = std::max(peak_dry_stage.second, std::abs(dry_right*dry_level));
-				peak_predelay_stage.first = std::max(peak_predelay_stage.first, std::abs(predelay_left*predelay_level));
-				peak_predelay_stage.second = std::max(peak_predelay_stage.second, std::abs(predelay_right*predelay_level));
-				peak_early_stage.first = std::max(peak_early_stage.first, std::abs(early_left*early_level));
-				peak_early_stage.second = std::max(peak_early_stage.second, std::abs(early_right*early_level));
-				peak_late_stage.first = std::max(peak_late_stage.first, std::abs(late_left*late_level));
-				peak_late_stage.second = std::max(peak_late_stage.second, std::abs(late_right*late_level));
-				peak_out.first = std::max(peak_out.first, std::abs(ports.audio_out_left[sample]));
-				peak_out.second = std::max(peak_out.second, std::abs(ports.audio_out_right[sample]));
+			{ // allpass diffuser
+				AllpassDiffuserBank<float, channels>::PushInfo info = {};
+				info.stages = static_cast<uint32_t>(params.early_diffusion_stages);
+				info.feedback = params.early_diffusion_feedback;
+				info.interpolate = true;
+
+				m_early_diffuser.process_block(early, early, n, info);
 			}
+			m_profiler.lap(ProfileStage::early_diffuser, profile_start);
 		}
-		if (notify_ui) {
-			// write peak data
-			lv2_atom_forge_frame_time(&atom_forge, 0);
-			{
-				LV2_Atom_Forge_Frame obj_frame;
-				lv2_atom_forge_object(&atom_forge, &obj_frame, 0, uris.peak_data);
+	}
 
-				lv2_atom_forge_key(&atom_forge, uris.sample_count);
-				lv2_atom_forge_int(&atom_forge, static_cast<int32_t>(n_samples));
+	void DSP::process_late(uint32_t n) noexcept {
+		const auto profile_start = Profiler::now();
 
-				const std::array<float, 12> peaks = {
-					peak_dry.first				, peak_dry.second,
-					peak_dry_stage.first		, peak_dry_stage.second,
-					peak_predelay_stage.first	, peak_predelay_stage.second,
-					peak_early_stage.first		, peak_early_stage.second,
-					peak_late_stage.first		, peak_late_stage.second,
-					peak_out.first				, peak_out.second
-				};
+		if (m_replacing_memory)
+			replace_late_memory();
 
-				lv2_atom_forge_key(&atom_forge, uris.peaks);
-				lv2_atom_forge_vector(&atom_forge, sizeof(float), uris.atom_Float, peaks.size(), peaks.data());
+		// Late Reverberations
+		const bool late_needed = params.mix > 0.f && params.late_level > 0.f;
+		// runs on without input until the tail has decayed, so that the
+		// memory never has to be cleared all at once when it is needed again
+		const bool late_decaying = !late_needed && m_late_stage.active
+			&& m_late_silent_samples <= m_silence_hold;
+		if (!update_stage(m_late_stage, late_needed || late_decaying,
+			[this](auto&& f) { m_late_rev.for_each_buffer(f); },
+			[this]{ m_late_rev.clear_state(); }
+		)) {
+			std::fill_n(m_late_buf.data(), n, Frame{});
+		} else {
+			LateRev::Diffuser::PushInfo diffuser_info = {};
+			diffuser_info.stages = static_cast<uint32_t>(params.late_diffusion_stages);
+			diffuser_info.feedback = params.late_diffusion_feedback;
+			diffuser_info.interpolate = params.interpolate > 0;
+
+			LateRev::DampingInfo damping_info = {};
+			damping_info.ls_enable = params.late_low_shelf_enabled > 0;
+			damping_info.hs_enable = params.late_high_shelf_enabled > 0;
+			damping_info.hc_enable = params.late_high_cut_enabled > 0;
+
+			LateRev::PushInfo push_info = {};
+			push_info.order = static_cast<LateRev::Order>(params.late_order);
+			push_info.diffuser_info = diffuser_info;
+			push_info.damping_info = damping_info;
+
+			const Frame* in = m_early_buf.data();
+			if (!late_needed) {
+				std::fill_n(m_late_buf.data(), n, Frame{});
+				in = m_late_buf.data();
+			}
+			m_late_rev.process_block(in, m_late_buf.data(), n, push_info, m_active_pool);
+		}
 
-				lv2_atom_forge_pop(&atom_forge, &obj_frame);
+		float peak = 0.f;
+		for (uint32_t i = 0; i < n; ++i)
+			peak = std::max({peak, std::abs(m_late_buf[i][0]), std::abs(m_late_buf[i][1])});
+		if (peak <= silence_threshold)
+			m_late_silent_samples += n;
+		else
+			m_late_silent_samples = 0;
+		m_profiler.lap(ProfileStage::late, profile_start);
+	}
+
+	void DSP::process_mix(uint32_t offset, uint32_t n, bool track_peaks) noexcept {
+		auto profile_start = Profiler::now();
+
+		float* out_left = ports.audio_out_left + offset;
+		float* out_right = ports.audio_out_right + offset;
+
+		float dry_level = params.dry_level/100.f;
+		float predelay_level = params.predelay_level/100.f;
+		float early_level = params.early_level/100.f;
+		float late_level = params.late_level/100.f;
+
+		// Mix
+		float mix = params.mix/100.f;
+		for (uint32_t i = 0; i < n; ++i) {
+			Frame out;
+			for (size_t c = 0; c < channels; ++c) {
+				out[c] = dry_level*m_dry_buf[i][c];
+				out[c] += predelay_level*m_predelay_buf[i][c];
+				out[c] += early_level*m_early_buf[i][c];
+				out[c] += late_level*m_late_buf[i][c];
+				out[c] = math::lerp(m_dry_buf[i][c], out[c], mix);
 			}
 
-			// write sample data
-			write_sample_data_atom(1, static_cast<int>(m_rate), n_samples, ports.audio_out_left, ports.audio_out_right);
-			lv2_atom_forge_pop(&atom_forge, &seq_frame);
+			out_left[i] = out[0];
+			out_right[i] = out[1];
 		}
+		profile_start = m_profiler.lap(ProfileStage::mix, profile_start);
+
+		if (track_peaks) {
+			auto track = [n](std::pair<float, float>& peak, const StereoBuffer& buf, float level) {
+				for (uint32_t i = 0; i < n; ++i) {
+					peak.first = std::max(peak.first, std::abs(buf[i][0]*level));
+					peak.second = std::max(peak.second, std::abs(buf[i][1]*level));
+				}
+			};
+
+			track(m_peaks.dry, m_dry_buf, 1.f);
+			track(m_peaks.dry_stage, m_dry_buf, dry_level);
+			track(m_peaks.predelay_stage, m_predelay_buf, predelay_level);
+			track(m_peaks.early_stage, m_early_buf, early_level);
+			track(m_peaks.late_stage, m_late_buf, late_level);
+			for (uint32_t i = 0; i < n; ++i) {
+				m_peaks.out.first = std::max(m_peaks.out.first, std::abs(out_left[i]));
+				m_peaks.out.second = std::max(m_peaks.out.second, std::abs(out_right[i]));
+			}
+			m_profiler.lap(ProfileStage::metering, profile_start);
+		}
+	}
+
+	bool DSP::input_silent(uint32_t offset, uint32_t n) const noexcept {
+		float peak = 0.f;
+		for (uint32_t i = offset; i < offset+n; ++i)
+			peak = std::max({peak, std::abs(ports.audio_in_left[i]), std::abs(ports.audio_in_right[i])});
+		return peak == 0.f;
+	}
+
+	void DSP::track_silence(uint32_t buf, uint32_t n, bool silent) noexcept {
+		// mean square of the output of every stage, whatever its level
+		auto energy = [buf, n](const StereoBuffer& stage) {
+			float sum = 0.f;
+			for (uint32_t i = buf; i < buf+n; ++i)
+				sum += stage[i][0]*stage[i][0] + stage[i][1]*stage[i][1];
+			return sum / static_cast<float>(channels*n);
+		};
+		const float tail_energy = std::max({energy(m_predelay_buf), energy(m_early_buf), energy(m_late_buf)});
+
+		if (silent && tail_energy <= silence_threshold*silence_threshold)
+			m_silent_samples += n;
+		else
+			m_silent_samples = 0;
+
+		m_sleeping = m_silent_samples > m_silence_hold;
+	}
+
+	void DSP::update_silence_hold() noexcept {
+		// every diffuser stage is assumed to be in use
+		const float early_diffusion = AllpassDiffuserBank<float, channels>::max_stages
+			* (params.early_diffusion_delay + params.early_diffusion_mod_depth);
+		const float late_diffusion = LateRev::Diffuser::max_stages
+			* (params.late_diffusion_delay + params.late_diffusion_mod_depth);
+		// the longest delay line is 1.5 times late_delay
+		const float late = 1.5f*params.late_delay + params.late_delay_mod_depth;
+
+		const float hold = params.predelay + params.early_tap_length + early_diffusion + late + late_diffusion;
+		m_silence_hold = static_cast<uint64_t>(hold/1000.f*m_rate) + max_block_size;
 	}
 
 	size_t DSP::sizeof_peak_data_atom() noexcept {
 		return sizeof(LV2_Atom_Event) // timestamp
 			+ sizeof(LV2_Atom_Object_Body) // object header
-			+ sizeof(LV2_Atom_Property_Body) + sizeof(int32_t) // sample_count
+			+ padded(sizeof(LV2_Atom_Property_Body) + sizeof(int32_t)) // sample_count
 			+ sizeof(LV2_Atom_Property_Body) + sizeof(LV2_Atom_Vector_Body)
 				+ 12*sizeof(float); // peak data
 	}
 
+	size_t DSP::sizeof_profile_data_atom() noexcept {
+		if constexpr (!Profiler::enabled) return 0;
+		return sizeof(LV2_Atom_Event) // timestamp
+			+ sizeof(LV2_Atom_Object_Body) // object header
+			+ sizeof(LV2_Atom_Property_Body) + sizeof(LV2_Atom_Vector_Body)
+				+ padded(4*Profiler::stages*sizeof(float)); // stats
+	}
+
+	void DSP::write_profile_data_atom() noexcept {
+		std::array<float, 4*Profiler::stages> stats;
+		for (size_t s = 0; s < Profiler::stages; ++s) {
+			const auto stage = m_profiler.stats(static_cast<ProfileStage>(s));
+			stats[4*s+0] = static_cast<float>(static_cast<double>(stage.min)/1000.0);
+			stats[4*s+1] = static_cast<float>(stage.avg/1000.0);
+			stats[4*s+2] = static_cast<float>(static_cast<double>(stage.p99)/1000.0);
+			stats[4*s+3] = static_cast<float>(static_cast<double>(stage.max)/1000.0);
+		}
+
+		lv2_atom_forge_frame_time(&atom_forge, 0);
+		LV2_Atom_Forge_Frame obj_frame;
+		lv2_atom_forge_object(&atom_forge, &obj_frame, 0, uris.profile_data);
+		lv2_atom_forge_key(&atom_forge, uris.profile_stats);
+		lv2_atom_forge_vector(&atom_forge, sizeof(float), uris.atom_Float, stats.size(), stats.data());
+		lv2_atom_forge_pop(&atom_forge, &obj_frame);
+	}
+
 	size_t DSP::sizeof_sample_data_atom(uint32_t n_samples) noexcept {
+		// every property is padded to 8 bytes
+		const size_t channel_size = padded(n_samples*sizeof(float));
 		return sizeof(LV2_Atom_Event) // timestamp
 			+ sizeof(LV2_Atom_Object_Body) // object header
-			+ sizeof(LV2_Atom_Property_Body) + sizeof(int32_t) //samplerate
-			+ sizeof(LV2_Atom_Property_Body) + sizeof(int32_t) // channel no.
+			+ padded(sizeof(LV2_Atom_Property_Body) + sizeof(int32_t)) //samplerate
+			+ padded(sizeof(LV2_Atom_Property_Body) + sizeof(int32_t)) // channel no.
 			+ sizeof(LV2_Atom_Property_Body) + sizeof(LV2_Atom_Vector_Body)
-				+ n_samples*sizeof(float) // left channel
+				+ channel_size // left channel
 			+ sizeof(LV2_Atom_Property_Body) + sizeof(LV2_Atom_Vector_Body)
-				+ n_samples*sizeof(float); // right channel
+				+ channel_size; // right channel
+	}
+
+	bool DSP::write_sample_data_atoms() noexcept {
+		// takes turns between the streams, also across runs, so that both get a share of the space
+		while (m_ui_streams[0].size() || m_ui_streams[1].size()) {
+			const size_t stream = m_ui_next_stream;
+			StreamBuffer& buf = m_ui_streams[stream];
+			if (buf.size() == 0) {
+				m_ui_next_stream = 1 - stream;
+				continue;
+			}
+
+			const size_t space = atom_forge.size - atom_forge.offset;
+			if (space < sizeof_sample_data_atom(2)) return false;
+
+			// an even number of samples, so the padding can not overflow the space
+			const size_t fits = 2*((space - sizeof_sample_data_atom(0)) / (4*sizeof(float)));
+			const auto n = static_cast<uint32_t>(buf.pop(m_ui_chunk[0].data(), m_ui_chunk[1].data(), std::min<size_t>(fits, ui_chunk_size)));
+
+			const int rate = static_cast<int>(m_rate) / static_cast<int>(buf.decimation());
+			write_sample_data_atom(static_cast<int>(stream), rate, n, m_ui_chunk[0].data(), m_ui_chunk[1].data());
+			m_ui_next_stream = 1 - stream;
+		}
+		return true;
+	}
+
+	void DSP::write_audio_tap() noexcept {
+		for (size_t stream = 0; stream < m_ui_streams.size(); ++stream) {
+			StreamBuffer& buf = m_ui_streams[stream];
+			while (buf.size() && m_audio_tap.space(stream)) {
+				const size_t n = buf.pop(m_ui_chunk[0].data(), m_ui_chunk[1].data(),
+					std::min<size_t>(m_audio_tap.space(stream), ui_chunk_size));
+				m_audio_tap.write(stream, m_ui_chunk[0].data(), m_ui_chunk[1].data(), n);
+			}
+		}
 	}
 
 	void DSP::write_sample_data_atom(
@@ -326,55 +703,159 @@ namespace Aether {
 	}
 
 	void DSP::update_parameter_targets() noexcept {
-		for (size_t p = 0; p < param_targets.size(); ++p) {
-			param_targets[p] = std::clamp(
+		for (size_t p = 0; p < param_ports.size(); ++p) {
+			m_smoother.set_target(p, std::clamp(
 				param_ports[p] ? *param_ports[p] : parameter_infos[p+6].dflt,
 				parameter_infos[p+6].min,
 				parameter_infos[p+6].max
-			);
+			));
 		}
 	}
 
-	void DSP::update_parameters() noexcept {
-		for (size_t p = 0; p < param_ports.size(); ++p) {
-			const float new_value = param_targets[p] - param_smooth[p] * (param_targets[p] - params[p]);
-			params_modified[p] = (new_value != params[p]);
-			params[p] = new_value;
+	LateRev::BufferSizes DSP::late_buffer_sizes(float rate, float delay, float diffusion_delay) noexcept {
+		return LateRev::buffer_sizes(rate, rate*delay/1000.f, rate*diffusion_delay/1000.f);
+	}
+
+	void DSP::grow_late_memory() noexcept {
+		if (!m_schedule || m_growing || m_retired_memory) return;
+
+		// grow as soon as the targets change rather than once the smoothed values get there
+		const LateRev::BufferSizes required = late_buffer_sizes(m_rate,
+			m_smoother.target(late_delay_idx),
+			m_smoother.target(late_diffusion_delay_idx)
+		);
+		const LateRev::BufferSizes capacity = m_late_rev.buffer_capacity();
+		if (required.delay <= capacity.delay && required.diffusion <= capacity.diffusion)
+			return;
+
+		// neither buffer may shrink, the capacities are rounded up to powers of two
+		WorkRequest request = {};
+		request.type = WorkRequest::Type::grow;
+		request.sizes = {
+			std::max(required.delay, capacity.delay),
+			std::max(required.diffusion, capacity.diffusion)
+		};
+		m_growing = m_schedule->schedule_work(m_schedule->handle, sizeof(request), &request) == LV2_WORKER_SUCCESS;
+	}
+
+	void DSP::free_retired_memory() noexcept {
+		// the previous request has yet to be run
+		if (m_freed_memory.load(std::memory_order_acquire)) return;
+
+		m_freed_memory.store(m_retired_memory, std::memory_order_release);
+		WorkRequest request = {};
+		request.type = WorkRequest::Type::free;
+		if (m_schedule->schedule_work(m_schedule->handle, sizeof(request), &request) == LV2_WORKER_SUCCESS)
+			m_retired_memory = nullptr;
+		else
+			m_freed_memory.store(nullptr, std::memory_order_relaxed);
+	}
+
+	LV2_Worker_Status DSP::work(
+		LV2_Worker_Respond_Function respond,
+		LV2_Worker_Respond_Handle handle,
+		uint32_t size,
+		const void* data
+	) noexcept {
+		if (size != sizeof(WorkRequest)) return LV2_WORKER_ERR_UNKNOWN;
+		WorkRequest request;
+		std::memcpy(&request, data, sizeof(request));
+
+		switch (request.type) {
+			case WorkRequest::Type::grow: {
+				LateRev::Memory* memory = nullptr;
+				try {
+					memory = new LateRev::Memory(request.sizes);
+					memory->arena->prefault();
+				#ifdef LOCK_MEMORY
+					memory->arena->lock();
+				#endif
+				} catch (const std::bad_alloc&) {}
+				// nullptr if the allocation failed
+				m_grown_memory.store(memory, std::memory_order_release);
+				const bool allocated = memory != nullptr;
+				return respond(handle, sizeof(allocated), &allocated);
+			}
+			case WorkRequest::Type::free:
+				delete m_freed_memory.exchange(nullptr, std::memory_order_acq_rel);
+				return LV2_WORKER_SUCCESS;
+		}
+		return LV2_WORKER_ERR_UNKNOWN;
+	}
+
+	LV2_Worker_Status DSP::work_response(uint32_t size, const void*) noexcept {
+		if (size != sizeof(bool)) return LV2_WORKER_ERR_UNKNOWN;
+		// left in its slot until now, so that the destructor frees it if the response never arrives
+		LateRev::Memory* memory = m_grown_memory.exchange(nullptr, std::memory_order_acq_rel);
+
+		// m_growing stays set, so that failed allocations are not retried
+		// and the delays stay limited to the current buffers
+		if (!memory) return LV2_WORKER_ERR_NO_SPACE;
+
+		// the history is copied a piece at a time by the following blocks
+		m_late_rev.start_replace_memory(*memory);
+		m_replacing_memory = memory;
+		return LV2_WORKER_SUCCESS;
+	}
+
+	void DSP::replace_late_memory() noexcept {
+		// a skipped stage has no history worth copying
+		if (!m_late_rev.step_replace_memory(replace_budget, m_late_stage.active))
+			return;
+
+		// whatever was copied before the stage was skipped is stale
+		if (!m_late_stage.active)
+			m_late_stage.clear.start();
+		// memory now holds the previous buffers, which are freed by the
+		// worker once process is able to schedule it
+		m_retired_memory = std::exchange(m_replacing_memory, nullptr);
+		m_growing = false;
+	}
+
+	void DSP::reset_parameters() noexcept {
+		update_parameter_targets();
+		for (size_t p = 0; p < params.size(); ++p) {
+			params[p] = m_smoother.target(p);
+			m_smoother.reset(p, params[p]);
 		}
 
+		for (bool& modified : params_modified)
+			modified = true;
 		apply_parameters();
+		params_modified = {};
+	}
+
+	void DSP::update_parameters(uint32_t n) noexcept {
+		if (m_smoother.advance(n, params.data(), params_modified.data())) {
+			apply_parameters();
+			params_modified = {};
+		}
 	}
 
 	void DSP::apply_parameters() noexcept {
+		// stereo decorrelation: the left channel uses the crossmix mirrored
+		const float crossmix = params.seed_crossmix/200.f;
+		const std::array<float, channels> crossmixes = {1.f-crossmix, 0.f+crossmix};
+
 		// Early Reflections
 
 		// Filters
-		if (params_modified.early_low_cut_cutoff) {
-			float cutoff = params.early_low_cut_cutoff;
-			m_l_early_filters.highpass.set_cutoff(cutoff);
-			m_r_early_filters.highpass.set_cutoff(cutoff);
-		}
-		if (params_modified.early_high_cut_cutoff) {
-			float cutoff = params.early_high_cut_cutoff;
-			m_l_early_filters.lowpass.set_cutoff(cutoff);
-			m_r_early_filters.lowpass.set_cutoff(cutoff);
-		}
+		if (params_modified.early_low_cut_cutoff)
+			m_early_filters.highpass.set_cutoff(params.early_low_cut_cutoff);
+		if (params_modified.early_high_cut_cutoff)
+			m_early_filters.lowpass.set_cutoff(params.early_high_cut_cutoff);
 
 		// Multitap Delay
-		if (params_modified.early_tap_decay) {
-			float decay = params.early_tap_decay;
-			m_l_early_multitap.set_decay(decay);
-			m_r_early_multitap.set_decay(decay);
-		}
+		if (params_modified.early_tap_decay)
+			m_early_multitap.set_decay(params.early_tap_decay);
 		if (params_modified.seed_crossmix) {
-			float crossmix = params.seed_crossmix/200.f;
-			m_l_early_multitap.set_seed_crossmix(1.f-crossmix);
-			m_r_early_multitap.set_seed_crossmix(0.f+crossmix);
+			for (size_t c = 0; c < channels; ++c)
+				m_early_multitap.set_seed_crossmix(c, crossmixes[c]);
 		}
 		if (params_modified.tap_seed) {
 			uint32_t seed = static_cast<uint32_t>(params.tap_seed);
-			m_l_early_multitap.set_seed(seed);
-			m_r_early_multitap.set_seed(seed);
+			for (size_t c = 0; c < channels; ++c)
+				m_early_multitap.set_seed(c, seed);
 		}
 
 		// Diffuser
@@ -383,75 +864,45 @@ namespace Aether {
 				params.early_diffusion_drive == -12 ?
 					0 :
 					dBtoGain(params.early_diffusion_drive);
-			m_l_early_diffuser.set_drive(drive);
-			m_r_early_diffuser.set_drive(drive);
-		}
-		if (params_modified.early_diffusion_delay) {
-			float delay = m_rate*params.early_diffusion_delay/1000.f;
-			m_l_early_diffuser.set_delay(delay);
-			m_r_early_diffuser.set_delay(delay);
-		}
-		if (params_modified.early_diffusion_mod_depth) {
-			float mod_depth = m_rate*params.early_diffusion_mod_depth/1000.f;
-			m_l_early_diffuser.set_mod_depth(mod_depth);
-			m_r_early_diffuser.set_mod_depth(mod_depth);
-		}
-		if (params_modified.early_diffusion_mod_rate) {
-			float rate = params.early_diffusion_mod_rate/m_rate;
-			m_l_early_diffuser.set_mod_rate(rate);
-			m_r_early_diffuser.set_mod_rate(rate);
-		}
+			m_early_diffuser.set_drive(drive);
+		}
+		if (params_modified.early_diffusion_delay)
+			m_early_diffuser.set_delay(m_rate*params.early_diffusion_delay/1000.f);
+		if (params_modified.early_diffusion_mod_depth)
+			m_early_diffuser.set_mod_depth(m_rate*params.early_diffusion_mod_depth/1000.f);
+		if (params_modified.early_diffusion_mod_rate)
+			m_early_diffuser.set_mod_rate(params.early_diffusion_mod_rate/m_rate);
 		if (params_modified.seed_crossmix) {
-			float crossmix = params.seed_crossmix/200.f;
-			m_l_early_diffuser.set_seed_crossmix(1.f-crossmix);
-			m_r_early_diffuser.set_seed_crossmix(0.f+crossmix);
+			for (size_t c = 0; c < channels; ++c)
+				m_early_diffuser.set_seed_crossmix(c, crossmixes[c]);
 		}
 		if (params_modified.early_diffusion_seed) {
 			uint32_t seed = static_cast<uint32_t>(params.early_diffusion_seed);
-			m_l_early_diffuser.set_seed(seed);
-			m_r_early_diffuser.set_seed(seed);
+			for (size_t c = 0; c < channels; ++c)
+				m_early_diffuser.set_seed(c, seed);
 		}
 
 		// Late Reverberations
 
 		// General
 		if (params_modified.seed_crossmix) {
-			float crossmix = params.seed_crossmix/200.f;
-			m_l_late_rev.set_seed_crossmix(1.f-crossmix);
-			m_r_late_rev.set_seed_crossmix(0.f+crossmix);
-		}
-		if (params_modified.late_delay_lines) {
-			uint32_t lines = static_cast<uint32_t>(params.late_delay_lines);
-			m_l_late_rev.set_delay_lines(lines);
-			m_r_late_rev.set_delay_lines(lines);
+			for (uint32_t c = 0; c < channels; ++c)
+				m_late_rev.set_seed_crossmix(c, crossmixes[c]);
 		}
+		if (params_modified.late_delay_lines)
+			m_late_rev.set_delay_lines(static_cast<uint32_t>(params.late_delay_lines));
 
 		// Modulated Delay
-		if (params_modified.late_delay) {
-			float delay = m_rate*params.late_delay/1000.f;
-			m_l_late_rev.set_delay(delay);
-			m_r_late_rev.set_delay(delay);
-		}
-		if (params_modified.late_delay_mod_depth) {
-			float mod_depth = m_rate*params.late_delay_mod_depth/1000.f;
-			m_l_late_rev.set_delay_mod_depth(mod_depth);
-			m_r_late_rev.set_delay_mod_depth(mod_depth);
-		}
-		if (params_modified.late_delay_mod_rate) {
-			float mod_rate = params.late_delay_mod_rate/m_rate;
-			m_l_late_rev.set_delay_mod_rate(mod_rate);
-			m_r_late_rev.set_delay_mod_rate(mod_rate);
-		}
-		if (params_modified.late_delay_line_feedback) {
-			float feedback = params.late_delay_line_feedback;
-			m_l_late_rev.set_delay_feedback(feedback);
-			m_r_late_rev.set_delay_feedback(feedback);
-		}
-		if (params_modified.delay_seed) {
-			uint32_t seed = static_cast<uint32_t>(params.delay_seed);
-			m_l_late_rev.set_delay_seed(seed);
-			m_r_late_rev.set_delay_seed(seed);
-		}
+		if (params_modified.late_delay)
+			m_late_rev.set_delay(m_rate*params.late_delay/1000.f);
+		if (params_modified.late_delay_mod_depth)
+			m_late_rev.set_delay_mod_depth(m_rate*params.late_delay_mod_depth/1000.f);
+		if (params_modified.late_delay_mod_rate)
+			m_late_rev.set_delay_mod_rate(params.late_delay_mod_rate/m_rate);
+		if (params_modified.late_delay_line_feedback)
+			m_late_rev.set_delay_feedback(params.late_delay_line_feedback);
+		if (params_modified.delay_seed)
+			m_late_rev.set_delay_seed(static_cast<uint32_t>(params.delay_seed));
 
 		// Diffuser
 		if (params_modified.late_diffusion_drive) {
@@ -459,55 +910,29 @@ namespace Aether {
 				params.late_diffusion_drive == -12 ?
 					0 :
 					dBtoGain(params.late_diffusion_drive);
-			m_l_late_rev.set_diffusion_drive(drive);
-			m_r_late_rev.set_diffusion_drive(drive);
-		}
-		if (params_modified.late_diffusion_delay) {
-			float delay = m_rate*params.late_diffusion_delay/1000.f;
-			m_l_late_rev.set_diffusion_delay(delay);
-			m_r_late_rev.set_diffusion_delay(delay);
-		}
-		if (params_modified.late_diffusion_mod_depth) {
-			float depth = m_rate*params.late_diffusion_mod_depth/1000.f;
-			m_l_late_rev.set_diffusion_mod_depth(depth);
-			m_r_late_rev.set_diffusion_mod_depth(depth);
-		}
-		if (params_modified.late_diffusion_mod_rate) {
-			float rate = params.late_diffusion_mod_rate/m_rate;
-			m_l_late_rev.set_diffusion_mod_rate(rate);
-			m_r_late_rev.set_diffusion_mod_rate(rate);
-		}
-		if (params_modified.late_diffusion_seed) {
-			uint32_t seed = static_cast<uint32_t>(params.late_diffusion_seed);
-			m_l_late_rev.set_diffusion_seed(seed);
-			m_r_late_rev.set_diffusion_seed(seed);
+			m_late_rev.set_diffusion_drive(drive);
 		}
+		if (params_modified.late_diffusion_delay)
+			m_late_rev.set_diffusion_delay(m_rate*params.late_diffusion_delay/1000.f);
+		if (params_modified.late_diffusion_mod_depth)
+			m_late_rev.set_diffusion_mod_depth(m_rate*params.late_diffusion_mod_depth/1000.f);
+		if (params_modified.late_diffusion_mod_rate)
+			m_late_rev.set_diffusion_mod_rate(params.late_diffusion_mod_rate/m_rate);
+		if (params_modified.late_diffusion_seed)
+			m_late_rev.set_diffusion_seed(static_cast<uint32_t>(params.late_diffusion_seed));
 
 		// Filters
-		if (params_modified.late_low_shelf_cutoff) {
-			float cutoff = params.late_low_shelf_cutoff;
-			m_l_late_rev.set_low_shelf_cutoff(cutoff);
-			m_r_late_rev.set_low_shelf_cutoff(cutoff);
-		}
-		if (params_modified.late_low_shelf_gain) {
-			float gain = dBtoGain(params.late_low_shelf_gain);
-			m_l_late_rev.set_low_shelf_gain(gain);
-			m_r_late_rev.set_low_shelf_gain(gain);
-		}
-		if (params_modified.late_high_shelf_cutoff) {
-			float cutoff = params.late_high_shelf_cutoff;
-			m_l_late_rev.set_high_shelf_cutoff(cutoff);
-			m_r_late_rev.set_high_shelf_cutoff(cutoff);
-		}
-		if (params_modified.late_high_shelf_gain) {
-			float gain = dBtoGain(params.late_high_shelf_gain);
-			m_l_late_rev.set_high_shelf_gain(gain);
-			m_r_late_rev.set_high_shelf_gain(gain);
-		}
-		if (params_modified.late_high_cut_cutoff) {
-			float cutoff = params.late_high_cut_cutoff;
-			m_l_late_rev.set_high_cut_cutoff(cutoff);
-			m_r_late_rev.set_high_cut_cutoff(cutoff);
-		}
+		if (params_modified.late_low_shelf_cutoff)
+			m_late_rev.set_low_shelf_cutoff(params.late_low_shelf_cutoff);
+		if (params_modified.late_low_shelf_gain)
+			m_late_rev.set_low_shelf_gain(dBtoGain(params.late_low_shelf_gain));
+		if (params_modified.late_high_shelf_cutoff)
+			m_late_rev.set_high_shelf_cutoff(params.late_high_shelf_cutoff);
+		if (params_modified.late_high_shelf_gain)
+			m_late_rev.set_high_shelf_gain(dBtoGain(params.late_high_shelf_gain));
+		if (params_modified.late_high_cut_cutoff)
+			m_late_rev.set_high_cut_cutoff(params.late_high_cut_cutoff);
+
+		update_silence_hold();
 	}
 }
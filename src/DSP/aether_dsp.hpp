@@ -1,42 +1,43 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <random>
 #include <string_view>
+#include <utility>
 
 // LV2
 #include <lv2/atom/atom.h>
 #include <lv2/urid/urid.h>
 #include <lv2/atom/forge.h>
+#include <lv2/worker/worker.h>
 
+#include "../common/audio_tap.hpp"
+#include "../common/uris.hpp"
+
+#include "utils/arena.hpp"
+#include "utils/incremental_clear.hpp"
+#include "utils/profiler.hpp"
 #include "utils/random.hpp"
+#include "utils/smoother.hpp"
+#include "utils/stream_buffer.hpp"
+#include "utils/worker_pool.hpp"
 
 #include "delay.hpp"
 #include "filters.hpp"
 #include "diffuser.hpp"
 #include "delayline.hpp"
 
+#include "architecture.hpp"
+
 namespace Aether {
+AETHER_ISA_NAMESPACE_BEGIN
 
 	class DSP {
 	public:
-		static constexpr std::string_view URI = "http://github.com/Dougal-s/Aether";
-
-		static constexpr std::string_view ui_open_URI = "#uiOpen";
-		static constexpr std::string_view ui_close_URI = "#uiClose";
-
-		static constexpr std::string_view peak_data_URI = "#peakData";
-		static constexpr std::string_view sample_count_URI = "#sampleCount";
-		static constexpr std::string_view peaks_URI = "#peaks";
-
-		static constexpr std::string_view sample_data_URI = "#sampleData";
-		static constexpr std::string_view rate_URI = "#rate";
-		static constexpr std::string_view channel_URI = "#channel";
-		static constexpr std::string_view l_samples_URI = "#lSamples";
-		static constexpr std::string_view r_samples_URI = "#rSamples";
-
 		struct Ports {
 			const LV2_Atom_Sequence* control;
 			LV2_Atom_Sequence* notify;
@@ -131,11 +132,32 @@ namespace Aether {
 			static constexpr size_t size() noexcept { return sizeof(Parameters<T>) / sizeof(T); }
 		};
 
+		// maximum number of samples each stage processes at a time
+		static constexpr uint32_t max_block_size = 32;
+
+		// parts of process whose time is recorded when built with AETHER_PROFILE
+		enum class ProfileStage {
+			parameters,     // per block
+			predelay,       // per block
+			early_filters,  // per block
+			multitap,       // per block
+			early_diffuser, // per block
+			late,           // per block
+			mix,            // per block
+			metering,       // per block
+			atoms,          // per call to process
+			count
+		};
+
+		// in the order the ui expects them in
+		static constexpr std::array<std::string_view, static_cast<size_t>(ProfileStage::count)> profile_stage_names =
+			uri::profile_stages;
+
+		using Profiler = StageProfiler<ProfileStage>;
+
 		Ports ports = {};
 
 		Parameters<float> params = {};
-		Parameters<float> param_targets = {};
-		Parameters<float> param_smooth = {};
 		Parameters<bool> params_modified = {};
 		std::array<const float*, 47> param_ports = {};
 
@@ -143,13 +165,65 @@ namespace Aether {
 			Member Functions
 		*/
 
-		DSP(float rate);
-		~DSP() = default;
+		/*
+			Without a schedule the late delay memory is sized for the
+			longest delays. With one it is sized for the current delays
+			and grown by the worker whenever they increase
+		*/
+		explicit DSP(float rate, const LV2_Worker_Schedule* schedule = nullptr);
+		DSP(const DSP&) = delete;
+		~DSP();
+
+		DSP& operator=(const DSP&) = delete;
 
 		void map_uris(LV2_URID_Map* map) noexcept;
 
+		// whether the delay memory is locked into ram
+		bool memory_locked() const noexcept { return m_memory_locked; }
+		// bytes of delay memory currently held by the instance
+		size_t delay_memory() const noexcept;
+		// whether processing is skipped until the input is no longer silent
+		bool sleeping() const noexcept { return m_sleeping; }
+
+		/*
+			While a ui has attached itself to the tap the samples are
+			written to it instead of being sent as atoms
+		*/
+		AudioTap& audio_tap() noexcept { return m_audio_tap; }
+
+		const Profiler& profiler() const noexcept { return m_profiler; }
+		Profiler& profiler() noexcept { return m_profiler; }
+
+		/*
+			Spreads the late delay lines over the calling thread and
+			threads additional ones whenever process is called with at
+			least parallel_min_samples and nothing left to smooth or
+			apply (see can_span), 0 processes everything on the
+			calling thread. A non-zero priority runs the threads with
+			SCHED_FIFO at that priority
+
+			Must not be called while process is running
+		*/
+		void set_threads(uint32_t threads, int priority = 0);
+		uint32_t threads() const noexcept { return m_pool ? m_pool->threads() : 0; }
+
+		// smaller calls to process are not worth waking the threads for
+		static constexpr uint32_t parallel_min_samples = 256;
+
+		// jumps to the values of param_ports instead of smoothing towards them
+		void reset_parameters() noexcept;
+
 		void process(uint32_t n_samples) noexcept;
 
+		// lv2 worker interface
+		LV2_Worker_Status work(
+			LV2_Worker_Respond_Function respond,
+			LV2_Worker_Respond_Handle handle,
+			uint32_t size,
+			const void* data
+		) noexcept;
+		LV2_Worker_Status work_response(uint32_t size, const void* data) noexcept;
+
 	private:
 		Random::Xorshift64s rng{std::random_device{}()};
 
@@ -164,6 +238,9 @@ namespace Aether {
 			LV2_URID sample_count;
 			LV2_URID peaks;
 
+			LV2_URID profile_data;
+			LV2_URID profile_stats;
+
 			LV2_URID sample_data;
 			LV2_URID rate;
 			LV2_URID channel;
@@ -174,38 +251,182 @@ namespace Aether {
 		URIs uris = {};
 		LV2_Atom_Forge atom_forge = {};
 
+		// every stage processes the left and right channel side by side
+		static constexpr size_t channels = 2;
+		using Frame = std::array<float, channels>;
+
+		// initial size of the late delay memory
+		LateRev::BufferSizes m_late_sizes;
+
+		// delay memory of every stage, has to be constructed first
+		Arena m_arena;
+		bool m_memory_locked = false;
+
 		// Predelay
-		Delay m_l_predelay;
-		Delay m_r_predelay;
+		DelayBank<float, channels> m_predelay;
 
 		// Early
 		struct Filters {
 			Filters(float rate) : lowpass(rate), highpass(rate) {}
 
-			Lowpass6dB<float> lowpass;
-			Highpass6dB<float> highpass;
+			Lowpass6dBBank<float, channels> lowpass;
+			Highpass6dBBank<float, channels> highpass;
 		};
 
-		Filters m_l_early_filters;
-		Filters m_r_early_filters;
+		Filters m_early_filters;
+		MultitapDelayBank<channels> m_early_multitap;
+		AllpassDiffuserBank<float, channels> m_early_diffuser;
+
+		// Late
+		LateRev m_late_rev;
+
+		/*
+			Stages are skipped while they do not contribute to the output.
+			Their delay memory is cleared a piece at a time meanwhile, and
+			whatever is left is cleared when they are needed again.
 
-		MultitapDelay m_l_early_multitap;
-		MultitapDelay m_r_early_multitap;
+			A stage that decays is only skipped once its tail has, so what
+			is left of its memory is inaudible and not cleared at all
+		*/
+		struct Stage {
+			bool active = true;
+			bool decays = false;
+			IncrementalClear clear = {};
+		};
 
-		AllpassDiffuser<float> m_l_early_diffuser;
-		AllpassDiffuser<float> m_r_early_diffuser;
+		// bytes of delay memory cleared per block of a skipped stage
+		static constexpr size_t clear_budget = 64*1024;
 
-		// Late
-		LateRev m_l_late_rev;
-		LateRev m_r_late_rev;
+		Stage m_predelay_stage = {};
+		Stage m_early_stage = {};
+		Stage m_multitap_stage = {};
+		Stage m_late_stage = {true, true};
 
 		float m_rate;
 
+		// grows the late delay memory, nullptr if the host has no worker
+		const LV2_Worker_Schedule* m_schedule;
+		// a larger LateRev::Memory has been requested
+		bool m_growing = false;
+		// grown memory the history of the late stage is being copied into
+		LateRev::Memory* m_replacing_memory = nullptr;
+		// replaced memory the worker has yet to be asked to free
+		LateRev::Memory* m_retired_memory = nullptr;
+
+		/*
+			bytes of late history copied into grown memory per block,
+			well above what the late stage writes per block, so that the
+			copy catches up
+		*/
+		static constexpr size_t replace_budget = 256*1024;
+		static_assert(replace_budget > 2*max_block_size*sizeof(LateRev::Frame)
+			* LateRev::channels*(LateRev::max_lines/LateRev::lane_group)*(1 + LateRev::Diffuser::max_stages));
+
+		/*
+			Memory on its way between the audio thread and the worker.
+			Whoever takes it out of the slot owns it, the destructor frees
+			whatever a request or response that never arrived left behind
+		*/
+		// grown memory the audio thread has yet to swap in
+		std::atomic<LateRev::Memory*> m_grown_memory = nullptr;
+		// retired memory the worker has been asked to free
+		std::atomic<LateRev::Memory*> m_freed_memory = nullptr;
+
+		// messages sent to the worker
+		struct WorkRequest {
+			enum class Type { grow, free } type;
+			LateRev::BufferSizes sizes;
+		};
+
+		// processes the late delay lines in parallel, nullptr if disabled
+		std::unique_ptr<WorkerPool> m_pool = nullptr;
+		// m_pool while the current call to process uses it
+		WorkerPool* m_active_pool = nullptr;
+
+		// smooths params towards the values of param_ports
+		ParameterSmoother<47> m_smoother{max_block_size};
+
+		// samples the late stage processes at once while spanning blocks
+		static constexpr uint32_t max_span_size = LateRev::parallel_size;
+
+		// scratch buffers for each stage, a block or a span long
+		using StereoBuffer = std::array<Frame, max_span_size>;
+
+		StereoBuffer m_dry_buf = {};
+		StereoBuffer m_predelay_buf = {};
+		StereoBuffer m_early_buf = {};
+		std::array<Frame, max_block_size> m_multitap_buf = {};
+		StereoBuffer m_late_buf = {};
+
+		// peak levels sent to the ui
+		struct Peaks {
+			std::pair<float, float> dry;
+			std::pair<float, float> dry_stage;
+			std::pair<float, float> predelay_stage;
+			std::pair<float, float> early_stage;
+			std::pair<float, float> late_stage;
+			std::pair<float, float> out;
+		};
+
+		// highest levels since they were last sent to the ui
+		Peaks m_peaks = {};
+
 		// send audio data if ui is open
 		bool ui_open = false;
 
+		/*
+			The input and output are collected and sent to the ui
+			ui_update_rate times a second, in atoms of at most
+			ui_chunk_size samples per channel that fill whatever space
+			the notify port has left. Samples that do not fit are sent
+			with the next run, and dropped once the streams are full
+		*/
+		static constexpr float ui_update_rate = 30.f;
+		static constexpr uint32_t ui_chunk_size = 2048;
+		// the spectrum is drawn up to 22 kHz, higher rates are decimated down to this
+		static constexpr float ui_min_rate = 44100.f;
+
+		// samples of the streams are averaged over this many
+		static uint32_t ui_decimation(float rate) noexcept;
+
+		std::array<StreamBuffer, 2> m_ui_streams = {};
+		AudioTap m_audio_tap;
+		// samples since the last snapshot was sent to the ui
+		uint32_t m_ui_elapsed = 0;
+		// the last snapshot did not fit into the notify port
+		bool m_ui_pending = false;
+		// stream the next atom is written for
+		size_t m_ui_next_stream = 0;
+		// left and right samples of the atom being written
+		std::array<std::array<float, ui_chunk_size>, channels> m_ui_chunk = {};
+
+		Profiler m_profiler = {};
+		// samples until the profile is sent to the ui again
+		uint32_t m_profile_countdown = 0;
+
+		/*
+			Once the input has been silent and the stages have stayed below
+			silence_threshold for longer than the longest delay, the blocks
+			are skipped and zeros written until the input is non-zero again
+		*/
+		static constexpr float silence_threshold = 1e-6f; // -120 dBFS
+		bool m_sleeping = false;
+		// samples processed since the instance last made a sound
+		uint64_t m_silent_samples = 0;
+		// longest time a sound can stay inside the stages in samples
+		uint64_t m_silence_hold = 0;
+		// samples the output of the late stage has stayed below silence_threshold for
+		uint64_t m_late_silent_samples = 0;
+
 		static size_t sizeof_peak_data_atom() noexcept;
+		static size_t sizeof_profile_data_atom() noexcept;
+		// minimum, average, 99th percentile and maximum of every stage in microseconds
+		void write_profile_data_atom() noexcept;
 		static size_t sizeof_sample_data_atom(uint32_t n_samples) noexcept;
+		// sends the collected samples that fit, returns whether they all did
+		bool write_sample_data_atoms() noexcept;
+		// moves the collected samples that fit into the tap
+		void write_audio_tap() noexcept;
 		void write_sample_data_atom(
 			int channel,
 			int rate,
@@ -214,11 +435,59 @@ namespace Aether {
 			const float* r_samples
 		) noexcept;
 
-		// Updates param_targets
+		// Processes n samples starting at offset through every stage
+		void process_block(uint32_t offset, uint32_t n, bool track_peaks) noexcept;
+
+		/*
+			Processes n samples starting at offset like consecutive calls
+			to process_block, except that the late stage runs through all
+			of them at once so the pool is only woken once. Only exact
+			while no parameter changes and the late stage is settled
+		*/
+		void process_span(uint32_t offset, uint32_t n, bool track_peaks) noexcept;
+		// whether the current call to process can be processed in spans
+		bool can_span() const noexcept;
+
+		// dry, predelay and early stages of n samples, written to the buffers starting at buf
+		void process_early(uint32_t offset, uint32_t n, uint32_t buf) noexcept;
+		// late stage of the first n samples of m_early_buf
+		void process_late(uint32_t n) noexcept;
+		// mixes the first n samples of the buffers into the output starting at offset
+		void process_mix(uint32_t offset, uint32_t n, bool track_peaks) noexcept;
+
+		/*
+			Returns whether the stage has to be processed, clears it while
+			it is skipped and calls reset when it is needed again. A stage
+			that decays has to be kept running until it has
+		*/
+		template <class ForEachBuffer, class Reset>
+		static bool update_stage(Stage& stage, bool needed, ForEachBuffer&& for_each_buffer, Reset&& reset) noexcept;
+
+		// whether the n input samples starting at offset are all zero
+		bool input_silent(uint32_t offset, uint32_t n) const noexcept;
+		// updates m_sleeping after a block of n samples, starting at buf in the buffers, has been processed
+		void track_silence(uint32_t buf, uint32_t n, bool input_silent) noexcept;
+		// recomputes m_silence_hold from params
+		void update_silence_hold() noexcept;
+
+		// bytes of delay memory an instance takes up
+		static size_t memory_required(float rate, LateRev::BufferSizes late_sizes) noexcept;
+		// late buffer sizes for the given late_delay and late_diffusion_delay in ms
+		static LateRev::BufferSizes late_buffer_sizes(float rate, float delay, float diffusion_delay) noexcept;
+		// asks the worker for larger late buffers if the targets no longer fit
+		void grow_late_memory() noexcept;
+		// copies the late history into m_replacing_memory and swaps it in once it has caught up
+		void replace_late_memory() noexcept;
+		// asks the worker to free m_retired_memory
+		void free_retired_memory() noexcept;
+
+		// Updates the smoothing targets from param_ports
 		void update_parameter_targets() noexcept;
-		// Updates params & params_modified then calls apply_parameters
-		void update_parameters() noexcept;
+		// Advances params by n samples and calls apply_parameters
+		// if any parameter was modified
+		void update_parameters(uint32_t n) noexcept;
 		// Applies changes in params & params_modified to internal state
 		void apply_parameters() noexcept;
 	};
+AETHER_ISA_NAMESPACE_END
 }
@@ -1,36 +1,49 @@
-#include <cfenv>
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstdlib>
 #include <string>
 #include <memory>
+#include <system_error>
 
 // LV2
 #include <lv2/core/lv2.h>
 #include <lv2/urid/urid.h>
 #include <lv2/log/log.h>
 #include <lv2/log/logger.h>
+#include <lv2/worker/worker.h>
 
 #include "aether_dsp.hpp"
+#include "engine.hpp"
+#include "../common/audio_tap.hpp"
+#include "../common/uris.hpp"
+#include "../common/utils.hpp"
 
 #ifdef FORCE_DISABLE_DENORMALS
 	#include "architecture.hpp"
 #endif
 
+// more threads than late delay line groups would have nothing to do
+static constexpr unsigned long max_threads = 5;
+
 // LV2 Functions
 static LV2_Handle instantiate(
 	const LV2_Descriptor*,
 	double rate,
-	const char*,
+	const char* bundle_path,
 	const LV2_Feature* const* features
 ) {
 	LV2_URID_Map* map = nullptr;
 	LV2_Log_Logger logger = {};
+	const LV2_Worker_Schedule* schedule = nullptr;
 
 	for (size_t i = 0; features[i]; ++i) {
 		if (std::string(features[i]->URI) == std::string(LV2_URID__map))
 			map = static_cast<LV2_URID_Map*>(features[i]->data);
 		else if (std::string(features[i]->URI) == std::string(LV2_LOG__log))
 			logger.log = static_cast<LV2_Log_Log*>(features[i]->data);
+		else if (std::string(features[i]->URI) == std::string(LV2_WORKER__schedule))
+			schedule = static_cast<const LV2_Worker_Schedule*>(features[i]->data);
 	}
 
 	lv2_log_logger_set_map(&logger, map);
@@ -40,9 +53,45 @@ static LV2_Handle instantiate(
 		return nullptr;
 	}
 
+	if (const char* forced = std::getenv("AETHER_FORCE_ISA")) {
+		const auto isa = Aether::parse_isa(forced);
+		if (!isa || !Aether::isa_available(*isa))
+			lv2_log_warning(&logger, "Instruction set `%s` is not available", forced);
+	}
+
 	try {
-		auto aether = std::make_unique<Aether::DSP>(static_cast<float>(rate));
+		// the variants are modules in the bundle next to the plugin
+		const Aether::ISA isa = Aether::select_isa();
+		auto aether = Aether::create_engine(isa, static_cast<float>(rate), schedule, bundle_path);
+		if (aether->isa() != isa)
+			lv2_log_warning(&logger, "Failed to load the %s dsp", Aether::isa_name(isa).data());
+		lv2_log_note(&logger, "Using %s dsp", Aether::isa_name(aether->isa()).data());
 		aether->map_uris(map);
+
+		if (!schedule)
+			lv2_log_note(&logger, "No worker available, allocating delay memory for the longest delays");
+		lv2_log_trace(&logger, "Using %zu bytes of delay memory", aether->delay_memory());
+
+		// opt in to processing the late reverb on additional threads
+		if (const char* threads = std::getenv("AETHER_THREADS")) {
+			const auto count = static_cast<uint32_t>(std::min(std::strtoul(threads, nullptr, 10), max_threads));
+			// the threads cannot inherit the priority of the audio thread, which is not known here
+			const char* priority = std::getenv("AETHER_THREAD_PRIORITY");
+			const int fifo_priority = priority ? static_cast<int>(std::strtol(priority, nullptr, 10)) : 0;
+			try {
+				aether->set_threads(count, fifo_priority);
+				if (count)
+					lv2_log_note(&logger, "Processing the late reverb on %u additional threads", count);
+			} catch (const std::system_error& e) {
+				lv2_log_warning(&logger, "Failed to start threads: %s", e.what());
+			}
+		}
+
+	#ifdef LOCK_MEMORY
+		if (!aether->memory_locked())
+			lv2_log_warning(&logger, "Failed to lock delay memory, consider raising RLIMIT_MEMLOCK");
+	#endif
+
 		return static_cast<LV2_Handle>(aether.release());
 	} catch(const std::exception& e) {
 		lv2_log_error(&logger, "Failed to instantiate plugin: %s", e.what());
@@ -51,12 +100,7 @@ static LV2_Handle instantiate(
 }
 
 static void connect_port(LV2_Handle instance, uint32_t port, void* data) {
-	auto aether = static_cast<Aether::DSP*>(instance);
-	constexpr uint32_t misc_port_cnt = sizeof(aether->ports)/sizeof(void*);
-	if (port >= misc_port_cnt)
-		aether->param_ports[port-misc_port_cnt] = reinterpret_cast<const float*>(data);
-	else
-		*(reinterpret_cast<void**>(&aether->ports)+port) = data;
+	static_cast<Aether::Engine*>(instance)->connect_port(port, data);
 }
 
 static void activate(LV2_Handle) {}
@@ -64,30 +108,49 @@ static void activate(LV2_Handle) {}
 static void run(LV2_Handle instance, uint32_t n_samples) {
 
 	#ifdef FORCE_DISABLE_DENORMALS
-		std::fenv_t fe_state;
-		std::feholdexcept(&fe_state);
-
-		disable_denormals();
+		// restores the previous floating point mode when it goes out of scope
+		DenormalGuard denormal_guard;
 	#endif
 
-	static_cast<Aether::DSP*>(instance)->process(n_samples);
-
-	#ifdef FORCE_DISABLE_DENORMALS
-		// restore previous floating point state
-		std::feupdateenv(&fe_state);
-	#endif
+	static_cast<Aether::Engine*>(instance)->process(n_samples);
 }
 
 static void deactivate(LV2_Handle) {}
 
 static void cleanup(LV2_Handle instance) {
-	delete static_cast<Aether::DSP*>(instance);
+	delete static_cast<Aether::Engine*>(instance);
 }
 
-static const void* extension_data(const char*) { return nullptr; }
+static LV2_Worker_Status work(
+	LV2_Handle instance,
+	LV2_Worker_Respond_Function respond,
+	LV2_Worker_Respond_Handle handle,
+	uint32_t size,
+	const void* data
+) {
+	return static_cast<Aether::Engine*>(instance)->work(respond, handle, size, data);
+}
+
+static LV2_Worker_Status work_response(LV2_Handle instance, uint32_t size, const void* body) {
+	return static_cast<Aether::Engine*>(instance)->work_response(size, body);
+}
+
+static Aether::AudioTap* audio_tap(LV2_Handle instance) {
+	return &static_cast<Aether::Engine*>(instance)->audio_tap();
+}
+
+static const void* extension_data(const char* uri) {
+	static const LV2_Worker_Interface worker = {work, work_response, nullptr};
+	static const Aether::AudioTapInterface tap = {audio_tap};
+	if (std::string(uri) == std::string(LV2_WORKER__interface))
+		return &worker;
+	if (std::string(uri) == std::string(join_v<Aether::uri::plugin, Aether::uri::audio_tap>))
+		return &tap;
+	return nullptr;
+}
 
 static const LV2_Descriptor descriptor = {
-	Aether::DSP::URI.data(),
+	Aether::uri::plugin.data(),
 	instantiate,
 	connect_port,
 	activate,
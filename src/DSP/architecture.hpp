@@ -70,31 +70,113 @@
 #endif
 
 
-// misc functions
+// instruction set variants
+
+/*
+	The dsp is compiled once per instruction set it is dispatched to at
+	runtime (see dispatch.cpp). Every variant but the baseline is a module
+	of its own and places its kernels in a namespace named after it, so
+	that they can be told apart when profiling
+*/
+#ifndef AETHER_ISA
+	#define AETHER_ISA baseline
+#endif
 
-#ifdef ARCH_EXT_SSE
+#define AETHER_ISA_NAMESPACE_BEGIN inline namespace AETHER_ISA {
+#define AETHER_ISA_NAMESPACE_END }
 
-	#include <cfenv>
-	#ifndef FE_DFL_DISABLE_SSE_DENORMS_ENV
-		#include <immintrin.h>
-	#endif
 
+// denormals
+
+/*
+	ARCH_FLUSH_DENORMALS is defined where the floating point control
+	register can flush denormals to zero, fp_control() and
+	set_fp_control() read and write that register and fp_flush_bits
+	are the bits that enable flushing
+*/
+#if defined(ARCH_EXT_SSE)
+
+	#include <immintrin.h>
+
+	#define ARCH_FLUSH_DENORMALS
+
+	using FpControl = unsigned int;
+	// flush to zero and denormals are zero
+	inline constexpr FpControl fp_flush_bits = 0x8040;
+
+	inline FpControl fp_control() noexcept { return _mm_getcsr(); }
+	inline void set_fp_control(FpControl control) noexcept { _mm_setcsr(control); }
+
+#elif defined(ARCH_ARM64) && (defined(__GNUC__) || defined(__clang__))
+
+	#include <cstdint>
+
+	#define ARCH_FLUSH_DENORMALS
+
+	using FpControl = uint64_t;
+	inline constexpr FpControl fp_flush_bits = FpControl{1} << 24;
+
+	inline FpControl fp_control() noexcept {
+		FpControl control;
+		asm volatile("mrs %0, fpcr" : "=r"(control));
+		return control;
+	}
+	inline void set_fp_control(FpControl control) noexcept { asm volatile("msr fpcr, %0" : : "r"(control)); }
+
+#elif defined(ARCH_ARM32) && defined(__has_builtin)
+	#if __has_builtin(__builtin_arm_set_fpscr) && __has_builtin(__builtin_arm_get_fpscr)
+
+		#define ARCH_FLUSH_DENORMALS
+
+		using FpControl = unsigned int;
+		inline constexpr FpControl fp_flush_bits = 1u << 24;
+
+		inline FpControl fp_control() noexcept { return __builtin_arm_get_fpscr(); }
+		inline void set_fp_control(FpControl control) noexcept { __builtin_arm_set_fpscr(control); }
+
+	#endif
 #endif
 
+
+// misc functions
+
+// flushes denormals to zero on the calling thread until changed again
 inline void disable_denormals() noexcept {
+	#ifdef ARCH_FLUSH_DENORMALS
+		set_fp_control(fp_control() | fp_flush_bits);
+	#endif
+}
 
-	#if defined(ARCH_EXT_SSE)
-		#ifdef FE_DFL_DISABLE_SSE_DENORMS_ENV
-			std::fesetenv(FE_DFL_DISABLE_SSE_DENORMS_ENV);
-		#else
-			_mm_setcsr(_mm_getcsr() | 0x8040);
+/*
+	Flushes denormals to zero for the lifetime of the guard and then
+	restores the previous mode. The register is only written if the
+	mode has to change, which it usually does not as most hosts already
+	flush denormals
+*/
+class DenormalGuard {
+public:
+	DenormalGuard() noexcept {
+		#ifdef ARCH_FLUSH_DENORMALS
+			m_control = fp_control();
+			if ((m_control & fp_flush_bits) != fp_flush_bits)
+				set_fp_control(m_control | fp_flush_bits);
 		#endif
-	#elif defined(ARCH_ARM)
-		#if __has_builtin(__builtin_arm_set_fpscr) && __has_builtin(__builtin_arm_get_fpscr)
-			__builtin_arm_set_fpscr(__builtin_arm_get_fpscr() | (1 << 24));
+	}
+
+	DenormalGuard(const DenormalGuard&) = delete;
+	DenormalGuard& operator=(const DenormalGuard&) = delete;
+
+	~DenormalGuard() {
+		#ifdef ARCH_FLUSH_DENORMALS
+			if ((m_control & fp_flush_bits) != fp_flush_bits)
+				set_fp_control(m_control);
 		#endif
-	#endif
+	}
 
-}
+private:
+	#ifdef ARCH_FLUSH_DENORMALS
+		FpControl m_control = 0;
+	#endif
+};
 
 #endif
@@ -1,45 +1,97 @@
 #ifndef DELAY_HPP
 #define DELAY_HPP
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
-#include <numeric>
+#include <random>
 
 #include "utils/lfo.hpp"
+#include "utils/fastmath.hpp"
 #include "utils/random.hpp"
 #include "utils/ringbuffer.hpp"
+#include "architecture.hpp"
+
+AETHER_ISA_NAMESPACE_BEGIN
 
 /*
 	A basic tap delay
+
+	Sample is either a single sample or a frame of
+	lanes that share the same delay
 */
-class Delay {
+template <class Sample>
+class BasicDelay {
 public:
-	explicit Delay(float rate) : m_buf{static_cast<size_t>(max_delay*rate)+1} {}
-	Delay(const Delay&) = delete;
+	explicit BasicDelay(float rate, Arena& arena = Arena::heap()) :
+		m_buf{buffer_size(rate), block_size, arena} {}
+	BasicDelay(const BasicDelay&) = delete;
 
-	Delay& operator=(const Delay&) = delete;
+	BasicDelay& operator=(const BasicDelay&) = delete;
 
-	float push(float sample, size_t delay) noexcept {
-		assert(delay < m_buf.size);
+	Sample push(Sample sample, size_t delay) noexcept {
+		assert(delay < m_buf.capacity);
 
 		m_buf.push(sample);
-
-		auto idx = m_buf.end - delay + (m_buf.end < delay ? m_buf.size: 0);
-		return m_buf.buf[idx];
+		return m_buf[delay];
 	}
 
+	/*
+		Processes n samples from in into out with a fixed delay
+		in and out may point to the same buffer
+	*/
+	void process_block(const Sample* in, Sample* out, size_t n, size_t delay) noexcept;
+
 	void clear() noexcept { m_buf.clear(); }
 
+	// calls f(data, bytes) for every piece of delay memory, see IncrementalClear
+	template <class F>
+	void for_each_buffer(F&& f) noexcept { f(m_buf.buf, m_buf.allocated()*sizeof(Sample)); }
+
+	static size_t memory_required(float rate) noexcept {
+		return Ringbuffer<Sample>::memory_required(buffer_size(rate), block_size);
+	}
+
 	// maximum delay in seconds
 	static constexpr float max_delay = 0.5f;
 
 private:
-	Ringbuffer<float> m_buf;
+	// number of samples that are written and read back at a time
+	static constexpr size_t block_size = 64;
+
+	static size_t buffer_size(float rate) noexcept { return static_cast<size_t>(max_delay*rate)+1; }
+
+	Ringbuffer<Sample> m_buf;
 };
 
+template <class Sample>
+inline void BasicDelay<Sample>::process_block(
+	const Sample* in,
+	Sample* out,
+	size_t n,
+	size_t delay
+) noexcept {
+	assert(delay < m_buf.capacity);
+
+	// a block must not overwrite samples that still have to be read
+	const size_t max_len = std::min(block_size, m_buf.capacity - delay);
+	for (size_t offset = 0; offset < n; offset += max_len) {
+		const size_t len = std::min(max_len, n - offset);
+
+		// write the whole block, then read it back delay samples later
+		m_buf.write(in + offset, len);
+		std::copy_n(m_buf.window(delay + len - 1), len, out + offset);
+	}
+}
+
+using Delay = BasicDelay<float>;
+
+template <class FpType, size_t Lanes>
+using DelayBank = BasicDelay<std::array<FpType, Lanes>>;
+
 
 /*
 	A tap delay with a modulated delay length
@@ -55,11 +107,11 @@ public:
 	ModulatedDelay& operator=(const ModulatedDelay&) = delete;
 
 	void set_delay(float delay) noexcept {
-		assert(static_cast<size_t>(m_mod_depth + m_delay) < m_buf.size);
+		assert(static_cast<size_t>(m_mod_depth + m_delay) < m_buf.capacity);
 		m_delay = delay;
 	}
 	void set_mod_depth(float mod_depth) noexcept {
-		assert(static_cast<size_t>(m_mod_depth + m_delay) < m_buf.size);
+		assert(static_cast<size_t>(m_mod_depth + m_delay) < m_buf.capacity);
 		m_mod_depth = mod_depth;
 	}
 	void set_mod_rate(float mod_rate) noexcept { m_lfo.set_rate(mod_rate); }
@@ -75,11 +127,9 @@ public:
 		uint32_t delay_floor = static_cast<uint32_t>(delay);
 		FpType t = static_cast<FpType>(delay - static_cast<float>(delay_floor));
 
-		size_t idx1 = m_buf.end - delay_floor
-			+ (m_buf.end < delay_floor ? m_buf.size : 0);
-		size_t idx2 = idx1 - 1 + (idx1 < 1 ? m_buf.size : 0);
-
-		return m_buf.buf[idx1] + t*(m_buf.buf[idx2]-m_buf.buf[idx1]);
+		FpType a = m_buf[delay_floor];
+		FpType b = m_buf[delay_floor+1];
+		return a + t*(b-a);
 	}
 
 	// maximum in seconds
@@ -96,105 +146,367 @@ private:
 
 
 /*
-	A single delaybuffer with multiple delay taps
+	Lanes modulated tap delays processed side by side
+
+	The samples of every lane are stored interleaved in a single
+	ringbuffer so that all lanes can be written at once
 */
-class MultitapDelay {
+template <class FpType, size_t Lanes>
+class ModulatedDelayBank {
 public:
+	using Frame = std::array<FpType, Lanes>;
+
+	template <class RNG>
+	ModulatedDelayBank(float sample_rate, RNG& rng, Arena& arena = Arena::heap()) :
+		ModulatedDelayBank(rng, buffer_size(sample_rate), arena) {}
+
+	// holds delays plus modulation depths of up to size-1 samples
+	template <class RNG>
+	ModulatedDelayBank(RNG& rng, size_t size, Arena& arena) :
+		m_buf{size, 1, arena}
+	{
+		std::uniform_real_distribution<float> dist(0.f, 1.f);
+		for (size_t lane = 0; lane < Lanes; ++lane)
+			m_lfo.set_phase(lane, dist(rng));
+	}
+	ModulatedDelayBank(const ModulatedDelayBank&) = delete;
 
-	MultitapDelay(float rate);
-	MultitapDelay(const MultitapDelay&) = delete;
+	ModulatedDelayBank& operator=(const ModulatedDelayBank&) = delete;
 
-	MultitapDelay& operator=(const MultitapDelay&) = delete;
+	void set_delay(size_t lane, float delay) noexcept {
+		assert(static_cast<size_t>(m_mod_depth[lane] + delay) < m_buf.capacity);
+		m_delay[lane] = delay;
+	}
+	void set_mod_depth(size_t lane, float mod_depth) noexcept {
+		assert(static_cast<size_t>(mod_depth + m_delay[lane]) < m_buf.capacity);
+		m_mod_depth[lane] = mod_depth;
+	}
+	void set_mod_rate(size_t lane, float mod_rate) noexcept { m_lfo.set_rate(lane, mod_rate); }
+
+	void clear() noexcept { m_buf.clear(); }
+	void clear(size_t lane) noexcept {
+		for (size_t i = 0; i < m_buf.allocated(); ++i)
+			m_buf.buf[i][lane] = 0;
+	}
+
+	// processes one sample of every lane inplace
+	void push(Frame& samples) noexcept {
+		m_buf.push(samples);
+
+		std::array<float, Lanes> delay;
+		for (size_t lane = 0; lane < Lanes; ++lane)
+			delay[lane] = std::max(m_delay[lane] + m_mod_depth[lane]*m_lfo.depth(lane), 0.f);
+
+		read_lanes(m_buf, delay, true, samples);
+		m_lfo.next();
+	}
+
+	/*
+		Swaps in buf, which has to hold the history of the current buffer
+		already, see IncrementalCopy. buf receives the previous buffer in return
+	*/
+	void replace_buffer(Ringbuffer<Frame>& buf) noexcept { m_buf.swap(buf); }
+
+	const Ringbuffer<Frame>& buffer() const noexcept { return m_buf; }
+
+	size_t capacity() const noexcept { return m_buf.capacity; }
+
+	// calls f(data, bytes) for every piece of delay memory, see IncrementalClear
+	template <class F>
+	void for_each_buffer(F&& f) noexcept { f(m_buf.buf, m_buf.allocated()*sizeof(Frame)); }
+
+	static size_t memory_required(float sample_rate) noexcept {
+		return Ringbuffer<Frame>::memory_required(buffer_size(sample_rate));
+	}
+
+	// maximum in seconds
+	static constexpr float max_delay = ModulatedDelay<FpType>::max_delay;
+	static constexpr float max_mod = ModulatedDelay<FpType>::max_mod;
+
+private:
+	Ringbuffer<Frame> m_buf;
+	LFOBank<Lanes> m_lfo = {};
+
+	std::array<float, Lanes> m_delay = {};
+	std::array<float, Lanes> m_mod_depth = {};
+
+	static size_t buffer_size(float sample_rate) noexcept {
+		return static_cast<size_t>( (max_delay+max_mod) * sample_rate ) + 1;
+	}
+};
+
+
+/*
+	Lanes multitap delays processed side by side
+
+	All lanes share the number of taps, the length and the decay
+	while the tap positions and gains depend on the seed and
+	crossmix of each lane
+
+	The integer tap offsets are cached until the taps, the length or
+	the seed change, and a block of outputs is evaluated as a sparse
+	FIR over a contiguous history of each lane
+*/
+template <size_t Lanes>
+class MultitapDelayBank {
+public:
+	using Frame = std::array<float, Lanes>;
+
+	explicit MultitapDelayBank(float rate, Arena& arena = Arena::heap());
+	MultitapDelayBank(const MultitapDelayBank&) = delete;
+	~MultitapDelayBank() { m_arena.deallocate(m_buf, Lanes*m_capacity); }
+
+	MultitapDelayBank& operator=(const MultitapDelayBank&) = delete;
+
+	// per lane parameters, applied lazily by push and process_block
+	void set_seed(size_t lane, uint32_t seed) noexcept { m_rand[lane].set_seed(seed); }
+	void set_seed_crossmix(size_t lane, float crossmix) noexcept { m_rand[lane].set_crossmix(crossmix); }
 
-	void set_seed(uint32_t seed) noexcept;
-	void set_seed_crossmix(float crossmix) noexcept;
+	// shared parameters
 	void set_decay(float decay) noexcept;
 
-	float push(float sample, uint32_t taps, float length);
+	// processes one sample of every lane inplace
+	void push(Frame& samples, uint32_t taps, float length) noexcept {
+		process_block(&samples, &samples, 1, taps, length);
+	}
 
-	void clear() noexcept { m_buf.clear(); }
+	/*
+		Processes n frames from in into out
+		in and out may point to the same buffer
+	*/
+	void process_block(const Frame* in, Frame* out, size_t n, uint32_t taps, float length) noexcept;
+
+	void clear() noexcept;
+
+	// calls f(data, bytes) for every piece of delay memory, see IncrementalClear
+	template <class F>
+	void for_each_buffer(F&& f) noexcept { f(m_buf, Lanes*m_capacity*sizeof(float)); }
+
+	static size_t memory_required(float rate) noexcept {
+		return Arena::size_of<float>(Lanes*capacity_for(history_for(rate)));
+	}
 
 	static constexpr uint32_t max_taps = 50;
 	static constexpr float max_length = 0.5f;
 private:
-	Ringbuffer<float> m_buf;
+	static constexpr uint32_t block_size = 64;
+
+	/*
+		Each lane owns m_capacity samples of m_buf. The m_history samples
+		before m_pos are always valid, and once a block no longer fits they
+		are moved back to the start, so reads never have to wrap around
+	*/
+	uint32_t m_history;
+	uint32_t m_capacity;
+	uint32_t m_pos;
+	Arena& m_arena;
+	float* m_buf;
+
+	static uint32_t history_for(float rate) noexcept { return static_cast<uint32_t>(max_length*rate) + 1; }
+	static uint32_t capacity_for(uint32_t history) noexcept { return 2*history + block_size; }
+
+	std::array<Frame, max_taps> m_tap_gain = {};
+	std::array<Frame, max_taps> m_tap_delay = {};
 
-	std::array<float, max_taps> m_tap_gain = {};
-	std::array<float, max_taps> m_tap_delay = {};
+	// m_tap_delay scaled to the current length, in samples
+	std::array<std::array<uint32_t, max_taps>, Lanes> m_tap_offset = {};
+	uint32_t m_offset_taps = 0;
+	float m_offset_length = 0.f;
+	bool m_offsets_valid = false;
 
-	std::array<float, 2*max_taps> m_rand_vals = {};
+	std::array<Random::CrossmixedSequence<2*max_taps>, Lanes> m_rand = {};
 
 	float m_decay = 0.5f;
-	uint32_t m_seed = 0;
-	float m_crossmix = 0.5f;
 
-	void generate_tap_delays() noexcept;
-	void generate_tap_gains() noexcept;
+	// regenerates the taps of lanes with pending seed changes
+	void update_seeds(uint32_t n) noexcept {
+		for (size_t lane = 0; lane < Lanes; ++lane) {
+			if (m_rand[lane].update(n)) {
+				generate_tap_delays(lane);
+				generate_tap_gains(lane);
+				m_offsets_valid = false;
+			}
+		}
+	}
+
+	void update_offsets(uint32_t taps, float length) noexcept;
+
+	void generate_tap_delays(size_t lane) noexcept;
+	void generate_tap_gains(size_t lane) noexcept;
+
+	float* history(size_t lane) noexcept { return m_buf + lane*m_capacity; }
+
+	// adjusts the loudness depending on the number of taps
+	static float loudness_adjust(uint32_t taps) noexcept {
+		return 0.35f+0.21f*max_taps/static_cast<float>(20+taps);
+	}
 };
 
 
-inline MultitapDelay::MultitapDelay(float rate) :
-	m_buf{static_cast<size_t>(max_length*rate) + 1}
+template <size_t Lanes>
+inline MultitapDelayBank<Lanes>::MultitapDelayBank(float rate, Arena& arena) :
+	m_history{history_for(rate)},
+	m_capacity{capacity_for(m_history)},
+	m_pos{m_history},
+	m_arena{arena},
+	m_buf{arena.allocate<float>(Lanes*m_capacity)}
 {
-	Random::generate(m_rand_vals, m_seed, m_crossmix);
-	generate_tap_delays();
-	generate_tap_gains();
+	clear();
+
+	for (auto& rand : m_rand)
+		rand.set_crossmix(0.5f);
+	update_seeds(0);
 }
 
-inline float MultitapDelay::push(float sample, uint32_t taps, float length) {
-	assert(static_cast<size_t>(length) < m_buf.size);
+template <size_t Lanes>
+inline void MultitapDelayBank<Lanes>::process_block(
+	const Frame* in,
+	Frame* out,
+	size_t n,
+	uint32_t taps,
+	float length
+) noexcept {
+	assert(static_cast<uint32_t>(length) < m_history);
 	assert(taps <= max_taps);
 
-	m_buf.push(sample);
-
-	const float delay_coef = length/m_tap_delay[taps-1];
-	float output = 0.f;
-	for (uint32_t i = 0; i < taps; ++i) {
-		uint32_t delay = static_cast<uint32_t>(m_tap_delay[i]*delay_coef);
-		size_t idx = m_buf.end - delay + (m_buf.end < delay ? m_buf.size : 0);
-		output += m_tap_gain[i]*m_buf.buf[idx];
+	update_seeds(static_cast<uint32_t>(n));
+	update_offsets(taps, length);
+
+	const float adjust = loudness_adjust(taps);
+	for (size_t offset = 0; offset < n; offset += block_size) {
+		const auto len = static_cast<uint32_t>(std::min<size_t>(block_size, n - offset));
+
+		if (m_pos + len > m_capacity) {
+			for (size_t lane = 0; lane < Lanes; ++lane) {
+				float* hist = history(lane);
+				std::copy(hist + (m_pos - m_history), hist + m_pos, hist);
+			}
+			m_pos = m_history;
+		}
+
+		// the whole block is written first so that in and out may alias
+		for (size_t lane = 0; lane < Lanes; ++lane) {
+			float* hist = history(lane) + m_pos;
+			for (uint32_t i = 0; i < len; ++i)
+				hist[i] = in[offset+i][lane];
+		}
+
+		for (size_t lane = 0; lane < Lanes; ++lane) {
+			const float* hist = history(lane) + m_pos;
+
+			std::array<float, block_size> output = {};
+			for (uint32_t tap = 0; tap < taps; ++tap) {
+				const float gain = m_tap_gain[tap][lane];
+				const float* src = hist - m_tap_offset[lane][tap];
+				for (uint32_t i = 0; i < len; ++i)
+					output[i] += gain*src[i];
+			}
+
+			for (uint32_t i = 0; i < len; ++i)
+				out[offset+i][lane] = output[i]*adjust;
+		}
+
+		m_pos += len;
 	}
-
-	// adjust the loudness depending on the number of taps
-	const float adjust = 0.35f+0.21f*max_taps/static_cast<float>(20+taps);
-	return output*adjust;
 }
 
-inline void MultitapDelay::set_seed(uint32_t seed) noexcept {
-	m_seed = seed;
-
-	Random::generate(m_rand_vals, m_seed, m_crossmix);
-	generate_tap_delays();
-	generate_tap_gains();
+template <size_t Lanes>
+inline void MultitapDelayBank<Lanes>::clear() noexcept {
+	std::fill_n(m_buf, Lanes*m_capacity, 0.f);
+	m_pos = m_history;
 }
 
-inline void MultitapDelay::set_seed_crossmix(float crossmix) noexcept {
-	m_crossmix = crossmix;
+template <size_t Lanes>
+inline void MultitapDelayBank<Lanes>::update_offsets(uint32_t taps, float length) noexcept {
+	if (m_offsets_valid && taps == m_offset_taps && length == m_offset_length)
+		return;
 
-	Random::generate(m_rand_vals, m_seed, m_crossmix);
-	generate_tap_delays();
-	generate_tap_gains();
+	for (size_t lane = 0; lane < Lanes; ++lane) {
+		const float delay_coef = length/m_tap_delay[taps-1][lane];
+		for (uint32_t tap = 0; tap < taps; ++tap)
+			m_tap_offset[lane][tap] = static_cast<uint32_t>(m_tap_delay[tap][lane]*delay_coef);
+	}
+
+	m_offset_taps = taps;
+	m_offset_length = length;
+	m_offsets_valid = true;
 }
 
-inline void MultitapDelay::set_decay(float decay) noexcept {
+template <size_t Lanes>
+inline void MultitapDelayBank<Lanes>::set_decay(float decay) noexcept {
 	m_decay = decay;
 
-	generate_tap_gains();
+	for (size_t lane = 0; lane < Lanes; ++lane)
+		generate_tap_gains(lane);
 }
 
 
-inline void MultitapDelay::generate_tap_delays() noexcept {
-	std::partial_sum(
-		m_rand_vals.begin(), m_rand_vals.begin()+max_taps,
-		m_tap_delay.begin()
-	);
+template <size_t Lanes>
+inline void MultitapDelayBank<Lanes>::generate_tap_delays(size_t lane) noexcept {
+	float delay = 0.f;
+	for (size_t tap = 0; tap < max_taps; ++tap) {
+		delay += m_rand[lane][tap];
+		m_tap_delay[tap][lane] = delay;
+	}
 }
 
-inline void MultitapDelay::generate_tap_gains() noexcept {
-	for (size_t tap = 0; tap < m_tap_gain.size(); ++tap) {
-		float gain = std::exp(-4.f*m_decay*m_tap_delay[tap] / (m_tap_delay.back()+1.f));
-		m_tap_gain[tap] = gain*m_rand_vals[max_taps+tap];
+template <size_t Lanes>
+inline void MultitapDelayBank<Lanes>::generate_tap_gains(size_t lane) noexcept {
+	const float total_delay = m_tap_delay[max_taps-1][lane];
+	for (size_t tap = 0; tap < max_taps; ++tap) {
+		float gain = fastmath::exp(-4.f*m_decay*m_tap_delay[tap][lane] / (total_delay+1.f));
+		m_tap_gain[tap][lane] = gain*m_rand[lane][max_taps+tap];
 	}
 }
 
+
+
+/*
+	A single delaybuffer with multiple delay taps
+*/
+class MultitapDelay {
+	using Bank = MultitapDelayBank<1>;
+public:
+	explicit MultitapDelay(float rate) : m_bank(rate) {}
+	MultitapDelay(const MultitapDelay&) = delete;
+
+	MultitapDelay& operator=(const MultitapDelay&) = delete;
+
+	void set_seed(uint32_t seed) noexcept { m_bank.set_seed(0, seed); }
+	void set_seed_crossmix(float crossmix) noexcept { m_bank.set_seed_crossmix(0, crossmix); }
+	void set_decay(float decay) noexcept { m_bank.set_decay(decay); }
+
+	float push(float sample, uint32_t taps, float length) noexcept {
+		Bank::Frame frame = {sample};
+		m_bank.push(frame, taps, length);
+		return frame[0];
+	}
+
+	void process_block(const float* in, float* out, size_t n, uint32_t taps, float length) noexcept {
+		for (size_t offset = 0; offset < n; offset += chunk_size) {
+			const size_t len = std::min(chunk_size, n - offset);
+
+			std::array<Bank::Frame, chunk_size> frames;
+			for (size_t i = 0; i < len; ++i)
+				frames[i][0] = in[offset+i];
+
+			m_bank.process_block(frames.data(), frames.data(), len, taps, length);
+
+			for (size_t i = 0; i < len; ++i)
+				out[offset+i] = frames[i][0];
+		}
+	}
+
+	void clear() noexcept { m_bank.clear(); }
+
+	static constexpr uint32_t max_taps = Bank::max_taps;
+	static constexpr float max_length = Bank::max_length;
+private:
+	static constexpr size_t chunk_size = 64;
+
+	Bank m_bank;
+};
+
+AETHER_ISA_NAMESPACE_END
+
 #endif
@@ -1,231 +1,570 @@
 #ifndef DELAYLINE_HPP
 #define DELAYLINE_HPP
 
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <cmath>
+#include <cstddef>
 #include <cstdint>
-#include <random>
+#include <memory>
+#include <type_traits>
+#include <utility>
 
 #include "delay.hpp"
 #include "diffuser.hpp"
 #include "filters.hpp"
 
+#include "utils/denormals.hpp"
+#include "utils/fastmath.hpp"
+#include "utils/incremental_copy.hpp"
 #include "utils/random.hpp"
+#include "utils/worker_pool.hpp"
 
 #include "../common/constants.hpp"
+#include "architecture.hpp"
 
-class Delayline {
-public:
-	enum class Order { pre = 0, post = 1 };
+AETHER_ISA_NAMESPACE_BEGIN
 
-	struct Filters {
-		struct PushInfo {
-			bool ls_enable;
-			bool hs_enable;
-			bool hc_enable;
-		};
+/*
+	Stereo late reverberations consisting of up to 12 feedback delay lines
+	per channel, each made of a damping filter, a modulated delay and an
+	allpass diffuser
 
-		Filters(double rate) : ls(rate), hs(rate), hc(rate) {}
+	The delay lines are stored as a structure of arrays in groups of
+	lane_group lines. Each stage processes a whole group at once, so that
+	the lines of a group map onto simd lanes, and unused groups are skipped.
 
-		double push(double sample, PushInfo info) noexcept {
-			if (info.ls_enable) sample = ls.push(sample);
-			if (info.hs_enable) sample = hs.push(sample);
-			if (info.hc_enable) sample = hc.push(sample);
-			return sample;
-		}
+	Both channels share every parameter except for the seed crossmix
 
-		void clear() {
-			ls.clear();
-			hs.clear();
-			hc.clear();
-		}
+	The delay memory may be sized for shorter delays than the maximum,
+	longer delays are then shortened until step_replace_memory swaps in
+	larger buffers
+*/
+class LateRev {
+public:
+	static constexpr uint32_t max_lines = 12;
+	static constexpr uint32_t lane_group = 4;
+	static_assert(max_lines % lane_group == 0);
+
+	// channel 0 is left and channel 1 is right
+	static constexpr uint32_t channels = 2;
+
+	using Frame = std::array<double, lane_group>;
+	using StereoFrame = std::array<float, channels>;
+	using Diffuser = AllpassDiffuserBank<double, lane_group>;
+
+	enum class Order { pre = 0, post = 1 };
 
-		Lowshelf<double> ls;
-		Highshelf<double> hs;
-		Lowpass6dB<double> hc;
+	struct DampingInfo {
+		bool ls_enable;
+		bool hs_enable;
+		bool hc_enable;
 	};
 
 	struct PushInfo {
 		Order order;
-		AllpassDiffuser<double>::PushInfo diffuser_info;
-		Filters::PushInfo damping_info;
+		Diffuser::PushInfo diffuser_info;
+		DampingInfo damping_info;
 	};
 
-	ModulatedDelay<double> delay;
-	AllpassDiffuser<double> diffuser;
-	Filters damping;
+	// buffer sizes of every delay line and diffuser stage
+	struct BufferSizes {
+		size_t delay;
+		size_t diffusion;
+	};
+
+	/*
+		Delay memory of every line group in an arena of its own,
+		allocated off the audio thread and swapped in by step_replace_memory
+	*/
+	struct Memory {
+		explicit Memory(BufferSizes sizes);
 
-	// Member Functions
+		// see Ringbuffer::detach
+		void detach() noexcept;
+
+		// has to outlive the buffers
+		std::unique_ptr<Arena> arena;
+		std::array<std::array<Ringbuffer<Frame>, max_lines/lane_group>, channels> delays = {};
+		std::array<std::array<Diffuser::Buffers, max_lines/lane_group>, channels> diffusers = {};
+	};
 
 	template <class RNG>
-	Delayline(float rate, RNG& rng) :
-		delay(rate, std::uniform_real_distribution<float>{0.f, 1.f}(rng) ),
-		diffuser(rate, rng),
-		damping(static_cast<double>(rate))
-	{}
-
-	void set_feedback(float feedback) { m_feedback = static_cast<double>(feedback); }
-
-	double push(double sample, PushInfo info) {
-		m_last_out = damping.push(m_last_out, info.damping_info);
-
-		sample += m_last_out*m_feedback;
-
-		assert(info.order == Order::pre || info.order == Order::post);
-		switch(info.order) {
-			case Order::pre:
-				sample = delay.push(sample);
-				m_last_out = diffuser.push(sample, info.diffuser_info);
-				break;
-			case Order::post:
-				sample = diffuser.push(sample, info.diffuser_info);
-				m_last_out = delay.push(sample);
-				break;
-		}
+	LateRev(float rate, RNG& rng, Arena& arena = Arena::heap()) :
+		LateRev(rate, rng, max_buffer_sizes(rate), arena) {}
 
-		return sample;
+	template <class RNG>
+	LateRev(float rate, RNG& rng, BufferSizes sizes, Arena& arena) : m_groups{{
+		{LineGroup(rate, rng, sizes, arena), LineGroup(rate, rng, sizes, arena), LineGroup(rate, rng, sizes, arena)},
+		{LineGroup(rate, rng, sizes, arena), LineGroup(rate, rng, sizes, arena), LineGroup(rate, rng, sizes, arena)}
+	}}, m_rate{static_cast<double>(rate)} {
+		m_damping = damping_coefs();
+		m_delay_limit = delay_limit();
 	}
+	LateRev(const LateRev&) = delete;
 
-	void clear() noexcept {
-		m_last_out = 0;
-		delay.clear();
-		diffuser.clear();
-		damping.clear();
+	LateRev& operator=(const LateRev&) = delete;
+
+	// buffer sizes for a delay and diffusion delay in samples
+	static BufferSizes buffer_sizes(float rate, float delay, float diffusion_delay) noexcept {
+		return {
+			// the longest line is 1.5 times the delay
+			static_cast<size_t>(1.5f*delay + ModulatedDelay<double>::max_mod*rate) + 2,
+			Diffuser::buffer_size(rate, diffusion_delay)
+		};
 	}
 
-private:
-	double m_last_out = 0;
+	static BufferSizes max_buffer_sizes(float rate) noexcept {
+		return buffer_sizes(rate, max_delay*rate, Diffuser::delay_bounds.second*rate);
+	}
 
-	double m_feedback = 0;
-};
+	static size_t memory_required(float rate) noexcept {
+		return memory_required(max_buffer_sizes(rate));
+	}
 
+	static size_t memory_required(BufferSizes sizes) noexcept {
+		return channels*(max_lines/lane_group)*LineGroup::memory_required(sizes);
+	}
 
-class LateRev {
-public:
-	template <class RNG>
-	LateRev(float rate, RNG& rng) : m_delay_lines{
-		Delayline(rate, rng), Delayline(rate, rng), Delayline(rate, rng),
-		Delayline(rate, rng), Delayline(rate, rng), Delayline(rate, rng),
-		Delayline(rate, rng), Delayline(rate, rng), Delayline(rate, rng),
-		Delayline(rate, rng), Delayline(rate, rng), Delayline(rate, rng)
-	} {}
+	// capacity of the current buffers
+	BufferSizes buffer_capacity() const noexcept {
+		const LineGroup& group = m_groups[0][0];
+		return {group.delay.capacity(), group.diffuser.capacity()};
+	}
 
-	// General
-	void set_seed_crossmix(float crossmix) {
-		m_crossmix = crossmix;
+	// calls f(data, bytes) for every piece of delay memory, see IncrementalClear
+	template <class F>
+	void for_each_buffer(F&& f) noexcept {
+		for (auto& groups : m_groups) {
+			for (auto& group : groups) {
+				group.delay.for_each_buffer(f);
+				group.diffuser.for_each_buffer(f);
+			}
+		}
+	}
 
-		Random::generate(m_rand, m_delay_seed, m_crossmix);
-		generate_delay();
-		generate_mod_depth();
-		generate_mod_rate();
+	// clears everything but the delay memory
+	void clear_state() noexcept {
+		for (auto& groups : m_groups) {
+			for (auto& group : groups) {
+				group.last_out = {};
+				group.damping.clear();
+			}
+		}
+	}
 
-		for (auto& line : m_delay_lines)
-			line.diffuser.set_seed_crossmix(crossmix);
+	// bytes of delay memory swapped in by step_replace_memory
+	size_t replaced_memory() const noexcept { return m_arena ? m_arena->capacity() : 0; }
+
+	/*
+		Starts moving the history of every delay line into memory, which
+		has to be at least as large. The lines keep running on the current
+		buffers until step_replace_memory has copied all of it
+	*/
+	void start_replace_memory(Memory& memory) noexcept {
+		m_replacement = &memory;
+		for_each_replacement([](IncrementalCopy<Frame>& copy, const Ringbuffer<Frame>& buf, Ringbuffer<Frame>&) {
+			copy.start(buf);
+		});
+	}
+
+	bool replacing_memory() const noexcept { return m_replacement != nullptr; }
+
+	/*
+		Copies up to budget bytes of the history into the memory passed to
+		start_replace_memory and swaps it in once all of it has been copied,
+		or right away without the rest if keep_history is false. Returns
+		whether it has been swapped in, the memory then holds the previous
+		buffers, which can be freed off the audio thread, also after the
+		arena passed to the constructor is gone
+
+		Every line may process fewer samples than its buffers hold between calls
+	*/
+	bool step_replace_memory(size_t budget, bool keep_history = true) noexcept {
+		if (!m_replacement) return false;
+
+		// the buffers that have been copied already only catch up on what was written since
+		size_t frames = budget/sizeof(Frame);
+		bool copied = true;
+		for_each_replacement([&](IncrementalCopy<Frame>& copy, const Ringbuffer<Frame>& buf, Ringbuffer<Frame>& replacement) {
+			copy.update(buf);
+			if (keep_history)
+				frames -= copy.step(buf, replacement, frames);
+			copied = copied && copy.pending() == 0;
+		});
+		if (keep_history && !copied) return false;
+
+		for_each_replacement([](IncrementalCopy<Frame>& copy, const Ringbuffer<Frame>&, Ringbuffer<Frame>& replacement) {
+			copy.finish(replacement);
+		});
+
+		Memory& memory = *std::exchange(m_replacement, nullptr);
+		for (uint32_t channel = 0; channel < channels; ++channel) {
+			for (uint32_t group = 0; group < group_count; ++group) {
+				m_groups[channel][group].delay.replace_buffer(memory.delays[channel][group]);
+				m_groups[channel][group].diffuser.replace_buffers(memory.diffusers[channel][group]);
+			}
+		}
+		std::swap(m_arena, memory.arena);
+		// the initial buffers came from the arena passed to the constructor,
+		// which memory may outlive
+		if (!memory.arena)
+			memory.detach();
+
+		m_delay_limit = delay_limit();
+		for (uint32_t channel = 0; channel < channels; ++channel) {
+			generate_delay(channel);
+			generate_feedback(channel);
+		}
+		return true;
+	}
+
+	// General
+	// seed changes are applied lazily by process_block
+	void set_seed_crossmix(uint32_t channel, float crossmix) {
+		m_rand[channel].set_crossmix(crossmix);
+		for (auto& group : m_groups[channel])
+			for (uint32_t lane = 0; lane < lane_group; ++lane)
+				group.diffuser.set_seed_crossmix(lane, crossmix);
 	}
 
 	void set_delay_lines(uint32_t lines) {
-		if (m_lines < lines)
-			for (uint32_t i = m_lines; i < lines; ++i)
-				m_delay_lines[i].clear();
+		for (uint32_t channel = 0; channel < channels; ++channel) {
+			for (uint32_t i = m_lines; i < lines; ++i) {
+				m_groups[channel][i/lane_group].clear(i%lane_group);
+				// the history copied so far is stale as well
+				if (m_replacement)
+					clear_replacement(channel, i);
+			}
+		}
 		m_lines = lines;
 		m_gain_target = 0.3f+0.3f*max_lines/static_cast<float>(7+m_lines);
 	}
 
 	// delay line
 	void set_delay(float delay) {
-		m_gain_smoothing = std::exp(-2*constants::pi_v<float> / delay);
+		m_gain_smoothing = fastmath::exp(-2*constants::pi_v<float> / delay);
 		m_delay = delay;
-		generate_delay();
+		for (uint32_t channel = 0; channel < channels; ++channel) {
+			generate_delay(channel);
+			// lines shortened to the buffers are affected
+			generate_feedback(channel);
+		}
 	}
 
 	void set_delay_mod_depth(float mod_depth) {
 		m_mod_depth = mod_depth;
-		generate_mod_depth();
+		for (uint32_t channel = 0; channel < channels; ++channel)
+			generate_mod_depth(channel);
 	}
 	void set_delay_mod_rate(float mod_rate) {
 		m_mod_rate = mod_rate;
-		generate_mod_rate();
+		for (uint32_t channel = 0; channel < channels; ++channel)
+			generate_mod_rate(channel);
 	}
 	void set_delay_feedback(float feedback) {
 		m_feedback = feedback;
-		generate_feedback();
+		for (uint32_t channel = 0; channel < channels; ++channel)
+			generate_feedback(channel);
 	}
 	void set_delay_seed(uint32_t seed) {
-		m_delay_seed = seed;
-
-		Random::generate(m_rand, m_delay_seed, m_crossmix);
-		generate_delay();
-		generate_mod_depth();
-		generate_mod_rate();
+		for (auto& rand : m_rand)
+			rand.set_seed(seed);
 	}
 
 	// diffusion
 	void set_diffusion_drive(float drive) {
-		for (auto& line : m_delay_lines)
-			line.diffuser.set_drive(drive);
+		for (auto& groups : m_groups)
+			for (auto& group : groups)
+				group.diffuser.set_drive(drive);
 	}
 	void set_diffusion_delay(float delay) {
-		for (auto& line : m_delay_lines)
-			line.diffuser.set_delay(delay);
+		for (auto& groups : m_groups)
+			for (auto& group : groups)
+				group.diffuser.set_delay(delay);
 	}
 	void set_diffusion_mod_depth(float mod_depth) {
-		for (auto& line : m_delay_lines)
-			line.diffuser.set_mod_depth(mod_depth);
+		for (auto& groups : m_groups)
+			for (auto& group : groups)
+				group.diffuser.set_mod_depth(mod_depth);
 	}
 	void set_diffusion_mod_rate(float mod_rate) {
-		for (auto& line : m_delay_lines)
-			line.diffuser.set_mod_rate(mod_rate);
+		for (auto& groups : m_groups)
+			for (auto& group : groups)
+				group.diffuser.set_mod_rate(mod_rate);
 	}
 	void set_diffusion_seed(uint32_t seed) {
-		uint32_t i = 1;
-		for (auto& line : m_delay_lines)
-			line.diffuser.set_seed(seed*i++);
+		for (auto& groups : m_groups)
+			for (uint32_t line = 0; line < max_lines; ++line)
+				groups[line/lane_group].diffuser.set_seed(line%lane_group, seed*(line+1));
 	}
 
 	// Filter
+	// the coefficients are recomputed once by the next process_block
 	void set_low_shelf_cutoff(float cutoff) {
-		for (auto& line : m_delay_lines)
-			line.damping.ls.set_cutoff(static_cast<double>(cutoff));
+		m_ls_cutoff = static_cast<double>(cutoff);
+		m_damping_modified = true;
 	}
 	void set_low_shelf_gain(float gain) {
-		for (auto& line : m_delay_lines)
-			line.damping.ls.set_gain(static_cast<double>(gain));
+		m_ls_gain = static_cast<double>(gain);
+		m_damping_modified = true;
 	}
 	void set_high_shelf_cutoff(float cutoff) {
-		for (auto& line : m_delay_lines)
-			line.damping.hs.set_cutoff(static_cast<double>(cutoff));
+		m_hs_cutoff = static_cast<double>(cutoff);
+		m_damping_modified = true;
 	}
 	void set_high_shelf_gain(float gain) {
-		for (auto& line : m_delay_lines)
-			line.damping.hs.set_gain(static_cast<double>(gain));
+		m_hs_gain = static_cast<double>(gain);
+		m_damping_modified = true;
 	}
 	void set_high_cut_cutoff(float cutoff) {
-		for (auto& line : m_delay_lines)
-			line.damping.hc.set_cutoff(static_cast<double>(cutoff));
+		m_hc_cutoff = static_cast<double>(cutoff);
+		m_damping_modified = true;
 	}
 
-
-	float push(
-		float sample,
-		Delayline::PushInfo push_info
+	/*
+		Processes n stereo frames one group of delay lines at a time
+		in and out may point to the same buffer
+
+		With a pool the groups of both channels are processed in
+		parallel, every group running through up to parallel_size frames
+		as one task, the output is the same as without one. The pool is
+		only used once set_parallel has allocated what the tasks need
+
+		Damping changes are interpolated over the n frames
+	*/
+	void process_block(
+		const StereoFrame* in,
+		StereoFrame* out,
+		size_t n,
+		PushInfo push_info,
+		WorkerPool* pool = nullptr
 	) noexcept {
-		double output = 0;
-		for (uint32_t i = 0; i < m_lines; ++i)
-			output += m_delay_lines[i].push(static_cast<double>(sample), push_info);
+		for (uint32_t channel = 0; channel < channels; ++channel) {
+			if (m_rand[channel].update(static_cast<uint32_t>(n))) {
+				generate_delay(channel);
+				generate_mod_depth(channel);
+				generate_mod_rate(channel);
+				generate_feedback(channel);
+			}
+		}
 
-		m_gain = m_gain - m_gain_smoothing*(m_gain-m_gain_target);
-		return m_gain*static_cast<float>(output);
+		const DampingCoefs damping_target = m_damping_modified ? damping_coefs() : m_damping;
+		const bool interpolate_damping = m_damping_modified;
+		m_damping_modified = false;
+
+		const Block block{in, n, push_info, damping_target, interpolate_damping};
+		if (pool && m_group_output) {
+			for (size_t offset = 0; offset < n; offset += parallel_size)
+				process_parallel(*pool, block, offset, std::min(parallel_size, n - offset), out);
+		} else {
+			for (size_t offset = 0; offset < n; offset += chunk_size) {
+				const size_t len = std::min(chunk_size, n - offset);
+
+				std::array<std::array<double, chunk_size>, channels> output = {};
+				for (uint32_t channel = 0; channel < channels; ++channel) {
+					for (uint32_t group = 0; group < active_groups(); ++group) {
+						std::array<double, chunk_size> group_output;
+						process_group(block, channel, group, offset, len, group_output.data());
+						for (size_t i = 0; i < len; ++i)
+							output[channel][i] += group_output[i];
+					}
+				}
+				apply_gain(output, out + offset, len);
+			}
+		}
+
+		m_damping = damping_target;
 	}
 
-	static constexpr uint32_t max_lines = 12;
+	// frames each group processes per task of a parallel block
+	static constexpr size_t parallel_size = 4096;
+
+	/*
+		Allocates the output of every group that process_block needs to
+		process with a pool, or frees it. Must not be called while processing
+	*/
+	void set_parallel(bool parallel) {
+		m_group_output = parallel ? std::make_unique<GroupOutput>() : nullptr;
+	}
+
+	/*
+		Whether process_block has no deferred change left to apply, so
+		splitting the input into blocks differently gives the same output.
+		Memory being replaced is swapped in between two blocks
+	*/
+	bool settled() const noexcept {
+		return !m_damping_modified
+			&& !m_replacement
+			&& std::none_of(m_rand.begin(), m_rand.end(), [](const auto& rand) { return rand.pending(); });
+	}
 
 	static constexpr float max_delay = ModulatedDelay<double>::max_delay/1.5f;
 	static constexpr float max_delay_mod = ModulatedDelay<double>::max_mod/1.15f;
 
 	static constexpr float max_diffuse_delay_mod = ModulatedDelay<double>::max_mod/1.15f;
 private:
-	std::array<Delayline, max_lines> m_delay_lines;
-	std::array<float, 3*max_lines> m_rand = {};
+	// number of samples each group processes at a time
+	static constexpr size_t chunk_size = 64;
+
+	// damping filter coefficients shared by every delay line
+	struct DampingCoefs {
+		BiquadCoefs<double> ls;
+		BiquadCoefs<double> hs;
+		double hc;
+
+		static DampingCoefs lerp(const DampingCoefs& a, const DampingCoefs& b, double t) noexcept {
+			return {
+				BiquadCoefs<double>::lerp(a.ls, b.ls, t),
+				BiquadCoefs<double>::lerp(a.hs, b.hs, t),
+				a.hc + t*(b.hc-a.hc)
+			};
+		}
+	};
+
+	struct Damping {
+		Damping(double rate) : ls(), hs(), hc(rate) {}
+
+		void push(Frame& samples, DampingInfo info, const DampingCoefs& coefs) noexcept {
+			if (info.ls_enable) ls.push(samples, coefs.ls);
+			if (info.hs_enable) hs.push(samples, coefs.hs);
+			if (info.hc_enable) hc.push(samples, coefs.hc);
+		}
+
+		void clear() noexcept {
+			ls.clear();
+			hs.clear();
+			hc.clear();
+		}
+
+		void clear(size_t lane) noexcept {
+			ls.clear(lane);
+			hs.clear(lane);
+			hc.clear(lane);
+		}
+
+		BiquadBank<double, lane_group> ls;
+		BiquadBank<double, lane_group> hs;
+		Lowpass6dBBank<double, lane_group> hc;
+	};
+
+	// lane_group delay lines processed side by side
+	struct LineGroup {
+		template <class RNG>
+		LineGroup(float rate, RNG& rng, BufferSizes sizes, Arena& arena) :
+			delay(rng, sizes.delay, arena),
+			diffuser(rate, rng, sizes.diffusion, arena),
+			damping(static_cast<double>(rate))
+		{}
+
+		static size_t memory_required(BufferSizes sizes) noexcept {
+			return Ringbuffer<Frame>::memory_required(sizes.delay)
+				+ Diffuser::max_stages*Ringbuffer<Frame>::memory_required(sizes.diffusion);
+		}
+
+		/*
+			Processes n samples and adds the output of the first lines
+			delay lines to out
+
+			sample i is damped with damping[i*damping_stride]
+		*/
+		void process_block(
+			const double* in,
+			double* out,
+			size_t n,
+			uint32_t lines,
+			PushInfo info,
+			const DampingCoefs* damping_coefs,
+			size_t damping_stride
+		) noexcept {
+			assert(info.order == Order::pre || info.order == Order::post);
+			switch (info.order) {
+				case Order::pre:
+					process_block<Order::pre>(in, out, n, lines, info, damping_coefs, damping_stride);
+					break;
+				case Order::post:
+					process_block<Order::post>(in, out, n, lines, info, damping_coefs, damping_stride);
+					break;
+			}
+		}
+
+		template <Order order>
+		void process_block(
+			const double* in,
+			double* out,
+			size_t n,
+			uint32_t lines,
+			PushInfo info,
+			const DampingCoefs* damping_coefs,
+			size_t damping_stride
+		) noexcept {
+			for (size_t i = 0; i < n; ++i) {
+				damping.push(last_out, info.damping_info, damping_coefs[i*damping_stride]);
+
+				Frame samples;
+				const double sample = in[i];
+				for (size_t lane = 0; lane < lane_group; ++lane)
+					samples[lane] = denormals::guard(sample + last_out[lane]*feedback[lane]);
+
+				if constexpr (order == Order::pre) {
+					delay.push(samples);
+					last_out = samples;
+					diffuser.push(last_out, info.diffuser_info);
+				} else {
+					diffuser.push(samples, info.diffuser_info);
+					last_out = samples;
+					delay.push(last_out);
+				}
+
+				for (size_t lane = 0; lane < lines; ++lane)
+					out[i] += samples[lane];
+			}
+		}
+
+		void clear(size_t lane) noexcept {
+			last_out[lane] = 0;
+			delay.clear(lane);
+			diffuser.clear(lane);
+			damping.clear(lane);
+		}
+
+		ModulatedDelayBank<double, lane_group> delay;
+		Diffuser diffuser;
+		Damping damping;
+
+		Frame last_out = {};
+		Frame feedback = {};
+	};
+
+	// backs the buffers once they have been replaced
+	std::unique_ptr<Arena> m_arena = nullptr;
+
+	static constexpr uint32_t group_count = max_lines/lane_group;
+
+	std::array<std::array<LineGroup, group_count>, channels> m_groups;
+
+	// memory passed to start_replace_memory and how far its buffers have been copied
+	Memory* m_replacement = nullptr;
+	std::array<std::array<std::array<IncrementalCopy<Frame>, 1 + Diffuser::max_stages>, group_count>, channels> m_copies = {};
+
+	// summed lines of every group while processing in parallel, only allocated by set_parallel
+	using GroupOutput = std::array<std::array<std::array<double, parallel_size>, group_count>, channels>;
+	std::unique_ptr<GroupOutput> m_group_output = nullptr;
+	std::array<Random::CrossmixedSequence<3*max_lines>, channels> m_rand = {};
+
+	double m_rate;
+
+	// damping parameters
+	double m_ls_cutoff = 0;
+	double m_ls_gain = 1;
+	double m_hs_cutoff = 0;
+	double m_hs_gain = 1;
+	double m_hc_cutoff = 0;
+
+	// damping coefficients at the end of the last block
+	DampingCoefs m_damping = {};
+	bool m_damping_modified = false;
 
 	// gain compensation for the number of delay lines
 	float m_gain_target = 1.f;
@@ -234,43 +573,215 @@ private:
 
 	uint32_t m_lines = 0;
 	float m_delay = 0.f;
+	// longest line delay that fits into the buffers
+	float m_delay_limit = 0.f;
 	float m_mod_depth = 0.f;
 	float m_mod_rate = 0.f;
 	float m_feedback = 0.f;
 
-	uint32_t m_delay_seed = 0;
-	float m_crossmix = 0.f;
+	// what every group needs to process a block passed to process_block
+	struct Block {
+		const StereoFrame* in;
+		size_t n;
+		PushInfo push_info;
+		DampingCoefs damping_target;
+		bool interpolate_damping;
+	};
+
+	uint32_t active_groups() const noexcept { return (m_lines + lane_group - 1)/lane_group; }
+
+	/*
+		Processes frames offset to offset+len of block through a group
+		of channel and stores the sum of its lines in out
+	*/
+	void process_group(const Block& block, uint32_t channel, uint32_t group, size_t offset, size_t len, double* out) noexcept {
+		const uint32_t lines = std::min(lane_group, m_lines - group*lane_group);
+		LineGroup& line_group = m_groups[channel][group];
+
+		for (size_t chunk = 0; chunk < len; chunk += chunk_size) {
+			const size_t chunk_len = std::min(chunk_size, len - chunk);
+			const size_t start = offset + chunk;
+
+			std::array<double, chunk_size> input;
+			for (size_t i = 0; i < chunk_len; ++i)
+				input[i] = static_cast<double>(block.in[start+i][channel]);
+
+			// the groups step through damping with a stride of 0 if it is constant
+			std::array<DampingCoefs, chunk_size> damping;
+			if (block.interpolate_damping) {
+				for (size_t i = 0; i < chunk_len; ++i) {
+					const double t = static_cast<double>(start+i+1)/static_cast<double>(block.n);
+					damping[i] = DampingCoefs::lerp(m_damping, block.damping_target, t);
+				}
+			} else {
+				damping[0] = m_damping;
+			}
+			const size_t damping_stride = block.interpolate_damping ? 1 : 0;
+
+			std::fill_n(out + chunk, chunk_len, 0.0);
+			line_group.process_block(
+				input.data(), out + chunk, chunk_len, lines, block.push_info,
+				damping.data(), damping_stride
+			);
+		}
+	}
+
+	// smooths the line count compensation into the summed output of both channels
+	template <size_t Size>
+	void apply_gain(const std::array<std::array<double, Size>, channels>& output, StereoFrame* out, size_t n) noexcept {
+		for (size_t i = 0; i < n; ++i) {
+			m_gain = m_gain - m_gain_smoothing*(m_gain-m_gain_target);
+			for (uint32_t channel = 0; channel < channels; ++channel)
+				out[i][channel] = m_gain*static_cast<float>(output[channel][i]);
+		}
+	}
+
+	// what the tasks of process_parallel share
+	struct ParallelBlock {
+		LateRev* self;
+		const Block* block;
+		size_t offset;
+		size_t len;
+		uint32_t active_groups;
+	};
+
+	/*
+		Processes len frames starting at offset with every active group of
+		both channels as a task of its own, in a single fork-join.
+		The groups are summed afterwards in the order of the serial path
+	*/
+	void process_parallel(WorkerPool& pool, const Block& block, size_t offset, size_t len, StereoFrame* out) noexcept {
+		ParallelBlock task{this, &block, offset, len, active_groups()};
+
+		pool.run(channels*task.active_groups, [](void* context, uint32_t index) {
+			const auto& t = *static_cast<const ParallelBlock*>(context);
+			const uint32_t channel = index / t.active_groups;
+			const uint32_t group = index % t.active_groups;
+			t.self->process_group(*t.block, channel, group, t.offset, t.len,
+				(*t.self->m_group_output)[channel][group].data());
+		}, &task);
+
+		for (size_t chunk = 0; chunk < len; chunk += chunk_size) {
+			const size_t chunk_len = std::min(chunk_size, len - chunk);
+			std::array<std::array<double, chunk_size>, channels> output = {};
+			for (uint32_t channel = 0; channel < channels; ++channel) {
+				for (uint32_t group = 0; group < task.active_groups; ++group) {
+					const double* group_output = (*m_group_output)[channel][group].data() + chunk;
+					for (size_t i = 0; i < chunk_len; ++i)
+						output[channel][i] += group_output[i];
+				}
+			}
+			apply_gain(output, out + offset + chunk, chunk_len);
+		}
+	}
+
+	/*
+		Calls f(copy, buffer, replacement) for every buffer of the delay
+		lines and the buffer of m_replacement it is copied into
+	*/
+	template <class F>
+	void for_each_replacement(F&& f) noexcept {
+		for (uint32_t channel = 0; channel < channels; ++channel) {
+			for (uint32_t group = 0; group < group_count; ++group) {
+				auto& copies = m_copies[channel][group];
+				const LineGroup& line_group = m_groups[channel][group];
+				f(copies[0], line_group.delay.buffer(), m_replacement->delays[channel][group]);
+				for (uint32_t stage = 0; stage < Diffuser::max_stages; ++stage)
+					f(copies[stage+1], line_group.diffuser.buffer(stage), m_replacement->diffusers[channel][group][stage]);
+			}
+		}
+	}
 
-	void generate_delay() {
+	// clears a line in the buffers of m_replacement
+	void clear_replacement(uint32_t channel, uint32_t line) noexcept {
+		auto clear = [lane = line%lane_group](Ringbuffer<Frame>& buf) {
+			for (size_t i = 0; i < buf.allocated(); ++i)
+				buf.buf[i][lane] = 0;
+		};
+		clear(m_replacement->delays[channel][line/lane_group]);
+		for (auto& buf : m_replacement->diffusers[channel][line/lane_group])
+			clear(buf);
+	}
+
+	DampingCoefs damping_coefs() const noexcept {
+		return {
+			BiquadCoefs<double>::generate<LowshelfGenerator>(m_rate, m_ls_cutoff, m_ls_gain),
+			BiquadCoefs<double>::generate<HighshelfGenerator>(m_rate, m_hs_cutoff, m_hs_gain),
+			Lowpass6dBBank<double, lane_group>::coefficient(m_rate, m_hc_cutoff)
+		};
+	}
+
+	float delay_limit() const noexcept {
+		const auto capacity = static_cast<float>(m_groups[0][0].delay.capacity());
+		return capacity - ModulatedDelay<double>::max_mod*static_cast<float>(m_rate) - 2.f;
+	}
+
+	// delay of a line in samples, shortened to what fits into the buffers
+	float line_delay(uint32_t channel, uint32_t line) const noexcept {
+		return std::min(m_delay*(0.5f + 1.f*m_rand[channel][line + 2*max_lines]), m_delay_limit);
+	}
+
+	void generate_delay(uint32_t channel) {
 		for (uint32_t line = 0; line < max_lines; ++line) {
-			float delay = m_delay*(0.5f + 1.f*m_rand[line + 2*max_lines]);
-			m_delay_lines[line].delay.set_delay(delay);
+			float delay = line_delay(channel, line);
+			m_groups[channel][line/lane_group].delay.set_delay(line%lane_group, delay);
 		}
 	}
 
-	void generate_mod_depth() {
+	void generate_mod_depth(uint32_t channel) {
 		for (uint32_t line = 0; line < max_lines; ++line) {
-			float mod_depth = m_mod_depth*(0.7f + 0.3f*m_rand[line]);
-			m_delay_lines[line].delay.set_mod_depth(mod_depth);
+			float mod_depth = m_mod_depth*(0.7f + 0.3f*m_rand[channel][line]);
+			m_groups[channel][line/lane_group].delay.set_mod_depth(line%lane_group, mod_depth);
 		}
 	}
 
-	void generate_mod_rate() {
+	void generate_mod_rate(uint32_t channel) {
 		for (uint32_t line = 0; line < max_lines; ++line) {
-			float mod_rate = m_mod_rate*(0.7f + 0.3f*m_rand[line + max_lines]);
-			m_delay_lines[line].delay.set_mod_rate(mod_rate);
+			float mod_rate = m_mod_rate*(0.7f + 0.3f*m_rand[channel][line + max_lines]);
+			m_groups[channel][line/lane_group].delay.set_mod_rate(line%lane_group, mod_rate);
 		}
 	}
 
-	void generate_feedback() {
+	void generate_feedback(uint32_t channel) {
 		for (uint32_t line = 0; line < max_lines; ++line) {
-			float delay = m_delay*(0.5f + 1.f*m_rand[line + 2*max_lines]);
-			// keep reverb time consistent between different lines
-			float feedback = std::pow(m_feedback, delay/m_delay);
-			m_delay_lines[line].set_feedback(feedback);
+			float delay = line_delay(channel, line);
+			// keep reverb time consistent between different lines,
+			// including the ones that have been shortened
+			float feedback = fastmath::pow(m_feedback, delay/m_delay);
+			m_groups[channel][line/lane_group].feedback[line%lane_group] = static_cast<double>(feedback);
 		}
 	}
 };
 
+inline LateRev::Memory::Memory(BufferSizes sizes) :
+	arena{std::make_unique<Arena>(memory_required(sizes))}
+{
+	for (auto& groups : delays) {
+		for (auto& buf : groups) {
+			Ringbuffer<Frame> delay{sizes.delay, 1, *arena};
+			buf.swap(delay);
+		}
+	}
+	for (auto& groups : diffusers) {
+		for (auto& bufs : groups) {
+			for (auto& buf : bufs) {
+				Ringbuffer<Frame> stage{sizes.diffusion, 1, *arena};
+				buf.swap(stage);
+			}
+		}
+	}
+}
+
+inline void LateRev::Memory::detach() noexcept {
+	for (auto& groups : delays)
+		for (auto& buf : groups)
+			buf.detach();
+	for (auto& groups : diffusers)
+		for (auto& bufs : groups)
+			for (auto& buf : bufs)
+				buf.detach();
+}
+
+AETHER_ISA_NAMESPACE_END
 
 #endif
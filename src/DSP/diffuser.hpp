@@ -10,41 +10,97 @@
 #include <random>
 #include <utility>
 
+#include "utils/denormals.hpp"
+#include "utils/fastmath.hpp"
 #include "utils/random.hpp"
 #include "utils/ringbuffer.hpp"
 #include "utils/lfo.hpp"
 
 #include "../common/constants.hpp"
+#include "architecture.hpp"
+
+AETHER_ISA_NAMESPACE_BEGIN
 
 /*
-	Schroeder Allpass filter
+	Lanes Schroeder Allpass filters processed side by side
+
+	The samples of every lane are stored interleaved in a single
+	ringbuffer so that all lanes can be written at once
 */
-template <class FpType>
-class ModulatedAllpass {
+template <class FpType, size_t Lanes>
+class ModulatedAllpassBank {
 public:
-	ModulatedAllpass() = default;
-	ModulatedAllpass(float rate, float mod_phase);
-	ModulatedAllpass(ModulatedAllpass&& other);
-	ModulatedAllpass(const ModulatedAllpass&) = delete;
+	using Frame = std::array<FpType, Lanes>;
+
+	ModulatedAllpassBank() = default;
+	// holds delays plus modulation depths of up to size samples
+	explicit ModulatedAllpassBank(size_t size, Arena& arena = Arena::heap());
+	ModulatedAllpassBank(ModulatedAllpassBank&& other);
+	ModulatedAllpassBank(const ModulatedAllpassBank&) = delete;
 
-	ModulatedAllpass& operator=(ModulatedAllpass&& other) noexcept;
-	ModulatedAllpass& operator=(const ModulatedAllpass&) = delete;
+	ModulatedAllpassBank& operator=(ModulatedAllpassBank&& other) noexcept;
+	ModulatedAllpassBank& operator=(const ModulatedAllpassBank&) = delete;
 
-	void set_delay(float delay) noexcept {
+	void set_delay(size_t lane, float delay) noexcept {
 		assert(delay >= 1.f);
-		m_delay = delay;
-		m_mod_depth = std::min(m_mod_depth, delay-1.f);
+		m_delay[lane] = delay;
+		m_mod_depth[lane] = std::min(m_mod_depth[lane], delay-1.f);
 	}
 
-	void set_mod_depth(float mod_depth) noexcept {
-		m_mod_depth = std::min(mod_depth, m_delay-1.f);
+	void set_mod_depth(size_t lane, float mod_depth) noexcept {
+		m_mod_depth[lane] = std::min(mod_depth, m_delay[lane]-1.f);
 	}
 
-	void set_mod_rate(float mod_rate) noexcept { m_lfo.set_rate(mod_rate); }
+	void set_mod_phase(size_t lane, float phase) noexcept { m_lfo.set_phase(lane, phase); }
+	void set_mod_rate(size_t lane, float mod_rate) noexcept { m_lfo.set_rate(lane, mod_rate); }
+
+	// processes one sample of every lane inplace
+	void push(
+		Frame& samples,
+		float feedback,
+		bool interpolate,
+		bool enable_drive,
+		float drive
+	) noexcept {
+		process(samples, m_lfo.depths(), feedback, interpolate, enable_drive, drive);
+		m_lfo.next();
+	}
 
-	FpType push(FpType sample, float feedback, bool interpolate, bool enable_drive, float drive) noexcept;
+	/*
+		Processes n frames inplace
+		drive holds the per sample drive or nullptr if drive is disabled
+	*/
+	void process_block(
+		Frame* samples,
+		size_t n,
+		float feedback,
+		bool interpolate,
+		const float* drive
+	) noexcept;
 
 	void clear() noexcept { m_buf.clear(); }
+	void clear(size_t lane) noexcept {
+		for (size_t i = 0; i < m_buf.allocated(); ++i)
+			m_buf.buf[i][lane] = 0;
+	}
+
+	/*
+		Swaps in buf, which has to hold the history of the current buffer
+		already, see IncrementalCopy. buf receives the previous buffer in return
+	*/
+	void replace_buffer(Ringbuffer<Frame>& buf) noexcept { m_buf.swap(buf); }
+
+	const Ringbuffer<Frame>& buffer() const noexcept { return m_buf; }
+
+	size_t capacity() const noexcept { return m_buf.capacity; }
+
+	// calls f(data, bytes) for every piece of delay memory, see IncrementalClear
+	template <class F>
+	void for_each_buffer(F&& f) noexcept { f(m_buf.buf, m_buf.allocated()*sizeof(Frame)); }
+
+	static size_t memory_required(size_t size) noexcept {
+		return Ringbuffer<Frame>::memory_required(size);
+	}
 
 	// [10ms, 100ms]
 	static constexpr std::pair<float, float> delay_bounds = {0.01f, 0.1f};
@@ -52,30 +108,48 @@ public:
 	static constexpr std::pair<float, float> mod_bounds = {0.f, 0.003f};
 
 private:
-	Ringbuffer<FpType> m_buf = {};
-
-	float m_delay = 1.f;
-	float m_mod_depth = 0.f;
-
-	LFO m_lfo = {};
+	Ringbuffer<Frame> m_buf = {};
+
+	std::array<float, Lanes> m_delay = filled(1.f);
+	std::array<float, Lanes> m_mod_depth = {};
+
+	LFOBank<Lanes> m_lfo = {};
+
+	// number of lfo values computed at a time
+	static constexpr size_t chunk_size = 64;
+
+	// processes one sample of every lane using the lfo values lfo_depth
+	void process(
+		Frame& samples,
+		const typename LFOBank<Lanes>::Frame& lfo_depth,
+		float feedback,
+		bool interpolate,
+		bool enable_drive,
+		float drive
+	) noexcept;
+
+	static constexpr std::array<float, Lanes> filled(float value) noexcept {
+		std::array<float, Lanes> arr = {};
+		for (auto& e : arr) e = value;
+		return arr;
+	}
 };
 
 
-template <class FpType>
-inline ModulatedAllpass<FpType>::ModulatedAllpass(float rate, float mod_phase) :
-	m_buf{static_cast<size_t>((delay_bounds.second+mod_bounds.second) * rate)},
-	m_lfo{mod_phase} {}
+template <class FpType, size_t Lanes>
+inline ModulatedAllpassBank<FpType, Lanes>::ModulatedAllpassBank(size_t size, Arena& arena) :
+	m_buf{size, 1, arena} {}
 
-template <class FpType>
-inline ModulatedAllpass<FpType>::ModulatedAllpass(ModulatedAllpass&& other) :
-	ModulatedAllpass()
+template <class FpType, size_t Lanes>
+inline ModulatedAllpassBank<FpType, Lanes>::ModulatedAllpassBank(ModulatedAllpassBank&& other) :
+	ModulatedAllpassBank()
 {
 	*this = std::move(other);
 }
 
-template <class FpType>
-inline ModulatedAllpass<FpType>& ModulatedAllpass<FpType>::operator=(
-	ModulatedAllpass&& other
+template <class FpType, size_t Lanes>
+inline ModulatedAllpassBank<FpType, Lanes>& ModulatedAllpassBank<FpType, Lanes>::operator=(
+	ModulatedAllpassBank&& other
 ) noexcept {
 	std::swap(m_buf, other.m_buf);
 	std::swap(m_delay, other.m_delay);
@@ -90,46 +164,82 @@ inline FpType soft_clip(FpType x, FpType drive) noexcept {
 	return (x-x*x*x/3)/drive;
 }
 
-template <class FpType>
-inline FpType ModulatedAllpass<FpType>::push(
-	FpType sample,
+template <class FpType, size_t Lanes>
+inline void ModulatedAllpassBank<FpType, Lanes>::process(
+	Frame& samples,
+	const typename LFOBank<Lanes>::Frame& lfo_depth,
 	float feedback,
 	bool interpolate,
 	bool enable_drive,
 	float drive
 ) noexcept {
-	assert(static_cast<size_t>(m_delay + m_mod_depth) <= m_buf.size);
-	assert(m_delay - m_mod_depth >= 1.f);
+	std::array<float, Lanes> delay;
+	for (size_t lane = 0; lane < Lanes; ++lane) {
+		assert(static_cast<size_t>(m_delay[lane] + m_mod_depth[lane]) <= m_buf.capacity);
+		assert(m_delay[lane] - m_mod_depth[lane] >= 1.f);
+
+		delay[lane] = m_delay[lane] + m_mod_depth[lane]*lfo_depth[lane] - 1.f;
+	}
 
-	float delay = m_delay + m_mod_depth*m_lfo.depth() - 1.f;
-	m_lfo.next();
+	Frame delayed;
+	read_lanes(m_buf, delay, interpolate, delayed);
 
-	uint32_t delay_floor = static_cast<uint32_t>(delay);
-	size_t idx1 = m_buf.end - delay_floor + (m_buf.end < delay_floor ? m_buf.size : 0);
-	size_t idx2 = idx1-1 + (idx1 < 1 ? m_buf.size : 0);
-	FpType t = static_cast<FpType>(delay-static_cast<float>(delay_floor));
-	FpType delayed = interpolate
-		? m_buf.buf[idx1] + t * (m_buf.buf[idx2] - m_buf.buf[idx1])
-		: m_buf.buf[idx1];
+	Frame buffer_input;
+	for (size_t lane = 0; lane < Lanes; ++lane)
+		buffer_input[lane] = denormals::guard(samples[lane] + delayed[lane]*static_cast<FpType>(feedback));
 
-	FpType buffer_input = sample + delayed*static_cast<FpType>(feedback);
-	if (enable_drive)
-		buffer_input = soft_clip(buffer_input, static_cast<FpType>(drive));
+	if (enable_drive) {
+		for (size_t lane = 0; lane < Lanes; ++lane)
+			buffer_input[lane] = soft_clip(buffer_input[lane], static_cast<FpType>(drive));
+	}
 
 	m_buf.push(buffer_input);
 
-	return delayed - m_buf.buf[m_buf.end]*static_cast<FpType>(feedback);
+	for (size_t lane = 0; lane < Lanes; ++lane)
+		samples[lane] = delayed[lane] - buffer_input[lane]*static_cast<FpType>(feedback);
+}
+
+template <class FpType, size_t Lanes>
+inline void ModulatedAllpassBank<FpType, Lanes>::process_block(
+	Frame* samples,
+	size_t n,
+	float feedback,
+	bool interpolate,
+	const float* drive
+) noexcept {
+	for (size_t offset = 0; offset < n; offset += chunk_size) {
+		const size_t len = std::min(chunk_size, n - offset);
+
+		// advance the lfos for the whole chunk at once
+		std::array<typename LFOBank<Lanes>::Frame, chunk_size> lfo_depth;
+		m_lfo.process_block(lfo_depth.data(), len);
+
+		Frame* chunk = samples + offset;
+		if (drive) {
+			for (size_t i = 0; i < len; ++i) {
+				const float d = drive[offset+i];
+				process(chunk[i], lfo_depth[i], feedback, interpolate, d > 0.0001f, d);
+			}
+		} else {
+			for (size_t i = 0; i < len; ++i)
+				process(chunk[i], lfo_depth[i], feedback, interpolate, false, 0.f);
+		}
+	}
 }
 
 
 
 /*
-	An allpass diffuser consisting of up
-	to 8 modulated allpass filters in series
+	Lanes allpass diffusers processed side by side,
+	each consisting of up to 8 modulated allpass filters in series
+
+	All lanes share the same parameters except for the seed and crossmix
 */
-template <class FpType>
-class AllpassDiffuser {
+template <class FpType, size_t Lanes>
+class AllpassDiffuserBank {
 public:
+	using Frame = std::array<FpType, Lanes>;
+
 	struct PushInfo {
 		uint32_t stages;
 		float feedback;
@@ -137,55 +247,120 @@ public:
 	};
 
 	template <class RNG>
-	AllpassDiffuser(float rate, RNG& rng) :
-		m_drive_smoothing{std::exp(-2*constants::pi_v<float> / (0.0001f*100 * rate))},
+	AllpassDiffuserBank(float rate, RNG& rng, Arena& arena = Arena::heap()) :
+		AllpassDiffuserBank(rate, rng, buffer_size(rate, delay_bounds.second*rate), arena) {}
+
+	/*
+		size is the buffer size of every filter, see buffer_size
+		longer delays are shortened until the buffers are replaced
+	*/
+	template <class RNG>
+	AllpassDiffuserBank(float rate, RNG& rng, size_t size, Arena& arena) :
+		m_drive_smoothing{fastmath::exp(-2*constants::pi_v<float> / (0.0001f*100 * rate))},
 		m_rate(rate)
 	{
 		std::uniform_real_distribution<float> dist(0.f, 1.f);
-		for (auto& filter : m_filters)
-			filter = ModulatedAllpass<FpType>(rate, dist(rng));
-
-		Random::generate(m_rand_vals, m_seed, m_crossmix);
+		for (auto& filter : m_filters) {
+			filter = ModulatedAllpassBank<FpType, Lanes>(size, arena);
+			for (size_t lane = 0; lane < Lanes; ++lane)
+				filter.set_mod_phase(lane, dist(rng));
+		}
+		m_delay_limit = delay_limit();
+
+		update_seeds(0);
 	}
 
-	AllpassDiffuser(const AllpassDiffuser&) = delete;
-	~AllpassDiffuser() = default;
+	AllpassDiffuserBank(const AllpassDiffuserBank&) = delete;
+	~AllpassDiffuserBank() = default;
 
-	AllpassDiffuser& operator=(const AllpassDiffuser&) = delete;
+	AllpassDiffuserBank& operator=(const AllpassDiffuserBank&) = delete;
+
+	// per lane parameters, applied lazily by push and process_block
+	void set_seed(size_t lane, uint32_t seed) noexcept { m_rand[lane].set_seed(seed); }
+	void set_seed_crossmix(size_t lane, float crossmix) noexcept { m_rand[lane].set_crossmix(crossmix); }
 
-	void set_seed(uint32_t seed) noexcept;
-	void set_seed_crossmix(float crossmix) noexcept;
+	// shared parameters
 	void set_drive(float drive) noexcept;
 	void set_delay(float delay) noexcept;
 	void set_mod_depth(float mod_depth) noexcept;
 	void set_mod_rate(float mod_rate) noexcept;
 
-	FpType push(FpType sample, PushInfo info) noexcept {
+	// processes one sample of every lane inplace
+	void push(Frame& samples, PushInfo info) noexcept {
+		update_seeds(1);
 		m_drive = m_target_drive - m_drive_smoothing * (m_target_drive - m_drive);
 		bool enable_drive = m_drive > 0.0001f;
 		for (uint32_t i = 0; i < info.stages; ++i)
-			sample = m_filters[i].push(sample, info.feedback, info.interpolate, enable_drive, m_drive);
-		return sample;
+			m_filters[i].push(samples, info.feedback, info.interpolate, enable_drive, m_drive);
 	}
 
+	/*
+		Processes n frames one stage at a time
+		in and out may point to the same buffer
+	*/
+	void process_block(const Frame* in, Frame* out, size_t n, PushInfo info) noexcept;
+
 	void clear() noexcept {
 		for (auto& filter : m_filters)
 			filter.clear();
 	}
 
+	void clear(size_t lane) noexcept {
+		for (auto& filter : m_filters)
+			filter.clear(lane);
+	}
+
+	size_t capacity() const noexcept { return m_filters[0].capacity(); }
+
+	const Ringbuffer<Frame>& buffer(size_t filter) const noexcept { return m_filters[filter].buffer(); }
+
+	// calls f(data, bytes) for every piece of delay memory, see IncrementalClear
+	template <class F>
+	void for_each_buffer(F&& f) noexcept {
+		for (auto& filter : m_filters)
+			filter.for_each_buffer(f);
+	}
+
+	// buffer size of every filter for delays of up to delay samples
+	static size_t buffer_size(float rate, float delay) noexcept {
+		return static_cast<size_t>(delay + mod_headroom*rate) + 2;
+	}
+
+	static size_t memory_required(float rate) noexcept {
+		const size_t size = buffer_size(rate, delay_bounds.second*rate);
+		return max_stages*ModulatedAllpassBank<FpType, Lanes>::memory_required(size);
+	}
+
 	static constexpr uint32_t max_stages = 8;
 
-	static constexpr std::pair<float, float> delay_bounds = ModulatedAllpass<FpType>::delay_bounds;
+	using Buffers = std::array<Ringbuffer<Frame>, max_stages>;
+
+	/*
+		Swaps in bufs, which have to hold the history of every filter
+		already, see IncrementalCopy. bufs receives the previous buffers in return
+	*/
+	void replace_buffers(Buffers& bufs) noexcept {
+		for (size_t filter = 0; filter < m_filters.size(); ++filter)
+			m_filters[filter].replace_buffer(bufs[filter]);
+
+		m_delay_limit = delay_limit();
+		for (size_t lane = 0; lane < Lanes; ++lane)
+			generate_delay(lane);
+	}
+
+	static constexpr std::pair<float, float> delay_bounds = ModulatedAllpassBank<FpType, Lanes>::delay_bounds;
 	static constexpr std::pair<float, float> mod_bounds = {
-		ModulatedAllpass<FpType>::mod_bounds.first/0.85f,
-		ModulatedAllpass<FpType>::mod_bounds.second/1.15f
+		ModulatedAllpassBank<FpType, Lanes>::mod_bounds.first/0.85f,
+		ModulatedAllpassBank<FpType, Lanes>::mod_bounds.second/1.15f
 	};
 private:
-	std::array<ModulatedAllpass<FpType>, max_stages> m_filters = {};
+	std::array<ModulatedAllpassBank<FpType, Lanes>, max_stages> m_filters = {};
 	// used for mod_amt, mod_rate and delay
-	std::array<float, 3*max_stages> m_rand_vals = {};
+	std::array<Random::CrossmixedSequence<3*max_stages>, Lanes> m_rand = {};
 
 	float m_delay = 10.f;
+	// longest delay that fits into the buffers
+	float m_delay_limit = 0.f;
 
 	float m_drive = 0.f;
 	float m_target_drive = 0.f;
@@ -194,89 +369,190 @@ private:
 	float m_mod_depth = 0.f;
 	float m_mod_rate = 0.f;
 
-	uint32_t m_seed = 0;
-	float m_crossmix = 0.f;
-
 	float m_rate;
 
-	void generate_delay() noexcept;
-	void generate_mod_depth() noexcept;
-	void generate_mod_rate() noexcept;
-};
+	// number of samples each stage processes at a time
+	static constexpr size_t chunk_size = 64;
 
+	// the mod depth of a filter is up to 15% above that of the bank
+	static constexpr float mod_headroom = 1.15f*ModulatedAllpassBank<FpType, Lanes>::mod_bounds.second;
 
-template <class FpType>
-inline void AllpassDiffuser<FpType>::set_seed(uint32_t seed) noexcept {
-	m_seed = seed;
+	float delay_limit() const noexcept {
+		return static_cast<float>(capacity()) - mod_headroom*m_rate - 2.f;
+	}
 
-	Random::generate(m_rand_vals, m_seed, m_crossmix);
-	generate_delay();
-	generate_mod_depth();
-	generate_mod_rate();
-}
+	// regenerates the filters of lanes with pending seed changes
+	void update_seeds(uint32_t n) noexcept {
+		for (size_t lane = 0; lane < Lanes; ++lane) {
+			if (m_rand[lane].update(n)) {
+				generate_delay(lane);
+				generate_mod_depth(lane);
+				generate_mod_rate(lane);
+			}
+		}
+	}
+
+	void generate_delay(size_t lane) noexcept;
+	void generate_mod_depth(size_t lane) noexcept;
+	void generate_mod_rate(size_t lane) noexcept;
+};
 
-template <class FpType>
-inline void AllpassDiffuser<FpType>::set_seed_crossmix(float crossmix) noexcept {
-	m_crossmix = crossmix;
 
-	Random::generate(m_rand_vals, m_seed, m_crossmix);
-	generate_delay();
-	generate_mod_depth();
-	generate_mod_rate();
+template <class FpType, size_t Lanes>
+inline void AllpassDiffuserBank<FpType, Lanes>::process_block(
+	const Frame* in,
+	Frame* out,
+	size_t n,
+	PushInfo info
+) noexcept {
+	update_seeds(static_cast<uint32_t>(n));
+
+	for (size_t offset = 0; offset < n; offset += chunk_size) {
+		const size_t len = std::min(chunk_size, n - offset);
+
+		// the drive is smoothed once and shared by every stage
+		std::array<float, chunk_size> drive;
+		bool enable_drive = false;
+		for (size_t i = 0; i < len; ++i) {
+			m_drive = m_target_drive - m_drive_smoothing * (m_target_drive - m_drive);
+			drive[i] = m_drive;
+			enable_drive |= m_drive > 0.0001f;
+		}
+
+		if (in != out)
+			std::copy_n(in+offset, len, out+offset);
+
+		for (uint32_t i = 0; i < info.stages; ++i) {
+			m_filters[i].process_block(
+				out+offset, len, info.feedback, info.interpolate,
+				enable_drive ? drive.data() : nullptr
+			);
+		}
+	}
 }
 
-template <class FpType>
-inline void AllpassDiffuser<FpType>::set_drive(float drive) noexcept {
+template <class FpType, size_t Lanes>
+inline void AllpassDiffuserBank<FpType, Lanes>::set_drive(float drive) noexcept {
 	m_target_drive = drive;
 }
 
-template <class FpType>
-inline void AllpassDiffuser<FpType>::set_delay(float delay) noexcept {
+template <class FpType, size_t Lanes>
+inline void AllpassDiffuserBank<FpType, Lanes>::set_delay(float delay) noexcept {
 	m_delay = delay;
 
-	generate_delay();
+	for (size_t lane = 0; lane < Lanes; ++lane)
+		generate_delay(lane);
 }
 
-template <class FpType>
-inline void AllpassDiffuser<FpType>::set_mod_depth(float mod_depth) noexcept {
+template <class FpType, size_t Lanes>
+inline void AllpassDiffuserBank<FpType, Lanes>::set_mod_depth(float mod_depth) noexcept {
 	m_mod_depth = mod_depth;
 
-	generate_mod_depth();
+	for (size_t lane = 0; lane < Lanes; ++lane)
+		generate_mod_depth(lane);
 }
 
-template <class FpType>
-inline void AllpassDiffuser<FpType>::set_mod_rate(float mod_rate) noexcept {
+template <class FpType, size_t Lanes>
+inline void AllpassDiffuserBank<FpType, Lanes>::set_mod_rate(float mod_rate) noexcept {
 	m_mod_rate = mod_rate;
 
-	generate_mod_rate();
+	for (size_t lane = 0; lane < Lanes; ++lane)
+		generate_mod_rate(lane);
 }
 
-template <class FpType>
-inline void AllpassDiffuser<FpType>::generate_delay() noexcept {
+template <class FpType, size_t Lanes>
+inline void AllpassDiffuserBank<FpType, Lanes>::generate_delay(size_t lane) noexcept {
 	for (size_t filter = 0; filter < m_filters.size(); ++filter) {
-		m_filters[filter].set_delay(
-			m_delay*std::exp( -2.3f*m_rand_vals[filter] )
-		);
+		m_filters[filter].set_delay(lane, std::min(
+			m_delay*fastmath::exp( -2.3f*m_rand[lane][filter] ),
+			m_delay_limit
+		));
 	}
 }
 
-template <class FpType>
-inline void AllpassDiffuser<FpType>::generate_mod_depth() noexcept {
+template <class FpType, size_t Lanes>
+inline void AllpassDiffuserBank<FpType, Lanes>::generate_mod_depth(size_t lane) noexcept {
 	for (size_t filter = 0; filter < m_filters.size(); ++filter) {
-		m_filters[filter].set_mod_depth(
-			m_mod_depth * (0.85f + 0.3f*m_rand_vals[max_stages+filter])
+		m_filters[filter].set_mod_depth(lane,
+			m_mod_depth * (0.85f + 0.3f*m_rand[lane][max_stages+filter])
 		);
 	}
 }
 
-template <class FpType>
-inline void AllpassDiffuser<FpType>::generate_mod_rate() noexcept {
+template <class FpType, size_t Lanes>
+inline void AllpassDiffuserBank<FpType, Lanes>::generate_mod_rate(size_t lane) noexcept {
 	for (size_t filter = 0; filter < m_filters.size(); ++filter) {
-		m_filters[filter].set_mod_rate(
-			m_mod_rate * (0.85f + 0.3f*m_rand_vals[2*max_stages+filter])
+		m_filters[filter].set_mod_rate(lane,
+			m_mod_rate * (0.85f + 0.3f*m_rand[lane][2*max_stages+filter])
 		);
 	}
 }
 
 
+
+/*
+	An allpass diffuser consisting of up
+	to 8 modulated allpass filters in series
+*/
+template <class FpType>
+class AllpassDiffuser {
+	using Bank = AllpassDiffuserBank<FpType, 1>;
+public:
+	using PushInfo = typename Bank::PushInfo;
+
+	template <class RNG>
+	AllpassDiffuser(float rate, RNG& rng) : m_bank(rate, rng) {}
+
+	AllpassDiffuser(const AllpassDiffuser&) = delete;
+	~AllpassDiffuser() = default;
+
+	AllpassDiffuser& operator=(const AllpassDiffuser&) = delete;
+
+	void set_seed(uint32_t seed) noexcept { m_bank.set_seed(0, seed); }
+	void set_seed_crossmix(float crossmix) noexcept { m_bank.set_seed_crossmix(0, crossmix); }
+	void set_drive(float drive) noexcept { m_bank.set_drive(drive); }
+	void set_delay(float delay) noexcept { m_bank.set_delay(delay); }
+	void set_mod_depth(float mod_depth) noexcept { m_bank.set_mod_depth(mod_depth); }
+	void set_mod_rate(float mod_rate) noexcept { m_bank.set_mod_rate(mod_rate); }
+
+	FpType push(FpType sample, PushInfo info) noexcept {
+		typename Bank::Frame frame = {sample};
+		m_bank.push(frame, info);
+		return frame[0];
+	}
+
+	/*
+		Processes n samples one stage at a time
+		in and out may point to the same buffer
+	*/
+	void process_block(const FpType* in, FpType* out, size_t n, PushInfo info) noexcept {
+		for (size_t offset = 0; offset < n; offset += chunk_size) {
+			const size_t len = std::min(chunk_size, n - offset);
+
+			std::array<typename Bank::Frame, chunk_size> frames;
+			for (size_t i = 0; i < len; ++i)
+				frames[i][0] = in[offset+i];
+
+			m_bank.process_block(frames.data(), frames.data(), len, info);
+
+			for (size_t i = 0; i < len; ++i)
+				out[offset+i] = frames[i][0];
+		}
+	}
+
+	void clear() noexcept { m_bank.clear(); }
+
+	static constexpr uint32_t max_stages = Bank::max_stages;
+
+	static constexpr std::pair<float, float> delay_bounds = Bank::delay_bounds;
+	static constexpr std::pair<float, float> mod_bounds = Bank::mod_bounds;
+private:
+	static constexpr size_t chunk_size = 64;
+
+	Bank m_bank;
+};
+
+AETHER_ISA_NAMESPACE_END
+
+
 #endif
@@ -0,0 +1,161 @@
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <dlfcn.h>
+#endif
+
+#include "engine.hpp"
+
+#include "architecture.hpp"
+
+#if defined(ARCH_X86) && defined(_MSC_VER) && !defined(__clang__)
+	#include <intrin.h>
+	#include <immintrin.h>
+#endif
+
+namespace Aether {
+	namespace {
+		// entry point of the module of a variant, see engine.cpp
+		using MakeEngine = Engine* (*)(float rate, const LV2_Worker_Schedule* schedule);
+
+		/*
+			Loads the module of a variant from module_dir, nullptr if it
+			cannot be. Modules are never unloaded, as they have to outlive
+			every engine created from them
+		*/
+		MakeEngine load_module(ISA isa, std::string_view module_dir) {
+			std::string path(module_dir);
+			if (!path.empty() && path.back() != '/' && path.back() != '\\')
+				path += '/';
+			path += "aether_dsp_";
+			path += isa_name(isa);
+			path += AETHER_MODULE_SUFFIX;
+
+		#ifdef _WIN32
+			const HMODULE module = LoadLibraryA(path.c_str());
+			if (!module) return nullptr;
+			return reinterpret_cast<MakeEngine>(GetProcAddress(module, "aether_make_engine"));
+		#else
+			// local, so that nothing loaded later binds to the variant's code
+			void* module = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+			if (!module) return nullptr;
+			return reinterpret_cast<MakeEngine>(dlsym(module, "aether_make_engine"));
+		#endif
+		}
+
+		bool isa_compiled(ISA isa) noexcept {
+			switch (isa) {
+				case ISA::baseline: return true;
+			#ifdef AETHER_ISA_AVX2
+				case ISA::avx2: return true;
+			#endif
+			#ifdef AETHER_ISA_AVX512
+				case ISA::avx512: return true;
+			#endif
+				default: return false;
+			}
+		}
+
+	#if defined(ARCH_X86) && (defined(__GNUC__) || defined(__clang__))
+		bool isa_supported(ISA isa) noexcept {
+			__builtin_cpu_init();
+			const bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+			switch (isa) {
+				case ISA::baseline: return true;
+				case ISA::avx2: return avx2;
+				case ISA::avx512:
+					return avx2
+						&& __builtin_cpu_supports("avx512f")
+						&& __builtin_cpu_supports("avx512vl");
+			}
+			return false;
+		}
+	#elif defined(ARCH_X86) && defined(_MSC_VER)
+		bool isa_supported(ISA isa) noexcept {
+			const auto bit = [](int reg, int n) {
+				return ((static_cast<uint32_t>(reg) >> n) & 1) != 0;
+			};
+
+			int regs[4] = {};
+			__cpuid(regs, 0);
+			if (regs[0] < 7) return isa == ISA::baseline;
+
+			__cpuid(regs, 1);
+			const bool fma = bit(regs[2], 12);
+			if (!bit(regs[2], 27)) return isa == ISA::baseline; // osxsave
+
+			// registers saved by the os
+			const uint64_t xcr0 = _xgetbv(0);
+			const bool os_avx = (xcr0 & 0x06) == 0x06;
+			const bool os_avx512 = (xcr0 & 0xe6) == 0xe6;
+
+			__cpuidex(regs, 7, 0);
+			const bool avx2 = os_avx && fma && bit(regs[1], 5);
+			switch (isa) {
+				case ISA::baseline: return true;
+				case ISA::avx2: return avx2;
+				case ISA::avx512:
+					// avx512f & avx512vl
+					return avx2 && os_avx512 && bit(regs[1], 16) && bit(regs[1], 31);
+			}
+			return false;
+		}
+	#else
+		bool isa_supported(ISA isa) noexcept { return isa == ISA::baseline; }
+	#endif
+	}
+
+	std::string_view isa_name(ISA isa) noexcept {
+		switch (isa) {
+			case ISA::baseline: return "baseline";
+			case ISA::avx2: return "avx2";
+			case ISA::avx512: return "avx512";
+		}
+		return "unknown";
+	}
+
+	std::optional<ISA> parse_isa(std::string_view name) noexcept {
+		for (ISA isa : isas)
+			if (name == isa_name(isa)) return isa;
+		return std::nullopt;
+	}
+
+	bool isa_available(ISA isa) noexcept {
+		return isa_compiled(isa) && isa_supported(isa);
+	}
+
+	ISA select_isa() noexcept {
+		if (const char* forced = std::getenv("AETHER_FORCE_ISA")) {
+			const auto isa = parse_isa(forced);
+			if (isa && isa_available(*isa)) return *isa;
+		}
+
+		ISA best = ISA::baseline;
+		for (ISA isa : isas)
+			if (isa_available(isa)) best = isa;
+		return best;
+	}
+
+	std::unique_ptr<Engine> create_engine(
+		ISA isa,
+		float rate,
+		const LV2_Worker_Schedule* schedule,
+		std::string_view module_dir
+	) {
+		if (isa != ISA::baseline) {
+			// the module returns nullptr for whatever failed, which the baseline engine may not
+			if (const MakeEngine make_engine = load_module(isa, module_dir))
+				if (Engine* engine = make_engine(rate, schedule))
+					return std::unique_ptr<Engine>(engine);
+		}
+		// the baseline is compiled into the plugin, the other variants are modules
+		return baseline::make_engine(rate, schedule);
+	}
+}
@@ -0,0 +1,85 @@
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+
+// LV2
+#include <lv2/core/lv2.h>
+
+#include "aether_dsp.hpp"
+#include "engine.hpp"
+
+#include "architecture.hpp"
+
+/*
+	Compiled once per instruction set variant, see CMakeLists.txt
+*/
+namespace Aether {
+AETHER_ISA_NAMESPACE_BEGIN
+	namespace {
+		class DSPEngine final : public Engine {
+		public:
+			DSPEngine(float rate, const LV2_Worker_Schedule* schedule) : m_dsp(rate, schedule) {}
+
+			ISA isa() const noexcept override { return ISA::AETHER_ISA; }
+
+			void map_uris(LV2_URID_Map* map) noexcept override { m_dsp.map_uris(map); }
+
+			void connect_port(uint32_t port, void* data) noexcept override {
+				constexpr uint32_t misc_port_cnt = sizeof(m_dsp.ports)/sizeof(void*);
+				if (port >= misc_port_cnt)
+					m_dsp.param_ports[port-misc_port_cnt] = reinterpret_cast<const float*>(data);
+				else
+					*(reinterpret_cast<void**>(&m_dsp.ports)+port) = data;
+			}
+
+			void process(uint32_t n_samples) noexcept override { m_dsp.process(n_samples); }
+			void reset_parameters() noexcept override { m_dsp.reset_parameters(); }
+
+			bool memory_locked() const noexcept override { return m_dsp.memory_locked(); }
+			size_t delay_memory() const noexcept override { return m_dsp.delay_memory(); }
+			bool sleeping() const noexcept override { return m_dsp.sleeping(); }
+			AudioTap& audio_tap() noexcept override { return m_dsp.audio_tap(); }
+
+			void set_threads(uint32_t threads, int priority) override { m_dsp.set_threads(threads, priority); }
+
+			LV2_Worker_Status work(
+				LV2_Worker_Respond_Function respond,
+				LV2_Worker_Respond_Handle handle,
+				uint32_t size,
+				const void* data
+			) noexcept override {
+				return m_dsp.work(respond, handle, size, data);
+			}
+
+			LV2_Worker_Status work_response(uint32_t size, const void* data) noexcept override {
+				return m_dsp.work_response(size, data);
+			}
+
+		private:
+			DSP m_dsp;
+		};
+	}
+
+	std::unique_ptr<Engine> make_engine(float rate, const LV2_Worker_Schedule* schedule) {
+		return std::make_unique<DSPEngine>(rate, schedule);
+	}
+AETHER_ISA_NAMESPACE_END
+}
+
+#ifdef AETHER_ISA_MODULE
+/*
+	Entry point of the module of a variant, see create_engine. Exceptions
+	do not cross the module boundary, nullptr is returned instead
+*/
+extern "C" LV2_SYMBOL_EXPORT Aether::Engine* aether_make_engine(
+	float rate,
+	const LV2_Worker_Schedule* schedule
+) noexcept {
+	try {
+		return Aether::make_engine(rate, schedule).release();
+	} catch (const std::exception&) {
+		return nullptr;
+	}
+}
+#endif
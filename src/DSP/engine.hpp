@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+// LV2
+#include <lv2/urid/urid.h>
+#include <lv2/worker/worker.h>
+
+#include "../common/audio_tap.hpp"
+
+#include "architecture.hpp"
+
+namespace Aether {
+
+	// instruction sets the dsp can be compiled for
+	enum class ISA {
+		baseline, // whatever the plugin itself is compiled for
+		avx2,     // avx2 + fma
+		avx512    // avx512f + avx512vl, avx2 + fma
+	};
+
+	static constexpr ISA isas[] = {ISA::baseline, ISA::avx2, ISA::avx512};
+
+	/*
+		The dsp of one instruction set variant
+		Engines are only created through create_engine
+	*/
+	class Engine {
+	public:
+		virtual ~Engine() = default;
+
+		// instruction set the engine was compiled for
+		virtual ISA isa() const noexcept = 0;
+
+		virtual void map_uris(LV2_URID_Map* map) noexcept = 0;
+		virtual void connect_port(uint32_t port, void* data) noexcept = 0;
+		virtual void process(uint32_t n_samples) noexcept = 0;
+		// see DSP::reset_parameters
+		virtual void reset_parameters() noexcept = 0;
+
+		// whether the delay memory is locked into ram
+		virtual bool memory_locked() const noexcept = 0;
+		// bytes of delay memory currently held by the instance
+		virtual size_t delay_memory() const noexcept = 0;
+		// whether processing is skipped until the input is no longer silent
+		virtual bool sleeping() const noexcept = 0;
+		// see DSP::audio_tap
+		virtual AudioTap& audio_tap() noexcept = 0;
+
+		// see DSP::set_threads
+		virtual void set_threads(uint32_t threads, int priority) = 0;
+
+		// lv2 worker interface
+		virtual LV2_Worker_Status work(
+			LV2_Worker_Respond_Function respond,
+			LV2_Worker_Respond_Handle handle,
+			uint32_t size,
+			const void* data
+		) noexcept = 0;
+		virtual LV2_Worker_Status work_response(uint32_t size, const void* data) noexcept = 0;
+	};
+
+AETHER_ISA_NAMESPACE_BEGIN
+	/*
+		Creates the engine of the variant this is compiled for, see
+		engine.cpp. The plugin calls the baseline's, the variants are
+		only reached through their modules
+	*/
+	std::unique_ptr<Engine> make_engine(float rate, const LV2_Worker_Schedule* schedule);
+AETHER_ISA_NAMESPACE_END
+
+	std::string_view isa_name(ISA isa) noexcept;
+	std::optional<ISA> parse_isa(std::string_view name) noexcept;
+
+	// whether the variant was compiled in and is supported by the cpu
+	bool isa_available(ISA isa) noexcept;
+
+	/*
+		Returns the best available instruction set, or the one named by
+		the AETHER_FORCE_ISA environment variable if it is available
+	*/
+	ISA select_isa() noexcept;
+
+	/*
+		isa must be available
+		schedule is the host's worker, see DSP::DSP
+
+		Every variant but the baseline is a module of its own, which is
+		loaded from module_dir. The baseline engine is returned instead
+		if the module cannot be loaded or fails to create its engine,
+		only failures of the baseline engine are thrown
+	*/
+	std::unique_ptr<Engine> create_engine(
+		ISA isa,
+		float rate,
+		const LV2_Worker_Schedule* schedule = nullptr,
+		std::string_view module_dir = {}
+	);
+}
@@ -1,10 +1,18 @@
 #ifndef FILTERS_HPP
 #define FILTERS_HPP
 
+#include <array>
 #include <cmath>
+#include <cstddef>
 #include <tuple>
 
+#include "utils/denormals.hpp"
+#include "utils/fastmath.hpp"
+
 #include "../common/constants.hpp"
+#include "architecture.hpp"
+
+AETHER_ISA_NAMESPACE_BEGIN
 
 
 // First Order Filters
@@ -26,10 +34,16 @@ public:
 	}
 
 	FpType push(FpType sample) noexcept {
-		y = y + a*(sample-y);
+		y = denormals::guard(y + a*(sample-y));
 		return y;
 	}
 
+	// in and out may point to the same buffer
+	void process_block(const FpType* in, FpType* out, size_t n) noexcept {
+		for (size_t i = 0; i < n; ++i)
+			out[i] = push(in[i]);
+	}
+
 	void clear() noexcept { y = 0; }
 
 	void set_cutoff(FpType cutoff) noexcept {
@@ -60,6 +74,12 @@ public:
 		return sample - m_lowpass.push(sample);
 	}
 
+	// in and out may point to the same buffer
+	void process_block(const FpType* in, FpType* out, size_t n) noexcept {
+		for (size_t i = 0; i < n; ++i)
+			out[i] = push(in[i]);
+	}
+
 	void clear() noexcept { m_lowpass.clear(); }
 
 	void set_cutoff(FpType cutoff) noexcept { m_lowpass.set_cutoff(cutoff); }
@@ -119,8 +139,8 @@ public:
 
 	FpType push(FpType x) noexcept {
 		FpType y = b0*x + s1;
-		s1 = s2 + b1*x - a1*y;
-		s2 = b2*x - a2*y;
+		s1 = denormals::guard(s2 + b1*x - a1*y);
+		s2 = denormals::guard(b2*x - a2*y);
 		return y;
 	}
 
@@ -140,7 +160,7 @@ struct LowshelfGenerator {
 		constexpr auto pi = constants::pi_v<FpType>;
 		constexpr auto sqrt2 = constants::sqrt2_v<FpType>;
 
-		FpType K = std::tan( pi*cutoff / rate );
+		FpType K = fastmath::tan( pi*cutoff / rate );
 
 		FpType a0 = 1 + sqrt2*K + K*K;
 
@@ -162,7 +182,7 @@ struct HighshelfGenerator {
 		constexpr auto pi = constants::pi_v<FpType>;
 		constexpr auto sqrt2 = constants::sqrt2_v<FpType>;
 
-		FpType K = std::tan( pi*cutoff / rate );
+		FpType K = fastmath::tan( pi*cutoff / rate );
 
 		const FpType sqrt2G = std::sqrt(2*gain);
 		FpType a0 = 1 + sqrt2G*K + gain*K*K;
@@ -181,4 +201,153 @@ struct HighshelfGenerator {
 template <class FpType> using Lowshelf = Biquad<LowshelfGenerator, FpType>;
 template <class FpType> using Highshelf = Biquad<HighshelfGenerator, FpType>;
 
+
+// Filter Banks
+
+/*
+	Lanes RC lowpass filters sharing the same cutoff
+*/
+template <class FpType, size_t Lanes>
+class Lowpass6dBBank {
+public:
+	using Frame = std::array<FpType, Lanes>;
+
+	Lowpass6dBBank(FpType rate, FpType cutoff = 0) : m_rate{rate}, a{} {
+		set_cutoff(cutoff);
+	}
+
+	// processes one sample of every lane inplace
+	void push(Frame& samples) noexcept { push(samples, a); }
+
+	// processes one sample of every lane inplace using the coefficient coef
+	void push(Frame& samples, FpType coef) noexcept {
+		for (size_t lane = 0; lane < Lanes; ++lane) {
+			y[lane] = denormals::guard(y[lane] + coef*(samples[lane]-y[lane]));
+			samples[lane] = y[lane];
+		}
+	}
+
+	// in and out may point to the same buffer
+	void process_block(const Frame* in, Frame* out, size_t n) noexcept {
+		for (size_t i = 0; i < n; ++i) {
+			out[i] = in[i];
+			push(out[i]);
+		}
+	}
+
+	void clear() noexcept { y = {}; }
+	void clear(size_t lane) noexcept { y[lane] = 0; }
+
+	void set_cutoff(FpType cutoff) noexcept {
+		a = coefficient(m_rate, cutoff);
+
+		if (a == 0)
+			clear();
+	}
+
+	static FpType coefficient(FpType rate, FpType cutoff) noexcept {
+		FpType w = 2*constants::pi_v<FpType>*cutoff/rate;
+		return w/(1+w);
+	}
+
+private:
+	const FpType m_rate;
+	Frame y = {};
+	FpType a;
+};
+
+/*
+	Lanes highpass filters sharing the same cutoff
+	calculated as:
+	input - lowpassed
+*/
+template <class FpType, size_t Lanes>
+class Highpass6dBBank {
+public:
+	using Frame = std::array<FpType, Lanes>;
+
+	Highpass6dBBank(FpType rate, FpType cutoff = 0) : m_lowpass(rate, cutoff) {}
+
+	// processes one sample of every lane inplace
+	void push(Frame& samples) noexcept {
+		Frame lowpassed = samples;
+		m_lowpass.push(lowpassed);
+		for (size_t lane = 0; lane < Lanes; ++lane)
+			samples[lane] -= lowpassed[lane];
+	}
+
+	// in and out may point to the same buffer
+	void process_block(const Frame* in, Frame* out, size_t n) noexcept {
+		for (size_t i = 0; i < n; ++i) {
+			out[i] = in[i];
+			push(out[i]);
+		}
+	}
+
+	void clear() noexcept { m_lowpass.clear(); }
+	void clear(size_t lane) noexcept { m_lowpass.clear(lane); }
+
+	void set_cutoff(FpType cutoff) noexcept { m_lowpass.set_cutoff(cutoff); }
+
+private:
+	Lowpass6dBBank<FpType, Lanes> m_lowpass;
+};
+
+/*
+	Biquad coefficients that can be shared between filters
+*/
+template <class FpType>
+struct BiquadCoefs {
+	FpType a1, a2, b0, b1, b2;
+
+	template <class Generator>
+	static BiquadCoefs generate(FpType rate, FpType cutoff, FpType gain, Generator gen = Generator{}) {
+		BiquadCoefs coefs;
+		std::tie(coefs.a1, coefs.a2, coefs.b0, coefs.b1, coefs.b2) = gen(rate, cutoff, gain);
+		return coefs;
+	}
+
+	/*
+		Linear interpolation from a to b
+		stays stable as the set of stable (a1, a2) is convex
+	*/
+	static BiquadCoefs lerp(const BiquadCoefs& a, const BiquadCoefs& b, FpType t) noexcept {
+		return {
+			a.a1 + t*(b.a1-a.a1),
+			a.a2 + t*(b.a2-a.a2),
+			a.b0 + t*(b.b0-a.b0),
+			a.b1 + t*(b.b1-a.b1),
+			a.b2 + t*(b.b2-a.b2)
+		};
+	}
+};
+
+/*
+	Lanes biquad filters, the coefficients are supplied
+	on every push so that they can be shared and interpolated
+*/
+template <class FpType, size_t Lanes>
+class BiquadBank {
+public:
+	using Frame = std::array<FpType, Lanes>;
+	using Coefs = BiquadCoefs<FpType>;
+
+	// processes one sample of every lane inplace
+	void push(Frame& x, const Coefs& c) noexcept {
+		for (size_t lane = 0; lane < Lanes; ++lane) {
+			FpType y = c.b0*x[lane] + s1[lane];
+			s1[lane] = denormals::guard(s2[lane] + c.b1*x[lane] - c.a1*y);
+			s2[lane] = denormals::guard(c.b2*x[lane] - c.a2*y);
+			x[lane] = y;
+		}
+	}
+
+	void clear() noexcept { s1 = {}; s2 = {}; }
+	void clear(size_t lane) noexcept { s1[lane] = 0; s2[lane] = 0; }
+private:
+	Frame s1 = {}, s2 = {};
+};
+
+AETHER_ISA_NAMESPACE_END
+
 #endif
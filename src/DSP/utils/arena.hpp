@@ -0,0 +1,181 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+#if __has_include (<sys/mman.h>)
+	#include <sys/mman.h>
+	#include <unistd.h>
+	#define ARENA_MMAP
+#endif
+
+#include "../architecture.hpp"
+
+AETHER_ISA_NAMESPACE_BEGIN
+
+/*
+	A single block of memory that all delay buffers of a dsp instance are
+	carved out of, so that it can be prefaulted and locked as a whole
+
+	Allocations that don't fit, and every allocation of the heap arena,
+	fall back to the heap
+*/
+class Arena {
+public:
+	static constexpr size_t alignment = 64;
+
+	// size of n elements of T rounded up to the alignment
+	template <class T>
+	static constexpr size_t size_of(size_t n) noexcept {
+		return (n*sizeof(T) + alignment-1) / alignment * alignment;
+	}
+
+	// arena without memory of its own
+	static Arena& heap() noexcept {
+		static Arena arena;
+		return arena;
+	}
+
+	Arena() = default;
+	explicit Arena(size_t capacity);
+	Arena(const Arena&) = delete;
+	~Arena();
+
+	Arena& operator=(const Arena&) = delete;
+
+	template <class T>
+	T* allocate(size_t n);
+
+	template <class T>
+	void deallocate(T* ptr, size_t n) noexcept;
+
+	// writes to every page so that they don't fault during processing
+	void prefault() noexcept;
+
+	// keeps the memory from being swapped out, returns whether it succeeded
+	bool lock() noexcept;
+
+	size_t capacity() const noexcept { return m_capacity; }
+	size_t used() const noexcept { return m_used; }
+
+	// whether ptr points into the memory of the arena rather than the heap
+	bool owns(const void* ptr) const noexcept {
+		const auto* p = static_cast<const unsigned char*>(ptr);
+		return m_begin && p >= m_begin && p < m_begin + m_capacity;
+	}
+
+private:
+	unsigned char* m_begin = nullptr;
+	size_t m_capacity = 0;
+	size_t m_used = 0;
+
+	// the mapping m_begin was aligned within
+	void* m_map = nullptr;
+	size_t m_map_size = 0;
+
+	bool m_locked = false;
+
+	static size_t page_size() noexcept {
+	#ifdef ARENA_MMAP
+		return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	#else
+		return 4096;
+	#endif
+	}
+
+#ifdef HUGE_PAGES
+	static constexpr size_t huge_page_size = 2 << 20;
+#endif
+};
+
+
+inline Arena::Arena(size_t capacity) : m_capacity{capacity} {
+	if (capacity == 0) return;
+
+#ifdef ARENA_MMAP
+	#ifdef HUGE_PAGES
+		// transparent huge pages are only used for aligned regions
+		m_capacity = (capacity + huge_page_size-1) / huge_page_size * huge_page_size;
+		m_map_size = m_capacity + huge_page_size;
+	#else
+		m_map_size = m_capacity;
+	#endif
+
+	m_map = mmap(nullptr, m_map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (m_map == MAP_FAILED) {
+		m_map = nullptr;
+		throw std::bad_alloc();
+	}
+
+	auto addr = reinterpret_cast<uintptr_t>(m_map);
+	#ifdef HUGE_PAGES
+		addr = (addr + huge_page_size-1) / huge_page_size * huge_page_size;
+		#ifdef MADV_HUGEPAGE
+			madvise(reinterpret_cast<void*>(addr), m_capacity, MADV_HUGEPAGE);
+		#endif
+	#endif
+	m_begin = reinterpret_cast<unsigned char*>(addr);
+#else
+	m_begin = static_cast<unsigned char*>(::operator new(m_capacity, std::align_val_t{alignment}));
+	m_map = m_begin;
+	m_map_size = m_capacity;
+#endif
+}
+
+inline Arena::~Arena() {
+	if (!m_map) return;
+
+#ifdef ARENA_MMAP
+	if (m_locked) munlock(m_begin, m_capacity);
+	munmap(m_map, m_map_size);
+#else
+	::operator delete(m_map, std::align_val_t{alignment});
+#endif
+}
+
+template <class T>
+inline T* Arena::allocate(size_t n) {
+	static_assert(std::is_trivially_default_constructible_v<T>);
+	static_assert(alignof(T) <= alignment);
+
+	const size_t size = size_of<T>(n);
+	if (m_begin && m_used + size <= m_capacity) {
+		T* ptr = reinterpret_cast<T*>(m_begin + m_used);
+		m_used += size;
+		return ptr;
+	}
+
+	return static_cast<T*>(::operator new(size, std::align_val_t{alignment}));
+}
+
+template <class T>
+inline void Arena::deallocate(T* ptr, size_t) noexcept {
+	// arena memory is only released as a whole
+	if (!ptr || owns(ptr)) return;
+	::operator delete(ptr, std::align_val_t{alignment});
+}
+
+inline void Arena::prefault() noexcept {
+	const size_t page = page_size();
+	for (size_t offset = 0; offset < m_capacity; offset += page) {
+		// rewrites the current value, the memory may already be in use
+		volatile unsigned char* byte = m_begin + offset;
+		*byte = *byte;
+	}
+}
+
+inline bool Arena::lock() noexcept {
+#ifdef ARENA_MMAP
+	if (!m_locked && m_begin)
+		m_locked = mlock(m_begin, m_capacity) == 0;
+#endif
+	return m_locked;
+}
+
+AETHER_ISA_NAMESPACE_END
+
+#endif
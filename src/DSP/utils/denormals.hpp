@@ -0,0 +1,63 @@
+#ifndef DENORMALS_HPP
+#define DENORMALS_HPP
+
+#include <cmath>
+#include <limits>
+
+#include "../architecture.hpp"
+
+AETHER_ISA_NAMESPACE_BEGIN
+
+/*
+	Keeps denormals out of the recursive state of the filters and delay
+	lines on cpus that cannot flush them to zero in hardware, where a
+	decaying tail would otherwise slow the feedback loops down by orders
+	of magnitude
+
+	The state is passed through guard() once per sample, which does
+	nothing when the hardware flushes denormals. That is only relied on
+	when built with FORCE_DISABLE_DENORMALS, as nothing else sets the
+	control register
+*/
+namespace denormals {
+	enum class Strategy {
+		// the control register flushes denormals, see DenormalGuard
+		hardware,
+		// sets the state to zero once it falls below threshold
+		flush,
+		// adds an offset far below audibility that keeps the state normal
+		offset
+	};
+
+	#if defined(AETHER_DENORMAL_OFFSET)
+		inline constexpr Strategy strategy = Strategy::offset;
+	#elif defined(AETHER_DENORMAL_FLUSH) || !defined(FORCE_DISABLE_DENORMALS) || !defined(ARCH_FLUSH_DENORMALS)
+		inline constexpr Strategy strategy = Strategy::flush;
+	#else
+		inline constexpr Strategy strategy = Strategy::hardware;
+	#endif
+
+	/*
+		2^-103 for floats and 2^-970 for doubles, far enough from the
+		denormal range that multiplying the state by a coefficient
+		above epsilon does not fall into it
+	*/
+	template <class FpType>
+	inline constexpr FpType threshold = std::numeric_limits<FpType>::min() / std::numeric_limits<FpType>::epsilon();
+
+	template <Strategy S = strategy, class FpType>
+	inline FpType guard(FpType x) noexcept {
+		if constexpr (S == Strategy::flush) {
+			// a select rather than rounding, which -Ofast would fold away
+			return std::abs(x) < threshold<FpType> ? FpType(0) : x;
+		} else if constexpr (S == Strategy::offset) {
+			return x + threshold<FpType>;
+		} else {
+			return x;
+		}
+	}
+}
+
+AETHER_ISA_NAMESPACE_END
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef FASTMATH_HPP
+#define FASTMATH_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "../../common/bit_ops.hpp"
+#include "../../common/constants.hpp"
+#include "../architecture.hpp"
+
+AETHER_ISA_NAMESPACE_BEGIN
+
+/*
+	Approximations of the transcendental functions used to turn parameters
+	into coefficients, gains and delays
+
+	Every function is branch free and inlined so that loops over lanes
+	or stages vectorize, gcc needs -fno-trapping-math for that which the
+	-Ofast release build implies. They are accurate to about float precision for
+	both float and double, which is plenty for control values but not
+	for audio that is fed back. The error bounds are checked against
+	libm in test_fastmath.cpp
+*/
+namespace fastmath {
+	namespace detail {
+		template <class FpType> struct Layout;
+
+		template <> struct Layout<float> {
+			using Int = int32_t;
+			using UInt = uint32_t;
+			static constexpr int mantissa_bits = 23;
+			static constexpr Int bias = 127;
+		};
+
+		template <> struct Layout<double> {
+			using Int = int64_t;
+			using UInt = uint64_t;
+			static constexpr int mantissa_bits = 52;
+			static constexpr Int bias = 1023;
+		};
+	}
+
+	/*
+		2^x with a relative error below 3e-7
+
+		x is clamped to the range of normal numbers, [-126, 127] for floats
+	*/
+	template <class FpType>
+	inline FpType exp2(FpType x) noexcept {
+		using L = detail::Layout<FpType>;
+		using Int = typename L::Int;
+		using UInt = typename L::UInt;
+
+		x = std::clamp<FpType>(x, static_cast<FpType>(1 - L::bias), static_cast<FpType>(L::bias));
+
+		// floor without a call to libm
+		auto i = static_cast<Int>(x);
+		i -= static_cast<Int>(x < static_cast<FpType>(i));
+		const FpType f = x - static_cast<FpType>(i);
+
+		// minimax polynomial of 2^f on [0, 1), relative error 2e-9
+		const FpType p = 1 + f*(FpType(0.6931470444433636) + f*(FpType(0.24022930555176109)
+			+ f*(FpType(0.055485280620120786) + f*(FpType(0.00967545156530315)
+			+ f*(FpType(0.001246784645013827) + f*FpType(0.0002161291497154196))))));
+
+		const auto scale = bits::bit_cast<FpType>(static_cast<UInt>(i + L::bias) << L::mantissa_bits);
+		return p*scale;
+	}
+
+	/*
+		log2(x) for positive normal x with an absolute error below 2e-7,
+		the error is relative near x = 1
+	*/
+	template <class FpType>
+	inline FpType log2(FpType x) noexcept {
+		using L = detail::Layout<FpType>;
+		using Int = typename L::Int;
+		using UInt = typename L::UInt;
+		constexpr UInt mantissa_mask = (UInt{1} << L::mantissa_bits) - 1;
+
+		const auto u = bits::bit_cast<UInt>(x);
+		auto e = static_cast<Int>(u >> L::mantissa_bits) - L::bias;
+		FpType m = bits::bit_cast<FpType>((u & mantissa_mask) | (static_cast<UInt>(L::bias) << L::mantissa_bits));
+
+		// keeps m in [sqrt(1/2), sqrt(2)) where m-1 is exact
+		const bool high = m > constants::sqrt2_v<FpType>;
+		const FpType half = m*FpType(0.5);
+		m = high ? half : m;
+		e += static_cast<Int>(high);
+
+		// log2(m) = 2/ln(2) * atanh(t) with |t| < 0.172
+		const FpType t = (m-1)/(m+1);
+		const FpType t2 = t*t;
+		const FpType k = FpType(2.8853900817779268);
+		return static_cast<FpType>(e) + t*k*(1 + t2*(FpType(1./3) + t2*(FpType(1./5) + t2*FpType(1./7))));
+	}
+
+	// e^x with a relative error below 3e-7 + |x|*6e-8
+	template <class FpType>
+	inline FpType exp(FpType x) noexcept {
+		return exp2(x*constants::log2e_v<FpType>);
+	}
+
+	/*
+		base^x for base >= 0 and x > 0 with a relative error below
+		3e-7 + |x*log2(base)|*2e-7
+
+		0^x is exactly 0 so that disabled smoothing stays exact
+	*/
+	template <class FpType>
+	inline FpType pow(FpType base, FpType x) noexcept {
+		const FpType result = exp2(x*log2(base));
+		return base == 0 ? FpType(0) : result;
+	}
+
+	// 10^(db/20) with a relative error below 3e-7 + |db|*1e-8
+	template <class FpType>
+	inline FpType db_to_gain(FpType db) noexcept {
+		return exp2(db*(constants::log2_10_v<FpType>/20));
+	}
+
+	/*
+		tan(x) for |x| < pi/2 with a relative error below 3e-7
+
+		a (5, 4) pade approximant on [0, pi/4], larger x are
+		reflected using tan(x) = 1/tan(pi/2 - x)
+	*/
+	template <class FpType>
+	inline FpType tan(FpType x) noexcept {
+		// pi/2 split in two so that pi/2 - x stays accurate near pi/2
+		constexpr FpType pi_2 = constants::pi_v<FpType>/2;
+		constexpr FpType pi_2_low = static_cast<FpType>(constants::pi_v<long double>/2 - pi_2);
+
+		const FpType a = std::abs(x);
+		const bool reflect = a > pi_2/2;
+		const FpType y = reflect ? (pi_2 - a) + pi_2_low : a;
+		const FpType y2 = y*y;
+		const FpType num = y*(945 - 105*y2 + y2*y2);
+		const FpType den = 945 - 420*y2 + 15*y2*y2;
+		const FpType tan = num/den;
+		const FpType cot = den/num;
+		return std::copysign(reflect ? cot : tan, x);
+	}
+}
+
+AETHER_ISA_NAMESPACE_END
+
+#endif
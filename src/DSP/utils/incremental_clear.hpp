@@ -0,0 +1,72 @@
+#ifndef INCREMENTAL_CLEAR_HPP
+#define INCREMENTAL_CLEAR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "../architecture.hpp"
+
+AETHER_ISA_NAMESPACE_BEGIN
+
+/*
+	Clears the delay memory of a stage a few bytes at a time
+
+	The memory is visited through a function that calls f(data, bytes)
+	for every buffer of the stage, in the same order every time. Delay
+	memory only holds floating point samples, so it is cleared by zeroing
+	its bytes
+*/
+class IncrementalClear {
+public:
+	// the memory has become stale and has to be cleared from the start
+	void start() noexcept {
+		m_pending = true;
+		m_buffer = 0;
+		m_offset = 0;
+	}
+
+	bool pending() const noexcept { return m_pending; }
+
+	// leaves whatever has not been cleared yet as it is
+	void stop() noexcept { m_pending = false; }
+
+	// clears up to budget bytes from where the last step left off
+	template <class ForEachBuffer>
+	void step(ForEachBuffer&& for_each_buffer, size_t budget) noexcept {
+		if (!m_pending) return;
+
+		size_t index = 0;
+		for_each_buffer([&](void* data, size_t bytes) {
+			if (index++ != m_buffer || budget == 0) return;
+
+			const size_t n = std::min(budget, bytes - m_offset);
+			std::memset(static_cast<unsigned char*>(data) + m_offset, 0, n);
+			budget -= n;
+			m_offset += n;
+			if (m_offset == bytes) {
+				++m_buffer;
+				m_offset = 0;
+			}
+		});
+		m_pending = m_buffer != index;
+	}
+
+	// clears whatever is left
+	template <class ForEachBuffer>
+	void finish(ForEachBuffer&& for_each_buffer) noexcept {
+		step(for_each_buffer, std::numeric_limits<size_t>::max());
+	}
+
+private:
+	bool m_pending = false;
+	// position of the next byte to clear
+	size_t m_buffer = 0;
+	size_t m_offset = 0;
+};
+
+AETHER_ISA_NAMESPACE_END
+
+#endif
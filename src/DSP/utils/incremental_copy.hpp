@@ -0,0 +1,81 @@
+#ifndef INCREMENTAL_COPY_HPP
+#define INCREMENTAL_COPY_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "ringbuffer.hpp"
+
+#include "../architecture.hpp"
+
+AETHER_ISA_NAMESPACE_BEGIN
+
+/*
+	Copies the history of a ringbuffer into one with at least the same
+	capacity a few elements at a time, while the source keeps being written
+
+	Elements are copied from the oldest to the newest, to where every delay
+	of the source reads them once the destination has been swapped in.
+	The source has to be written fewer times than its capacity between
+	two calls to update
+*/
+template <class T>
+class IncrementalCopy {
+public:
+	// the destination has to be cleared
+	void start(const Ringbuffer<T>& src) noexcept {
+		m_src_end = src.end;
+		m_end = src.end;
+		m_pending = src.capacity;
+	}
+
+	// accounts for the elements written to src since the last call
+	void update(const Ringbuffer<T>& src) noexcept {
+		const size_t written = (src.end - m_src_end) & src.mask;
+		m_src_end = src.end;
+		m_end += written;
+		// the oldest elements that have not been copied are gone
+		m_pending = std::min(m_pending + written, src.capacity);
+	}
+
+	// number of elements that have yet to be copied
+	size_t pending() const noexcept { return m_pending; }
+
+	// copies up to n of the oldest elements that have yet to be copied, returns how many were
+	size_t step(const Ringbuffer<T>& src, Ringbuffer<T>& dst, size_t n) noexcept {
+		n = std::min(n, m_pending);
+		// delay of the oldest element left
+		size_t delay = m_pending;
+		for (size_t left = n; left > 0;) {
+			const size_t src_index = (m_src_end - delay + 1) & src.mask;
+			const size_t dst_index = (m_end - delay + 1) & dst.mask;
+			const size_t len = std::min({left, src.capacity - src_index, dst.capacity - dst_index});
+			std::copy_n(src.buf + src_index, len, dst.buf + dst_index);
+			left -= len;
+			delay -= len;
+		}
+		m_pending -= n;
+		return n;
+	}
+
+	/*
+		Ends dst where the source ends, so that it can be swapped in.
+		Whatever is still pending is left out
+	*/
+	void finish(Ringbuffer<T>& dst) noexcept {
+		dst.end = m_end & dst.mask;
+		std::copy_n(dst.buf, dst.guard, dst.buf + dst.capacity);
+	}
+
+private:
+	// end of the source at the last update
+	size_t m_src_end = 0;
+	// end of the destination, without wrapping
+	size_t m_end = 0;
+	size_t m_pending = 0;
+};
+
+AETHER_ISA_NAMESPACE_END
+
+#endif
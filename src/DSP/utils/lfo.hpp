@@ -1,9 +1,17 @@
 #ifndef LFO_HPP
 #define LFO_HPP
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <complex>
+#include <cstddef>
+#include <cstdint>
 
 #include "../../common/constants.hpp"
+#include "../architecture.hpp"
+
+AETHER_ISA_NAMESPACE_BEGIN
 
 class LFO {
 	static constexpr double pi = constants::pi;
@@ -27,4 +35,203 @@ private:
 	std::complex<double> m_phase = 1.0;
 };
 
+#ifndef LFO_CONTROL_INTERVAL
+#define LFO_CONTROL_INTERVAL 1
+#endif
+
+/*
+	Lanes independent LFOs stored as a structure of arrays
+	so that they can be advanced together
+
+	With a control interval of N > 1 the LFOs are only evaluated every
+	N samples and linearly interpolated in between. Whenever a lane is too
+	fast to be interpolated within max_interpolation_error, every lane is
+	evaluated every sample instead. The rotators are renormalized
+	periodically so that their magnitude doesn't drift.
+*/
+template <size_t Lanes>
+class LFOBank {
+	static constexpr double pi = constants::pi;
+public:
+	using Frame = std::array<float, Lanes>;
+
+	LFOBank() {
+		m_re.fill(1.0);
+		m_im.fill(0.0);
+		m_step_re.fill(1.0);
+		m_step_im.fill(0.0);
+		m_interval_step_re.fill(1.0);
+		m_interval_step_im.fill(0.0);
+	}
+
+	float depth(size_t lane) const noexcept { return m_depth[lane]; }
+	const Frame& depths() const noexcept { return m_depth; }
+
+	// advances every lane by one sample
+	void next() noexcept {
+		if (m_interval == 1) {
+			rotate(m_step_re, m_step_im, 1);
+			for (size_t lane = 0; lane < Lanes; ++lane)
+				m_depth[lane] = static_cast<float>(m_im[lane]);
+			return;
+		}
+
+		if (++m_pos != m_interval) {
+			for (size_t lane = 0; lane < Lanes; ++lane)
+				m_depth[lane] += m_delta[lane];
+			return;
+		}
+
+		// the interpolation ends on the exact value, so rounding errors don't add up
+		m_pos = 0;
+		for (size_t lane = 0; lane < Lanes; ++lane)
+			m_depth[lane] = static_cast<float>(m_im[lane]);
+		rotate(m_interval_step_re, m_interval_step_im, m_interval);
+		for (size_t lane = 0; lane < Lanes; ++lane)
+			m_delta[lane] = (static_cast<float>(m_im[lane]) - m_depth[lane]) / static_cast<float>(m_interval);
+	}
+
+	// writes the depths of the next n samples to depths
+	void process_block(Frame* depths, size_t n) noexcept {
+		for (size_t i = 0; i < n; ++i) {
+			depths[i] = m_depth;
+			next();
+		}
+	}
+
+	// phase is in cycles
+	void set_phase(size_t lane, float phase) noexcept {
+		const auto p = std::polar(1.0, 2*pi*static_cast<double>(phase));
+		m_re[lane] = p.real();
+		m_im[lane] = p.imag();
+		m_depth[lane] = static_cast<float>(p.imag());
+		if (m_interval != 1)
+			restart_interval(lane);
+	}
+
+	// rate is in cycles/sample
+	void set_rate(size_t lane, float rate) noexcept {
+		m_rate[lane] = rate;
+		const auto step = std::polar(1.0, 2*pi*static_cast<double>(rate));
+		m_step_re[lane] = step.real();
+		m_step_im[lane] = step.imag();
+		const auto interval_step = std::polar(1.0, 2*pi*static_cast<double>(rate)*m_interval);
+		m_interval_step_re[lane] = interval_step.real();
+		m_interval_step_im[lane] = interval_step.imag();
+		update_interval();
+	}
+
+	// evaluates the LFOs at most every interval samples
+	void set_interval(uint32_t interval) noexcept {
+		m_max_interval = std::max(interval, 1u);
+		update_interval();
+	}
+
+	// the interval the LFOs are currently evaluated at
+	uint32_t interval() const noexcept { return m_interval; }
+
+	static constexpr uint32_t default_interval = LFO_CONTROL_INTERVAL;
+	static_assert(default_interval >= 1);
+
+	// largest deviation from the exact sine that interpolation may cause
+	static constexpr double max_interpolation_error = 1e-4;
+
+private:
+	// the phase of the next evaluated sample
+	std::array<double, Lanes> m_re = {};
+	std::array<double, Lanes> m_im = {};
+	std::array<double, Lanes> m_step_re = {};
+	std::array<double, Lanes> m_step_im = {};
+	std::array<double, Lanes> m_interval_step_re = {};
+	std::array<double, Lanes> m_interval_step_im = {};
+	std::array<float, Lanes> m_rate = {};
+
+	// current output and its per sample change between evaluations
+	Frame m_depth = {};
+	Frame m_delta = {};
+
+	uint32_t m_max_interval = default_interval;
+	uint32_t m_interval = default_interval;
+	uint32_t m_pos = 0;
+	// samples the rotators have advanced since they were renormalized
+	uint32_t m_unnormalized = 0;
+
+	static constexpr uint32_t renormalize_interval = 1024;
+
+	void rotate(
+		const std::array<double, Lanes>& step_re,
+		const std::array<double, Lanes>& step_im,
+		uint32_t samples
+	) noexcept {
+		for (size_t lane = 0; lane < Lanes; ++lane) {
+			const double re = m_re[lane]*step_re[lane] - m_im[lane]*step_im[lane];
+			const double im = m_re[lane]*step_im[lane] + m_im[lane]*step_re[lane];
+			m_re[lane] = re;
+			m_im[lane] = im;
+		}
+
+		m_unnormalized += samples;
+		if (m_unnormalized >= renormalize_interval) {
+			m_unnormalized = 0;
+			// one newton iteration of 1/sqrt(|z|^2) is enough near 1
+			for (size_t lane = 0; lane < Lanes; ++lane) {
+				const double scale = 1.5 - 0.5*(m_re[lane]*m_re[lane] + m_im[lane]*m_im[lane]);
+				m_re[lane] *= scale;
+				m_im[lane] *= scale;
+			}
+		}
+	}
+
+	// rotates the phase of lane by the given number of samples
+	void advance(size_t lane, double samples) noexcept {
+		const auto step = std::polar(1.0, 2*pi*static_cast<double>(m_rate[lane])*samples);
+		const double re = m_re[lane]*step.real() - m_im[lane]*step.imag();
+		const double im = m_re[lane]*step.imag() + m_im[lane]*step.real();
+		m_re[lane] = re;
+		m_im[lane] = im;
+	}
+
+	// moves the phase of lane to the end of the current interval
+	void restart_interval(size_t lane) noexcept {
+		const uint32_t remaining = m_interval - m_pos;
+		advance(lane, remaining);
+		m_delta[lane] = (static_cast<float>(m_im[lane]) - m_depth[lane]) / static_cast<float>(remaining);
+	}
+
+	/*
+		Switches to m_max_interval, or to 1 if a lane is too fast for it.
+		A sine of angular frequency w deviates from its linear interpolation
+		over n samples by at most (w*n)^2/8
+	*/
+	void update_interval() noexcept {
+		uint32_t interval = m_max_interval;
+		for (size_t lane = 0; lane < Lanes && interval != 1; ++lane) {
+			// rates above half a cycle per sample alias to slower ones
+			const double rate = static_cast<double>(m_rate[lane]);
+			const double w = 2*pi*(rate - std::round(rate))*interval;
+			if (w*w/8 > max_interpolation_error)
+				interval = 1;
+		}
+		if (interval == m_interval) return;
+
+		// back to the phase of the current sample
+		if (m_interval != 1) {
+			for (size_t lane = 0; lane < Lanes; ++lane)
+				advance(lane, -static_cast<double>(m_interval - m_pos));
+		}
+
+		m_interval = interval;
+		m_pos = 0;
+		for (size_t lane = 0; lane < Lanes; ++lane) {
+			const auto interval_step = std::polar(1.0, 2*pi*static_cast<double>(m_rate[lane])*m_interval);
+			m_interval_step_re[lane] = interval_step.real();
+			m_interval_step_im[lane] = interval_step.imag();
+			if (m_interval != 1)
+				restart_interval(lane);
+		}
+	}
+};
+
+AETHER_ISA_NAMESPACE_END
+
 #endif
@@ -7,6 +7,10 @@
 	#include <version>
 #endif
 
+#include "../architecture.hpp"
+
+AETHER_ISA_NAMESPACE_BEGIN
+
 namespace math {
 	#if __cpp_lib_interpolate >= 201902L
 	template <class T>
@@ -17,4 +21,6 @@ namespace math {
 	#endif
 }
 
+AETHER_ISA_NAMESPACE_END
+
 #endif
@@ -0,0 +1,159 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "../../common/bit_ops.hpp"
+#include "../architecture.hpp"
+
+AETHER_ISA_NAMESPACE_BEGIN
+
+/*
+	Nanoseconds spent in each stage of Stage, an enum ending in count
+
+	Only records anything when built with AETHER_PROFILE, otherwise every
+	member function compiles to nothing. The statistics are written by
+	the processing thread alone and kept in relaxed atomics, so they may
+	be read from any thread at any time. A reading may mix the values of
+	consecutive blocks.
+
+	p99 is read from a histogram with four buckets per power of two,
+	so it overestimates the percentile by up to 25%
+*/
+template <class Stage>
+class StageProfiler {
+public:
+#ifdef AETHER_PROFILE
+	static constexpr bool enabled = true;
+#else
+	static constexpr bool enabled = false;
+#endif
+
+	static constexpr size_t stages = static_cast<size_t>(Stage::count);
+
+	using Clock = std::chrono::steady_clock;
+	using TimePoint = Clock::time_point;
+
+	struct Stats {
+		uint64_t count;
+		uint64_t min;
+		uint64_t max;
+		double avg;
+		uint64_t p99;
+	};
+
+	static TimePoint now() noexcept {
+		if constexpr (enabled)
+			return Clock::now();
+		else
+			return {};
+	}
+
+	// records the time since start for stage and returns the current time
+	TimePoint lap(Stage stage, TimePoint start) noexcept {
+		if constexpr (enabled) {
+			const TimePoint end = Clock::now();
+			record(stage, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+			return end;
+		} else {
+			return start;
+		}
+	}
+
+	void record(Stage stage, uint64_t ns) noexcept {
+		if constexpr (enabled) {
+			// a single writer only has to keep the stores atomic
+			auto increment = [](std::atomic<uint64_t>& value, uint64_t amount) {
+				value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+			};
+
+			StageData& data = m_data[static_cast<size_t>(stage)];
+			increment(data.count, 1);
+			increment(data.total, ns);
+			if (ns < data.min.load(std::memory_order_relaxed))
+				data.min.store(ns, std::memory_order_relaxed);
+			if (ns > data.max.load(std::memory_order_relaxed))
+				data.max.store(ns, std::memory_order_relaxed);
+			increment(data.histogram[bucket(ns)], 1);
+		}
+	}
+
+	Stats stats(Stage stage) const noexcept {
+		if constexpr (enabled) {
+			const StageData& data = m_data[static_cast<size_t>(stage)];
+			Stats stats = {};
+			stats.count = data.count.load(std::memory_order_relaxed);
+			if (stats.count == 0) return stats;
+
+			stats.min = data.min.load(std::memory_order_relaxed);
+			stats.max = data.max.load(std::memory_order_relaxed);
+			stats.avg = static_cast<double>(data.total.load(std::memory_order_relaxed)) / static_cast<double>(stats.count);
+
+			// upper bound of the bucket holding the 99th percentile
+			const uint64_t rank = stats.count - stats.count/100;
+			uint64_t seen = 0;
+			for (size_t b = 0; b < buckets; ++b) {
+				seen += data.histogram[b].load(std::memory_order_relaxed);
+				if (seen >= rank) {
+					stats.p99 = std::min(bucket_floor(b+1) - 1, stats.max);
+					break;
+				}
+			}
+			return stats;
+		} else {
+			return {};
+		}
+	}
+
+	// must not be called while another thread records
+	void reset() noexcept {
+		if constexpr (enabled) {
+			for (StageData& data : m_data) {
+				data.count = 0;
+				data.total = 0;
+				data.min = std::numeric_limits<uint64_t>::max();
+				data.max = 0;
+				for (auto& count : data.histogram)
+					count = 0;
+			}
+		}
+	}
+
+private:
+	// covers up to 2^40 ns, longer times land in the last bucket
+	static constexpr size_t buckets = 4*40;
+
+	// four buckets per power of two, the first four hold 0 to 3 ns
+	static constexpr size_t bucket(uint64_t ns) noexcept {
+		if (ns < 4) return static_cast<size_t>(ns);
+		const auto e = static_cast<size_t>(bits::bit_width(ns) - 1);
+		const size_t b = 4*(e-1) + static_cast<size_t>((ns >> (e-2)) & 3);
+		return std::min(b, buckets-1);
+	}
+
+	// smallest value that falls into bucket b
+	static constexpr uint64_t bucket_floor(size_t b) noexcept {
+		if (b < 4) return b;
+		return uint64_t{4 + b%4} << (b/4 - 1);
+	}
+
+	struct StageData {
+		std::atomic<uint64_t> count = 0;
+		std::atomic<uint64_t> total = 0;
+		std::atomic<uint64_t> min = std::numeric_limits<uint64_t>::max();
+		std::atomic<uint64_t> max = 0;
+		std::array<std::atomic<uint64_t>, buckets> histogram = {};
+	};
+
+	std::array<StageData, enabled ? stages : 0> m_data = {};
+};
+
+AETHER_ISA_NAMESPACE_END
+
+#endif
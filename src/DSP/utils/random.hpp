@@ -1,10 +1,16 @@
 #ifndef RANDOM_HPP
 #define RANDOM_HPP
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <limits>
 #include "math.hpp"
+#include "../architecture.hpp"
+
+AETHER_ISA_NAMESPACE_BEGIN
 
 namespace Random {
 
@@ -64,6 +70,79 @@ namespace Random {
 			);
 		}
 	}
+
+	/*
+		Random values equivalent to generate(values, seed, crossmix)
+
+		The two base sequences are cached per seed, so a change of
+		crossmix only costs a lerp. Crossmix changes are applied lazily by
+		update, at most once every refresh_interval samples, while seed
+		changes are applied by the next update.
+	*/
+	template <size_t Size>
+	class CrossmixedSequence {
+	public:
+		CrossmixedSequence() : CrossmixedSequence(0, 0.f) {}
+		CrossmixedSequence(uint32_t seed, float crossmix) :
+			m_crossmix{crossmix}
+		{
+			set_seed(seed);
+			update(0);
+			// the first change is not rate limited
+			m_countdown = 0;
+		}
+
+		void set_seed(uint32_t seed) noexcept {
+			Xorshift64s rng1(seed);
+			Xorshift64s rng2(~seed);
+			for (size_t i = 0; i < Size; ++i) {
+				m_base1[i] = static_cast<float>(rng1() >> 8) * 0x1.0p-24f;
+				m_base2[i] = static_cast<float>(rng2() >> 8) * 0x1.0p-24f;
+			}
+			m_pending = true;
+			m_countdown = 0;
+		}
+
+		void set_crossmix(float crossmix) noexcept {
+			m_crossmix = crossmix;
+			m_pending = true;
+		}
+
+		/*
+			Advances by n samples and recomputes the values if a change is
+			pending and allowed by the rate limit
+
+			returns whether the values changed
+		*/
+		bool update(uint32_t n) noexcept {
+			m_countdown -= std::min(m_countdown, n);
+			if (!m_pending || m_countdown != 0) return false;
+
+			for (size_t i = 0; i < Size; ++i)
+				m_values[i] = math::lerp(m_base1[i], m_base2[i], m_crossmix);
+
+			m_pending = false;
+			m_countdown = refresh_interval;
+			return true;
+		}
+
+		float operator[](size_t idx) const noexcept { return m_values[idx]; }
+		// whether a change is waiting to be applied by update
+		bool pending() const noexcept { return m_pending; }
+
+		static constexpr uint32_t refresh_interval = 256;
+
+	private:
+		std::array<float, Size> m_base1 = {};
+		std::array<float, Size> m_base2 = {};
+		std::array<float, Size> m_values = {};
+
+		float m_crossmix;
+		bool m_pending = true;
+		uint32_t m_countdown = 0;
+	};
 }
 
+AETHER_ISA_NAMESPACE_END
+
 #endif
@@ -2,38 +2,167 @@
 #define RINGBUFFER_HPP
 
 #include <algorithm>
+#include <array>
+#include <cassert>
 #include <cstddef>
+#include <cstdint>
 
+#include "arena.hpp"
+
+#include "../../common/bit_ops.hpp"
+#include "../architecture.hpp"
+
+AETHER_ISA_NAMESPACE_BEGIN
+
+/*
+	Delay memory with a power of two capacity
+
+	Indices are wrapped with a mask, and the first guard elements are
+	mirrored behind the end of the buffer, so that any window of up to
+	guard elements starting at a wrapped index is contiguous in memory
+*/
 template<class T>
 struct Ringbuffer {
 
-	Ringbuffer() : Ringbuffer(0) {}
-	explicit Ringbuffer(size_t sz) : size{sz}, buf{new T[sz]} { clear(); }
+	// empty buffer that has to be swapped with a real one before use
+	Ringbuffer() : capacity{1}, mask{0}, guard{0}, buf{nullptr} {}
+	// holds at least sz elements with windows of up to guard elements
+	explicit Ringbuffer(size_t sz, size_t guard_size = 1, Arena& arena = Arena::heap()) :
+		capacity{capacity_for(sz)},
+		mask{capacity-1},
+		guard{guard_size},
+		buf{arena.allocate<T>(capacity+guard)},
+		m_arena{&arena}
+	{
+		clear();
+	}
 
 	Ringbuffer(const Ringbuffer&) = delete;
 	Ringbuffer& operator=(const Ringbuffer&) = delete;
 
-	~Ringbuffer() { delete[] buf; }
+	~Ringbuffer() {
+		if (m_arena) m_arena->deallocate(buf, allocated());
+	}
+
+	// bytes of arena memory a buffer with the same arguments takes up
+	static size_t memory_required(size_t sz, size_t guard_size = 1) noexcept {
+		return Arena::size_of<T>(capacity_for(sz) + guard_size);
+	}
 
 	void push(T value) noexcept {
-		++end;
-		end -= (end >= size ? size : 0);
+		end = (end+1) & mask;
 		buf[end] = value;
+		// rewrites the same element when outside the mirrored region
+		buf[end < guard ? end+capacity : end] = value;
 	}
 
-	void clear() noexcept { std::fill_n(buf, size, T()); }
+	// writes n <= capacity elements at once
+	void write(const T* values, size_t n) noexcept {
+		const size_t start = (end+1) & mask;
+		const size_t len = std::min(n, capacity - start);
+		std::copy_n(values, len, buf + start);
+		std::copy_n(values + len, n - len, buf);
+		end = (start + n - 1) & mask;
+
+		if (start < guard || len < n)
+			std::copy_n(buf, guard, buf + capacity);
+	}
+
+	// the element written delay elements before the last one
+	T operator[](size_t delay) const noexcept { return buf[(end - delay) & mask]; }
+
+	/*
+		Pointer to the element written delay elements before the last one,
+		the following guard elements are contiguous in memory
+	*/
+	const T* window(size_t delay) const noexcept { return buf + ((end - delay) & mask); }
+
+	// number of elements allocated including the mirrored region
+	size_t allocated() const noexcept { return capacity + guard; }
+
+	void clear() noexcept { std::fill_n(buf, allocated(), T()); }
+
+	/*
+		Stops referring to the arena the buffer was allocated from, so that
+		it can be destroyed after the arena. Arena memory is released along
+		with the arena, heap memory the arena fell back to is freed by the buffer
+	*/
+	void detach() noexcept {
+		if (m_arena && m_arena->owns(buf))
+			m_arena = nullptr;
+		else if (m_arena)
+			m_arena = &Arena::heap();
+	}
 
 	void swap(Ringbuffer& other) noexcept {
 		std::swap(end, other.end);
-		std::swap(size, other.size);
+		std::swap(capacity, other.capacity);
+		std::swap(mask, other.mask);
+		std::swap(guard, other.guard);
 		std::swap(buf, other.buf);
+		std::swap(m_arena, other.m_arena);
 	}
 
 	size_t end = 0;
-	size_t size;
+	size_t capacity;
+	size_t mask;
+	size_t guard;
 	T* buf;
+
+private:
+	Arena* m_arena = nullptr;
+
+	static size_t capacity_for(size_t sz) noexcept { return bits::bit_ceil(std::max<size_t>(sz, 1)); }
 };
 
+/*
+	Reads every lane of a ringbuffer of frames, delay[lane] samples
+	before the last written frame. The fractional part of the delay is
+	linearly interpolated if interpolate is set.
+
+	Each step is done for all lanes at once so that
+	everything except the loads can be vectorized.
+*/
+template <class FpType, size_t Lanes>
+inline void read_lanes(
+	const Ringbuffer<std::array<FpType, Lanes>>& buf,
+	const std::array<float, Lanes>& delay,
+	bool interpolate,
+	std::array<FpType, Lanes>& out
+) noexcept {
+	const auto end = static_cast<uint32_t>(buf.end);
+	const auto mask = static_cast<uint32_t>(buf.mask);
+
+	std::array<uint32_t, Lanes> idx1;
+	std::array<uint32_t, Lanes> idx2;
+	std::array<FpType, Lanes> t;
+	for (size_t lane = 0; lane < Lanes; ++lane) {
+		const auto delay_floor = static_cast<uint32_t>(delay[lane]);
+		t[lane] = static_cast<FpType>(delay[lane] - static_cast<float>(delay_floor));
+
+		idx1[lane] = (end - delay_floor) & mask;
+		idx2[lane] = (end - delay_floor - 1) & mask;
+	}
+
+	std::array<FpType, Lanes> a;
+	for (size_t lane = 0; lane < Lanes; ++lane)
+		a[lane] = buf.buf[idx1[lane]][lane];
+
+	if (!interpolate) {
+		out = a;
+		return;
+	}
+
+	std::array<FpType, Lanes> b;
+	for (size_t lane = 0; lane < Lanes; ++lane)
+		b[lane] = buf.buf[idx2[lane]][lane];
+
+	for (size_t lane = 0; lane < Lanes; ++lane)
+		out[lane] = a[lane] + t[lane]*(b[lane]-a[lane]);
+}
+
+AETHER_ISA_NAMESPACE_END
+
 namespace std {
 	template <class T>
 	inline void swap(Ringbuffer<T>& lhs, Ringbuffer<T>& rhs) noexcept {
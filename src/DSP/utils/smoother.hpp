@@ -0,0 +1,144 @@
+#ifndef SMOOTHER_HPP
+#define SMOOTHER_HPP
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "fastmath.hpp"
+
+#include "../architecture.hpp"
+
+AETHER_ISA_NAMESPACE_BEGIN
+
+/*
+	One pole smoothing of Size parameters, advanced a block at a time
+
+	Only parameters that are still converging are kept in the active list,
+	so a block without automation costs next to nothing. A parameter is
+	reported as modified once it has moved by more than its threshold since
+	it was last reported, or when it reaches its target.
+*/
+template <size_t Size>
+class ParameterSmoother {
+public:
+	explicit ParameterSmoother(uint32_t block_size) : m_block_size{block_size} {}
+
+	/*
+		smooth is the per sample coefficient, 0 disables smoothing
+		threshold is the smallest change that is worth reporting
+	*/
+	void set_smoothing(size_t p, float smooth, float threshold) noexcept {
+		m_smooth[p] = smooth;
+		m_smooth_block[p] = fastmath::pow(smooth, static_cast<float>(m_block_size));
+		m_threshold[p] = threshold;
+	}
+
+	// jumps straight to value without reporting it
+	void reset(size_t p, float value) noexcept {
+		m_targets[p] = value;
+		m_reported[p] = value;
+		deactivate(p);
+	}
+
+	void set_target(size_t p, float target) noexcept {
+		if (target == m_targets[p]) return;
+		m_targets[p] = target;
+		activate(p);
+	}
+
+	float target(size_t p) const noexcept { return m_targets[p]; }
+	bool active(size_t p) const noexcept { return m_active_idx[p] != inactive; }
+	size_t active_count() const noexcept { return m_active_count; }
+
+	/*
+		Advances every active parameter by n samples
+		values holds the current value of every parameter and
+		modified is set for every parameter that was reported
+
+		returns whether any parameter was reported
+	*/
+	bool advance(uint32_t n, float* values, bool* modified) noexcept;
+
+private:
+	static constexpr uint32_t inactive = std::numeric_limits<uint32_t>::max();
+
+	uint32_t m_block_size;
+
+	std::array<float, Size> m_targets = {};
+	std::array<float, Size> m_smooth = {};
+	// m_smooth raised to m_block_size
+	std::array<float, Size> m_smooth_block = {};
+	std::array<float, Size> m_threshold = {};
+	// last value that was reported as modified
+	std::array<float, Size> m_reported = {};
+
+	// unordered list of parameters that have not reached their target
+	std::array<uint32_t, Size> m_active = {};
+	std::array<uint32_t, Size> m_active_idx = filled(inactive);
+	uint32_t m_active_count = 0;
+
+	void activate(size_t p) noexcept {
+		if (active(p)) return;
+		m_active_idx[p] = m_active_count;
+		m_active[m_active_count++] = static_cast<uint32_t>(p);
+	}
+
+	void deactivate(size_t p) noexcept {
+		if (!active(p)) return;
+		// move the last active parameter into the freed slot
+		const uint32_t idx = m_active_idx[p];
+		const uint32_t last = m_active[--m_active_count];
+		m_active[idx] = last;
+		m_active_idx[last] = idx;
+		m_active_idx[p] = inactive;
+	}
+
+	static constexpr std::array<uint32_t, Size> filled(uint32_t value) noexcept {
+		std::array<uint32_t, Size> arr = {};
+		for (auto& e : arr) e = value;
+		return arr;
+	}
+};
+
+template <size_t Size>
+inline bool ParameterSmoother<Size>::advance(uint32_t n, float* values, bool* modified) noexcept {
+	bool reported = false;
+	for (uint32_t i = 0; i < m_active_count;) {
+		const uint32_t p = m_active[i];
+
+		// smoothing over n samples is equivalent to smoothing
+		// with coefficient smooth^n
+		const float smooth = n == m_block_size
+			? m_smooth_block[p]
+			: fastmath::pow(m_smooth[p], static_cast<float>(n));
+		float value = m_targets[p] - smooth * (m_targets[p] - values[p]);
+
+		const bool converged = std::abs(m_targets[p] - value) <= m_threshold[p];
+		if (converged)
+			value = m_targets[p];
+		values[p] = value;
+
+		const bool report = converged
+			? value != m_reported[p]
+			: std::abs(value - m_reported[p]) > m_threshold[p];
+		if (report) {
+			m_reported[p] = value;
+			modified[p] = true;
+			reported = true;
+		}
+
+		// the slot is refilled by the last active parameter
+		if (converged)
+			deactivate(p);
+		else
+			++i;
+	}
+	return reported;
+}
+
+AETHER_ISA_NAMESPACE_END
+
+#endif
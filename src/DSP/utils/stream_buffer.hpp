@@ -0,0 +1,97 @@
+#ifndef STREAM_BUFFER_HPP
+#define STREAM_BUFFER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../../common/bit_ops.hpp"
+#include "../architecture.hpp"
+
+AETHER_ISA_NAMESPACE_BEGIN
+
+/*
+	Stereo audio collected between the snapshots sent to the ui
+
+	Pushed samples are decimated by averaging every decimation samples,
+	which is only meant for drawing. Once full, the oldest samples are
+	overwritten, so a ui that cannot keep up only loses history
+*/
+class StreamBuffer {
+public:
+	// empty buffer that drops everything pushed to it
+	StreamBuffer() = default;
+	// holds at least capacity decimated samples per channel
+	explicit StreamBuffer(size_t capacity, uint32_t decimation = 1) :
+		m_left(bits::bit_ceil(capacity)),
+		m_right(m_left.size()),
+		m_mask{m_left.size()-1},
+		m_decimation{std::max(decimation, uint32_t{1})}
+	{}
+
+	uint32_t decimation() const noexcept { return m_decimation; }
+	size_t capacity() const noexcept { return m_left.size(); }
+	// decimated samples per channel waiting to be popped
+	size_t size() const noexcept { return m_size; }
+
+	void push(const float* left, const float* right, size_t n) noexcept {
+		if (m_left.empty()) return;
+
+		const float scale = 1.f / static_cast<float>(m_decimation);
+		for (size_t i = 0; i < n; ++i) {
+			m_sum_left += left[i];
+			m_sum_right += right[i];
+			if (++m_phase < m_decimation) continue;
+
+			const size_t end = (m_start + m_size) & m_mask;
+			m_left[end] = scale*m_sum_left;
+			m_right[end] = scale*m_sum_right;
+			if (m_size == capacity())
+				m_start = (m_start+1) & m_mask;
+			else
+				++m_size;
+
+			m_sum_left = m_sum_right = 0.f;
+			m_phase = 0;
+		}
+	}
+
+	// moves up to n of the oldest samples into left and right and returns how many
+	size_t pop(float* left, float* right, size_t n) noexcept {
+		n = std::min(n, m_size);
+		const size_t len = std::min(n, capacity() - m_start);
+		std::copy_n(m_left.data() + m_start, len, left);
+		std::copy_n(m_left.data(), n - len, left + len);
+		std::copy_n(m_right.data() + m_start, len, right);
+		std::copy_n(m_right.data(), n - len, right + len);
+
+		m_start = (m_start + n) & m_mask;
+		m_size -= n;
+		return n;
+	}
+
+	// drops the waiting samples along with a partly summed one
+	void clear() noexcept {
+		m_start = m_size = 0;
+		m_sum_left = m_sum_right = 0.f;
+		m_phase = 0;
+	}
+
+private:
+	std::vector<float> m_left = {};
+	std::vector<float> m_right = {};
+	size_t m_mask = 0;
+	size_t m_start = 0;
+	size_t m_size = 0;
+
+	uint32_t m_decimation = 1;
+	// samples summed into the next decimated one
+	uint32_t m_phase = 0;
+	float m_sum_left = 0.f;
+	float m_sum_right = 0.f;
+};
+
+AETHER_ISA_NAMESPACE_END
+
+#endif
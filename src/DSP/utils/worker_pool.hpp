@@ -0,0 +1,173 @@
+#ifndef WORKER_POOL_HPP
+#define WORKER_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if __has_include(<pthread.h>)
+	#include <pthread.h>
+	#define WORKER_POOL_PTHREAD
+#endif
+
+#include "../architecture.hpp"
+
+AETHER_ISA_NAMESPACE_BEGIN
+
+/*
+	A few threads that process the tasks of a fork-join on the audio thread
+
+	Between wake and sleep the workers spin, so that handing out tasks and
+	waiting for them only takes atomic operations. Outside of that they
+	park on a condition variable. wake notifies it without taking the
+	mutex, a worker that misses the notification sits the cycle out and
+	the calling thread runs its tasks instead.
+	Tasks must not block, and must not throw
+
+	The workers set their own scheduling priority when they start, so
+	that the audio thread never has to
+*/
+class WorkerPool {
+public:
+	using Task = void (*)(void* context, uint32_t index);
+
+	// priority is a SCHED_FIFO priority, 0 keeps the default policy
+	explicit WorkerPool(uint32_t threads, int priority = 0) : m_priority{priority} {
+		m_threads.reserve(threads);
+		for (uint32_t i = 0; i < threads; ++i)
+			m_threads.emplace_back([this]{ work(); });
+	}
+
+	WorkerPool(const WorkerPool&) = delete;
+
+	~WorkerPool() {
+		{
+			std::lock_guard lock(m_mutex);
+			m_quit = true;
+		}
+		m_wake.notify_all();
+		for (auto& thread : m_threads)
+			thread.join();
+	}
+
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	uint32_t threads() const noexcept { return static_cast<uint32_t>(m_threads.size()); }
+
+	// the workers spin until sleep is called
+	void wake() noexcept {
+		m_awake.store(true, std::memory_order_relaxed);
+		m_wake.notify_all();
+	}
+
+	void sleep() noexcept { m_awake.store(false, std::memory_order_relaxed); }
+
+	/*
+		Calls task(context, i) for every i < n on the workers and the
+		calling thread, and returns once every call has returned
+		n must be below 2^16
+	*/
+	void run(uint32_t n, Task task, void* context) noexcept {
+		m_task = task;
+		m_context = context;
+		m_done.store(0, std::memory_order_relaxed);
+
+		m_generation = (m_generation + 1) & 0xffff;
+		m_state.store(m_generation << 48 | uint64_t{n} << 32, std::memory_order_release);
+
+		while (run_one()) {}
+		for (uint32_t spins = 0; m_done.load(std::memory_order_acquire) != n; ++spins)
+			backoff(spins);
+	}
+
+private:
+	std::vector<std::thread> m_threads = {};
+
+	std::mutex m_mutex = {};
+	std::condition_variable m_wake = {};
+	bool m_quit = false;
+	std::atomic<bool> m_awake = false;
+	int m_priority;
+
+	/*
+		generation << 48 | task count << 32 | next task
+		the generation keeps tasks of an earlier run from being claimed
+	*/
+	std::atomic<uint64_t> m_state = 0;
+	uint64_t m_generation = 0;
+	std::atomic<uint32_t> m_done = 0;
+
+	// written before m_state is published and read after a task is claimed
+	Task m_task = nullptr;
+	void* m_context = nullptr;
+
+	// claims and runs a task, returns false if none were left
+	bool run_one() noexcept {
+		uint64_t state = m_state.load(std::memory_order_acquire);
+		do {
+			const auto next = static_cast<uint32_t>(state);
+			const auto count = static_cast<uint32_t>(state >> 32) & 0xffff;
+			if (next >= count) return false;
+		} while (!m_state.compare_exchange_weak(state, state+1, std::memory_order_acq_rel));
+
+		m_task(m_context, static_cast<uint32_t>(state));
+		m_done.fetch_add(1, std::memory_order_release);
+		return true;
+	}
+
+	void work() noexcept {
+	#ifdef FORCE_DISABLE_DENORMALS
+		disable_denormals();
+	#endif
+		if (m_priority)
+			set_priority();
+
+		while (true) {
+			{
+				std::unique_lock lock(m_mutex);
+				m_wake.wait(lock, [this]{ return m_quit || m_awake.load(std::memory_order_relaxed); });
+				if (m_quit) return;
+			}
+
+			for (uint32_t spins = 0; m_awake.load(std::memory_order_relaxed); ++spins) {
+				if (run_one())
+					spins = 0;
+				else
+					backoff(spins);
+			}
+		}
+	}
+
+	// gives the calling worker m_priority, fails quietly without the permission to
+	void set_priority() noexcept {
+	#ifdef WORKER_POOL_PTHREAD
+		sched_param param = {};
+		param.sched_priority = m_priority;
+		pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+	#endif
+	}
+
+	// gives up the core now and then in case the threads outnumber the cores
+	static void backoff(uint32_t spins) noexcept {
+		if (spins % 256 == 255)
+			std::this_thread::yield();
+		else
+			pause();
+	}
+
+	static void pause() noexcept {
+	#if defined(ARCH_EXT_SSE)
+		_mm_pause();
+	#elif defined(ARCH_ARM) && defined(__GNUC__)
+		__asm__ __volatile__("yield");
+	#endif
+	}
+};
+
+AETHER_ISA_NAMESPACE_END
+
+#endif
@@ -10,6 +10,7 @@
 #include <iostream>
 #include <locale>
 #include <memory>
+#include <sstream>
 #include <string>
 #include <stdexcept>
 #include <vector>
@@ -27,13 +28,13 @@
 #include <lv2/atom/util.h>
 #include <lv2/atom/forge.h>
 
-#include "../DSP/aether_dsp.hpp"
 #include "../common/bit_ops.hpp"
 #include "../common/parameters.hpp"
+#include "../common/uris.hpp"
 #include "../common/utils.hpp"
 #include "aether_ui.hpp"
 #include "ui_tree.hpp"
-#include "utils/fft.hpp"
+#include "utils/analyser.hpp"
 #include "utils/strings.hpp"
 
 
@@ -134,6 +135,9 @@ namespace Aether {
 
 		void add_peaks(size_t n_samples, const float* peaks);
 
+		// shows the minimum, average, 99th percentile and maximum time of every stage
+		void set_profile_stats(size_t n_stats, const float* stats);
+
 		void add_samples(uint32_t channel, uint32_t rate, size_t n_samples, const float* l_samples, const float* r_samples);
 
 	private:
@@ -157,13 +161,18 @@ namespace Aether {
 		} peak_infos;
 
 		struct SampleInfo {
-			static constexpr size_t n_streams = 2;
-
-			int32_t sample_rate;
-			std::array<std::vector<float>, 2*n_streams> samples;
-			std::array<std::vector<float>, 2> spectrum;
+			SpectrumAnalyser analyser;
+			// both channels of a stream averaged, when showing both streams
+			std::vector<float> mono;
+			// which streams were shown last frame, input in bit 0 and output in bit 1
+			int shown = 0;
+			// whether the display has caught up with the latest spectra
+			bool settled = true;
 		} sample_infos;
 
+		// only filled in when the dsp is built with PROFILE_STAGES
+		Text* m_profile_text = nullptr;
+
 		std::function<void (size_t, float)> update_dsp_param;
 
 		bool m_should_close = false;
@@ -1422,6 +1431,17 @@ namespace Aether {
 				}
 			});
 		}
+
+		// Profile
+		m_profile_text = ui_tree.root().add_child<Text>({
+			.visible = true, .inert = true,
+			.style = {
+				{"x", "10sp"}, {"y", "10sp"}, {"width", "400sp"},
+				{"font-family", "Roboto-Light"}, {"font-size", "12sp"},
+				{"vertical-align", "top"}, {"text-align", "left"},
+				{"fill", "#c1c1c180"}, {"text", ""}
+			}
+		});
 	}
 
 	pugl::Status UI::View::onEvent(const pugl::CreateEvent&) noexcept {
@@ -1552,22 +1572,9 @@ namespace Aether {
 	}
 
 	void UI::View::add_samples(uint32_t stream, uint32_t rate, size_t n_samples, const float* l_samples, const float* r_samples) {
-		sample_infos.sample_rate = rate;
-
-		const auto copy_channel = [&](const float* in, size_t idx){
-			auto& buf = sample_infos.samples[idx];
-			buf.resize(bits::bit_ceil(rate / 10));
-
-			if (n_samples < buf.size()) {
-				std::copy(buf.begin()+n_samples, buf.end(), buf.begin());
-				std::copy_n(in, n_samples, buf.end()-n_samples);
-			} else {
-				std::copy_n(in+n_samples-buf.size(), buf.size(), buf.begin());
-			}
-		};
-
-		copy_channel(l_samples, 2*stream+0);
-		copy_channel(r_samples, 2*stream+1);
+		if (rate != sample_infos.analyser.rate())
+			sample_infos.analyser.set_rate(rate);
+		sample_infos.analyser.push(stream, l_samples, r_samples, n_samples);
 	}
 
 	void UI::View::update_samples() {
@@ -1575,70 +1582,61 @@ namespace Aether {
 		// time since last frame in seconds
 		const float dt = 0.000001f*duration_cast<microseconds>(steady_clock::now()-last_frame).count();
 
-		constexpr float freq_max = 22000;
-		constexpr float freq_min = 15;
-		const float bin_size = sample_infos.samples[0].size() ?
-			static_cast<float>(sample_infos.sample_rate)/sample_infos.samples[0].size()
-			: freq_max;
+		constexpr float freq_max = SpectrumAnalyser::freq_max;
+		auto& analyser = sample_infos.analyser;
+		const float bin_size = analyser.size() ? analyser.bin_size() : freq_max;
 
 		ui_tree.root().audio_bin_size_hz = bin_size;
 
-		const auto process_samples = [&](size_t stream, size_t channel) {
-			auto& input = sample_infos.samples[stream*2+channel];
-
-			if (!input.size()) return;
+		const bool show_input = get_parameter(65) > 0.f;
+		const bool show_output = get_parameter(66) > 0.f;
 
-			sample_infos.spectrum[channel] = input;
-			fft::window_function(sample_infos.spectrum[channel]);
-			fft::magnitudes(sample_infos.spectrum[channel]);
+		// new spectra only once a hop of new audio has arrived
+		bool updated = false;
+		if (show_input) updated |= analyser.update(0);
+		if (show_output) updated |= analyser.update(1);
 
-			// add 3dB/Oct slope
-			const float middle_freq = freq_min * std::pow(freq_max/freq_min, 0.5f);
-			for (size_t i = 1; i < input.size()/2; ++i) {
-				const float freq = i * bin_size;
-				const float doct = std::log2(freq/middle_freq);
-				sample_infos.spectrum[channel][i] *= std::pow(dB_to_gain(3), doct);
-			}
-		};
+		// nothing to do while no audio arrives once the display has caught up
+		const int shown = show_input | (show_output << 1);
+		if (!updated && sample_infos.settled && shown == sample_infos.shown)
+			return;
+		sample_infos.shown = shown;
+		sample_infos.settled = true;
 
-		const auto update_channel = [&](size_t in, size_t out) {
+		const auto update_channel = [&](const std::vector<float>& input, size_t out) {
 			auto& output = ui_tree.root().audio[out];
-			const auto& input = sample_infos.spectrum[in];
 
 			if (input.size() == 0) return;
 
 			output.resize(std::ceil(freq_max/bin_size) + 1);
 
-			const size_t size = std::min(input.size()/2-1, output.size());
+			const size_t size = std::min(input.size()-1, output.size());
 
+			bool settled = true;
 			for (size_t i = 0; i < size; ++i) {
 				const float coef = (output[i] < input[i] ? 16 : 8) * dt;
 				output[i] = std::lerp(output[i], input[i], std::min(coef, 1.f));
+				// well below the -60dB floor of the display
+				settled &= std::abs(output[i] - input[i]) <= 0.001f*input[i] + 0.0001f;
 			}
 			std::fill(output.begin()+size, output.end(), 0.f);
+			sample_infos.settled &= settled;
 		};
 
 
-		if (get_parameter(65) > 0.f && get_parameter(66) > 0.f) {
-			for (size_t stream = 0; stream < SampleInfo::n_streams; ++stream) {
-				process_samples(stream, 0);
-				process_samples(stream, 1);
-				for (size_t i = 0; i < sample_infos.spectrum[0].size(); ++i) {
-					sample_infos.spectrum[0][i] =
-						0.5f*(sample_infos.spectrum[0][i] + sample_infos.spectrum[1][i]);
-				}
-				update_channel(0, stream);
+		if (show_input && show_output) {
+			for (size_t stream = 0; stream < SpectrumAnalyser::streams; ++stream) {
+				const auto& left = analyser.spectrum(stream, 0);
+				const auto& right = analyser.spectrum(stream, 1);
+				sample_infos.mono.resize(left.size());
+				for (size_t i = 0; i < left.size(); ++i)
+					sample_infos.mono[i] = 0.5f*(left[i] + right[i]);
+				update_channel(sample_infos.mono, stream);
 			}
-		} else if (get_parameter(65) > 0.f) {
-			process_samples(0, 0);
-			process_samples(0, 1);
-			update_channel(0, 0);
-			update_channel(1, 1);
-		} else if (get_parameter(66) > 0.f) {
-			process_samples(1, 0);
-			process_samples(1, 1);
-			update_channel(0, 0);
-			update_channel(1, 1);
+		} else if (show_input || show_output) {
+			const size_t stream = show_input ? 0 : 1;
+			update_channel(analyser.spectrum(stream, 0), 0);
+			update_channel(analyser.spectrum(stream, 1), 1);
 		} else {
 			ui_tree.root().audio[0] = {};
 			ui_tree.root().audio[1] = {};
@@ -1650,6 +1648,22 @@ namespace Aether {
 			peak_infos.peaks[i] = level_meter_scale(peaks[i]);
 	}
 
+	void UI::View::set_profile_stats(size_t n_stats, const float* stats) {
+		std::ostringstream ss;
+		ss.imbue(std::locale::classic());
+		ss.setf(ss.fixed);
+		ss.precision(1);
+
+		ss << "min / avg / p99 / max (us)\n";
+		const size_t stages = std::min(n_stats/4, uri::profile_stages.size());
+		for (size_t s = 0; s < stages; ++s) {
+			ss << uri::profile_stages[s] << ": "
+			   << stats[4*s+0] << " / " << stats[4*s+1] << " / "
+			   << stats[4*s+2] << " / " << stats[4*s+3] << "\n";
+		}
+		m_profile_text->style.insert_or_assign("text", ss.str());
+	}
+
 	void UI::View::update_peaks() {
 		using namespace std::chrono;
 		// time since last frame in seconds
@@ -2489,6 +2503,8 @@ namespace Aether {
 	UI::UI(const CreateInfo& create_info, LV2_URID_Map* map) :
 		m_write_function{create_info.write_function},
 		m_controller{create_info.controller},
+		// attached before the dsp is told that the ui is open
+		m_audio_tap{create_info.audio_tap && create_info.audio_tap->attach() ? create_info.audio_tap : nullptr},
 		m_view{}
 	{
 		map_uris(map);
@@ -2504,6 +2520,9 @@ namespace Aether {
 
 		delete world;
 
+		if (m_audio_tap)
+			m_audio_tap->detach();
+
 		// inform dsp part that a ui has been destroyed
 
 		// create the atom in a temporary byte array
@@ -2525,6 +2544,15 @@ namespace Aether {
 	}
 
 	int UI::update_display() noexcept {
+		if (m_audio_tap) {
+			const auto rate = static_cast<uint32_t>(m_audio_tap->rate());
+			for (uint32_t stream = 0; stream < AudioTap::streams; ++stream) {
+				m_audio_tap->read(stream, [&](const float* l_samples, const float* r_samples, size_t n_samples) {
+					m_view->add_samples(stream, rate, n_samples, l_samples, r_samples);
+				});
+			}
+		}
+
 		m_view->postRedisplay();
 		return (m_view->world().update(0) != pugl::Status::success) || m_view->should_close();
 	}
@@ -2551,6 +2579,20 @@ namespace Aether {
 					LV2_ATOM_CONTENTS_CONST(LV2_Atom_Vector, atom_peaks));
 
 				m_view->add_peaks(atom_n_samples->body, peaks);
+			} else if (object->body.otype == uris.profile_data) {
+				const LV2_Atom_Vector* atom_stats = nullptr;
+				lv2_atom_object_get_typed(object,
+					uris.profile_stats, &atom_stats, uris.atom_Vector,
+					0
+				);
+				if (!atom_stats) return;
+
+				const size_t n_stats =
+					(atom_stats->atom.size-sizeof(LV2_Atom_Vector_Body))/sizeof(float);
+				auto stats = static_cast<const float*>(
+					LV2_ATOM_CONTENTS_CONST(LV2_Atom_Vector, atom_stats));
+
+				m_view->set_profile_stats(n_stats, stats);
 			} else if (object->body.otype == uris.sample_data) {
 				const LV2_Atom_Int* atom_rate = nullptr;
 				const LV2_Atom_Int* atom_channel = nullptr;
@@ -2584,18 +2626,21 @@ namespace Aether {
 		uris.atom_Int    = map->map(map->handle, LV2_ATOM__Int);
 		uris.atom_Vector = map->map(map->handle, LV2_ATOM__Vector);
 
-		uris.ui_open  = map->map(map->handle, join_v<DSP::URI, DSP::ui_open_URI>);
-		uris.ui_close = map->map(map->handle, join_v<DSP::URI, DSP::ui_close_URI>);
+		uris.ui_open  = map->map(map->handle, join_v<uri::plugin, uri::ui_open>);
+		uris.ui_close = map->map(map->handle, join_v<uri::plugin, uri::ui_close>);
+
+		uris.peak_data    = map->map(map->handle, join_v<uri::plugin, uri::peak_data>);
+		uris.sample_count = map->map(map->handle, join_v<uri::plugin, uri::sample_count>);
+		uris.peaks        = map->map(map->handle, join_v<uri::plugin, uri::peaks>);
 
-		uris.peak_data    = map->map(map->handle, join_v<DSP::URI, DSP::peak_data_URI>);
-		uris.sample_count = map->map(map->handle, join_v<DSP::URI, DSP::sample_count_URI>);
-		uris.peaks        = map->map(map->handle, join_v<DSP::URI, DSP::peaks_URI>);
+		uris.profile_data  = map->map(map->handle, join_v<uri::plugin, uri::profile_data>);
+		uris.profile_stats = map->map(map->handle, join_v<uri::plugin, uri::profile_stats>);
 
-		uris.sample_data = map->map(map->handle, join_v<DSP::URI, DSP::sample_data_URI>);
-		uris.rate        = map->map(map->handle, join_v<DSP::URI, DSP::rate_URI>);
-		uris.channel     = map->map(map->handle, join_v<DSP::URI, DSP::channel_URI>);
-		uris.l_samples   = map->map(map->handle, join_v<DSP::URI, DSP::l_samples_URI>);
-		uris.r_samples   = map->map(map->handle, join_v<DSP::URI, DSP::r_samples_URI>);
+		uris.sample_data = map->map(map->handle, join_v<uri::plugin, uri::sample_data>);
+		uris.rate        = map->map(map->handle, join_v<uri::plugin, uri::rate>);
+		uris.channel     = map->map(map->handle, join_v<uri::plugin, uri::channel>);
+		uris.l_samples   = map->map(map->handle, join_v<uri::plugin, uri::l_samples>);
+		uris.r_samples   = map->map(map->handle, join_v<uri::plugin, uri::r_samples>);
 	}
 
 	UI::View* UI::create_view(const CreateInfo& create_info) {
@@ -9,6 +9,8 @@
 #include <lv2/urid/urid.h>
 #include <lv2/atom/forge.h>
 
+#include "../common/audio_tap.hpp"
+
 namespace Aether {
 
 	/*
@@ -24,6 +26,8 @@ namespace Aether {
 			std::filesystem::path bundle_path;
 			LV2UI_Controller controller;
 			LV2UI_Write_Function write_function;
+			// the tap of the dsp instance, nullptr if it is out of reach
+			AudioTap* audio_tap;
 		};
 
 		/*
@@ -75,6 +79,9 @@ namespace Aether {
 			LV2_URID sample_count;
 			LV2_URID peaks;
 
+			LV2_URID profile_data;
+			LV2_URID profile_stats;
+
 			LV2_URID sample_data;
 			LV2_URID rate;
 			LV2_URID channel;
@@ -88,6 +95,9 @@ namespace Aether {
 		LV2UI_Write_Function m_write_function;
 		LV2UI_Controller m_controller;
 
+		// the samples are read from here instead of atoms, nullptr if unavailable
+		AudioTap* m_audio_tap;
+
 		class View;
 		View* m_view;
 
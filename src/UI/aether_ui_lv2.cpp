@@ -6,9 +6,14 @@
 
 // LV2
 #include <lv2/core/lv2.h>
+#include <lv2/data-access/data-access.h>
+#include <lv2/instance-access/instance-access.h>
 #include <lv2/ui/ui.h>
 #include <lv2/urid/urid.h>
 
+#include "../common/audio_tap.hpp"
+#include "../common/uris.hpp"
+#include "../common/utils.hpp"
 #include "aether_ui.hpp"
 
 /**
@@ -31,6 +36,8 @@ static LV2UI_Handle instantiate_ui(
 	void* parent = nullptr;
 	LV2UI_Resize* resize = nullptr;
 	LV2_URID_Map* map = nullptr;
+	LV2_Handle instance = nullptr;
+	const LV2_Extension_Data_Feature* data_access = nullptr;
 
 	for (std::size_t i = 0; features[i]; ++i) {
 		if (std::string(features[i]->URI) == std::string(LV2_UI__parent))
@@ -39,6 +46,19 @@ static LV2UI_Handle instantiate_ui(
 			resize = static_cast<LV2UI_Resize*>(features[i]->data);
 		else if (std::string(features[i]->URI) == std::string(LV2_URID__map))
 			map = static_cast<LV2_URID_Map*>(features[i]->data);
+		else if (std::string(features[i]->URI) == std::string(LV2_INSTANCE_ACCESS_URI))
+			instance = features[i]->data;
+		else if (std::string(features[i]->URI) == std::string(LV2_DATA_ACCESS_URI))
+			data_access = static_cast<const LV2_Extension_Data_Feature*>(features[i]->data);
+	}
+
+	// the samples are read straight from the dsp when it runs in the same process
+	Aether::AudioTap* audio_tap = nullptr;
+	if (instance && data_access) {
+		const auto tap = static_cast<const Aether::AudioTapInterface*>(
+			data_access->data_access(join_v<Aether::uri::plugin, Aether::uri::audio_tap>));
+		if (tap)
+			audio_tap = tap->audio_tap(instance);
 	}
 
 	try {
@@ -46,7 +66,8 @@ static LV2UI_Handle instantiate_ui(
 			.parent = parent,
 			.bundle_path = bundle_path,
 			.controller = controller,
-			.write_function = write_function
+			.write_function = write_function,
+			.audio_tap = audio_tap
 		};
 		auto ui = std::make_unique<Aether::UI>(create_info, map);
 
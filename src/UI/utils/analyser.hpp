@@ -0,0 +1,113 @@
+#pragma once
+/*
+	Short time spectra of the stereo input and output of the dsp
+
+	A stream gets a new spectrum of its latest window once a hop of new
+	samples has arrived since its last one, so nothing is transformed
+	while no audio arrives however often the ui is drawn
+*/
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../../common/bit_ops.hpp"
+#include "../../common/constants.hpp"
+#include "fft.hpp"
+#include "sample_history.hpp"
+
+namespace Aether {
+
+	class SpectrumAnalyser {
+	public:
+		static constexpr size_t streams = 2;
+		static constexpr size_t channels = 2;
+
+		// range of the display, the 3 dB/oct tilt is 0 dB at its geometric middle
+		static constexpr float freq_min = 15.f;
+		static constexpr float freq_max = 22000.f;
+		static constexpr float tilt_db_per_octave = 3.f;
+
+		// consecutive windows overlap by all but 1/overlap of their length
+		static constexpr size_t overlap = 4;
+
+		uint32_t rate() const noexcept { return m_rate; }
+		// the window covers a tenth of a second, 0 before the rate is set
+		size_t size() const noexcept { return m_plan.size(); }
+		size_t hop() const noexcept { return size() / overlap; }
+		float bin_size() const noexcept { return static_cast<float>(m_rate) / static_cast<float>(size()); }
+
+		// starts over with silence for audio at rate
+		void set_rate(uint32_t rate) {
+			m_rate = rate;
+			const size_t size = bits::bit_ceil(rate / 10);
+
+			m_plan = fft::Plan(size);
+			m_frame.resize(size);
+			for (auto& history : m_histories)
+				history.resize(size);
+			for (auto& spectrum : m_spectra)
+				spectrum.assign(size/2, 0.f);
+			m_new_samples = {};
+
+			const float middle_freq = freq_min * std::sqrt(freq_max/freq_min);
+			const float exponent = tilt_db_per_octave/20.f * constants::log2_10_v<float>;
+			m_tilt.resize(size/2);
+			m_tilt[0] = 1.f;
+			for (size_t i = 1; i < m_tilt.size(); ++i)
+				m_tilt[i] = std::pow(static_cast<float>(i) * bin_size() / middle_freq, exponent);
+		}
+
+		void push(size_t stream, const float* l_samples, const float* r_samples, size_t n_samples) noexcept {
+			m_histories[channels*stream+0].push(l_samples, n_samples);
+			m_histories[channels*stream+1].push(r_samples, n_samples);
+			m_new_samples[stream] += n_samples;
+		}
+
+		// number of hops that have arrived since the last spectrum of stream
+		size_t frames_available(size_t stream) const noexcept {
+			return size() ? m_new_samples[stream] / hop() : 0;
+		}
+
+		/*
+			Computes the spectra of the latest window of stream if a frame
+			is available and returns whether it did. Older frames that
+			were not taken in time are skipped
+		*/
+		bool update(size_t stream) noexcept {
+			const size_t frames = frames_available(stream);
+			if (!frames) return false;
+			m_new_samples[stream] -= frames*hop();
+
+			for (size_t channel = 0; channel < channels; ++channel) {
+				auto& spectrum = m_spectra[channels*stream+channel];
+				m_histories[channels*stream+channel].linearize(m_frame.data());
+				m_plan.spectrum(m_frame.data(), spectrum.data());
+				for (size_t i = 0; i < spectrum.size(); ++i)
+					spectrum[i] *= m_tilt[i];
+			}
+			return true;
+		}
+
+		// tilted magnitudes of the size()/2 bins from the latest update
+		const std::vector<float>& spectrum(size_t stream, size_t channel) const noexcept {
+			return m_spectra[channels*stream+channel];
+		}
+
+	private:
+		uint32_t m_rate = 0;
+		fft::Plan m_plan = {};
+
+		std::array<SampleHistory, streams*channels> m_histories = {};
+		std::array<std::vector<float>, streams*channels> m_spectra = {};
+		// samples of each stream that have not been covered by a hop yet
+		std::array<size_t, streams> m_new_samples = {};
+
+		// gain of the tilt for every bin
+		std::vector<float> m_tilt = {};
+		// the linearized history being transformed
+		std::vector<float> m_frame = {};
+	};
+}
@@ -1,7 +1,10 @@
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <complex>
 #include <cstddef>
 #include <cstdint>
+#include <vector>
 
 #include "../../common/constants.hpp"
 #include "../../common/bit_ops.hpp"
@@ -134,4 +137,181 @@ namespace fft {
 
 		std::copy(container.end()-size/2, container.end(), container.begin()+size/2);
 	}
+
+	/*
+		Precomputed tables for the windowed magnitude spectrum of real
+		inputs of one size, giving the same result as window_function
+		followed by magnitudes
+
+		The size/2 point complex fft of the even and odd samples runs in
+		radix 4 stages, after one radix 2 stage if log2(size/2) is odd,
+		over separate arrays of real and imaginary parts so that the
+		butterflies vectorize. The bit reversal is a table lookup made
+		while the windowed input is loaded
+	*/
+	class Plan {
+	public:
+		Plan() = default;
+
+		// size is a power of two of at least 8
+		explicit Plan(size_t size) :
+			m_size{size},
+			m_bit_reversed(size/2),
+			m_window(size),
+			m_re(size/2),
+			m_im(size/2),
+			m_split_re(size/2),
+			m_split_im(size/2)
+		{
+			assert(bits::has_single_bit(size) && size >= 8);
+			const size_t half = size/2;
+			const auto half_bits = static_cast<uint8_t>(bits::countr_zero(half));
+			for (size_t i = 0; i < half; ++i)
+				m_bit_reversed[i] = static_cast<uint32_t>(reverseBits(i, half_bits));
+
+			// the window of window_function, normalized so as not to reduce the volume
+			double sum = 0.0;
+			for (size_t i = 0; i < size; ++i) {
+				const double s = std::sin(constants::pi * static_cast<double>(i+1) / static_cast<double>(size-1));
+				m_window[i] = static_cast<float>(s*s);
+				sum += s*s;
+			}
+			const auto normalize = static_cast<float>(static_cast<double>(size) / sum);
+			for (float& w : m_window)
+				w *= normalize;
+
+			m_radix2 = half_bits % 2;
+			for (size_t span = m_radix2 ? 2 : 1; span < half; span *= 4) {
+				// w^j, w^2j and w^3j for a butterfly 4 spans wide
+				std::vector<float> twiddles(6*span);
+				for (size_t j = 0; j < span; ++j) {
+					for (size_t p = 1; p <= 3; ++p) {
+						const double angle = -2*constants::pi * static_cast<double>(p*j) / static_cast<double>(4*span);
+						twiddles[(2*p-2)*span + j] = static_cast<float>(std::cos(angle));
+						twiddles[(2*p-1)*span + j] = static_cast<float>(std::sin(angle));
+					}
+				}
+				m_stages.push_back({span, std::move(twiddles)});
+			}
+
+			for (size_t k = 0; k < half; ++k) {
+				const double angle = -2*constants::pi * static_cast<double>(k) / static_cast<double>(size);
+				m_split_re[k] = static_cast<float>(std::cos(angle));
+				m_split_im[k] = static_cast<float>(std::sin(angle));
+			}
+		}
+
+		size_t size() const noexcept { return m_size; }
+
+		/*
+			windows size samples of input and writes the magnitudes of
+			the first size/2 bins to output, which may be input
+		*/
+		void spectrum(const float* input, float* output) noexcept {
+			const size_t half = m_size/2;
+			float* const re = m_re.data();
+			float* const im = m_im.data();
+
+			// the even samples are the real parts and the odd ones the imaginary parts
+			for (size_t i = 0; i < half; ++i) {
+				const uint32_t j = m_bit_reversed[i];
+				re[j] = input[2*i+0] * m_window[2*i+0];
+				im[j] = input[2*i+1] * m_window[2*i+1];
+			}
+
+			if (m_radix2) {
+				for (size_t i = 0; i < half; i += 2) {
+					const float ar = re[i], ai = im[i];
+					const float br = re[i+1], bi = im[i+1];
+					re[i] = ar + br; im[i] = ai + bi;
+					re[i+1] = ar - br; im[i+1] = ai - bi;
+				}
+			}
+
+			for (const Stage& stage : m_stages)
+				radix4(stage);
+
+			// splits the transform into that of the even and odd samples and combines them
+			const float scale = 1.f / static_cast<float>(m_size);
+			output[0] = std::abs(re[0] + im[0]) * scale;
+			for (size_t k = 1; k < half; ++k) {
+				const float yr = re[k], yi = im[k];
+				const float zr = re[half-k], zi = im[half-k];
+
+				const float even_r = 0.5f*(yr + zr);
+				const float even_i = 0.5f*(yi - zi);
+				const float odd_r = 0.5f*(yi + zi);
+				const float odd_i = -0.5f*(yr - zr);
+
+				const float wr = m_split_re[k], wi = m_split_im[k];
+				const float xr = even_r + wr*odd_r - wi*odd_i;
+				const float xi = even_i + wr*odd_i + wi*odd_r;
+				output[k] = std::sqrt(xr*xr + xi*xi) * scale;
+			}
+		}
+
+	private:
+		struct Stage {
+			size_t span;
+			std::vector<float> twiddles;
+		};
+
+		/*
+			combines the transforms of each group of 4 consecutive spans,
+			which in bit reversed order hold the samples 0, 2, 1 and 3 mod 4
+		*/
+		void radix4(const Stage& stage) noexcept {
+			const size_t h = stage.span;
+			const float* const w1r = stage.twiddles.data();
+			const float* const w1i = w1r + h;
+			const float* const w2r = w1i + h;
+			const float* const w2i = w2r + h;
+			const float* const w3r = w2i + h;
+			const float* const w3i = w3r + h;
+
+			for (size_t g = 0; g < m_size/2; g += 4*h) {
+				float* __restrict const ar = m_re.data() + g;
+				float* __restrict const ai = m_im.data() + g;
+				float* __restrict const br = ar + h;
+				float* __restrict const bi = ai + h;
+				float* __restrict const cr = br + h;
+				float* __restrict const ci = bi + h;
+				float* __restrict const dr = cr + h;
+				float* __restrict const di = ci + h;
+
+				for (size_t j = 0; j < h; ++j) {
+					// b holds the samples 2 mod 4 and c those 1 mod 4
+					const float Br = br[j]*w2r[j] - bi[j]*w2i[j];
+					const float Bi = br[j]*w2i[j] + bi[j]*w2r[j];
+					const float Cr = cr[j]*w1r[j] - ci[j]*w1i[j];
+					const float Ci = cr[j]*w1i[j] + ci[j]*w1r[j];
+					const float Dr = dr[j]*w3r[j] - di[j]*w3i[j];
+					const float Di = dr[j]*w3i[j] + di[j]*w3r[j];
+
+					const float s0r = ar[j] + Br, s0i = ai[j] + Bi;
+					const float s1r = ar[j] - Br, s1i = ai[j] - Bi;
+					const float t0r = Cr + Dr, t0i = Ci + Di;
+					const float t1r = Cr - Dr, t1i = Ci - Di;
+
+					ar[j] = s0r + t0r; ai[j] = s0i + t0i;
+					cr[j] = s0r - t0r; ci[j] = s0i - t0i;
+					// s1 -/+ i*t1
+					br[j] = s1r + t1i; bi[j] = s1i - t1r;
+					dr[j] = s1r - t1i; di[j] = s1i + t1r;
+				}
+			}
+		}
+
+		size_t m_size = 0;
+		bool m_radix2 = false;
+		std::vector<uint32_t> m_bit_reversed = {};
+		std::vector<float> m_window = {};
+		std::vector<Stage> m_stages = {};
+		// the complex transform of size/2 points
+		std::vector<float> m_re = {};
+		std::vector<float> m_im = {};
+		// e^(-2pi*i*k/size)
+		std::vector<float> m_split_re = {};
+		std::vector<float> m_split_im = {};
+	};
 }
@@ -0,0 +1,48 @@
+#pragma once
+/*
+	The latest samples of an audio channel, kept in a circular buffer so
+	that adding samples costs the same whatever the length of the history
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace Aether {
+
+	class SampleHistory {
+	public:
+		size_t size() const noexcept { return m_samples.size(); }
+
+		// holds the latest size samples from now on, all zero to start with
+		void resize(size_t size) {
+			m_samples.assign(size, 0.f);
+			m_end = 0;
+		}
+
+		void push(const float* samples, size_t n) noexcept {
+			const size_t size = m_samples.size();
+			if (n >= size) {
+				std::copy_n(samples + n - size, size, m_samples.data());
+				m_end = 0;
+				return;
+			}
+
+			const size_t len = std::min(n, size - m_end);
+			std::copy_n(samples, len, m_samples.data() + m_end);
+			std::copy_n(samples + len, n - len, m_samples.data());
+			m_end = (m_end + n) % size;
+		}
+
+		// copies the history into out oldest sample first, out must hold size() samples
+		void linearize(float* out) const noexcept {
+			out = std::copy_n(m_samples.data() + m_end, m_samples.size() - m_end, out);
+			std::copy_n(m_samples.data(), m_end, out);
+		}
+
+	private:
+		std::vector<float> m_samples = {};
+		// where the next sample goes, which is also the oldest one
+		size_t m_end = 0;
+	};
+}
@@ -0,0 +1,134 @@
+#ifndef AUDIO_TAP_HPP
+#define AUDIO_TAP_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// LV2
+#include <lv2/core/lv2.h>
+
+#include "bit_ops.hpp"
+
+namespace Aether {
+
+	/*
+		Lock free single producer single consumer rings through which the
+		dsp hands its input and output to a ui running in the same process
+
+		The dsp writes whatever fits and drops the rest, the ui reads
+		everything written since it last did. Only one reader can be
+		attached at a time. Shared by the dsp and ui libraries, so it
+		must not depend on the instruction set either is compiled for
+	*/
+	class AudioTap {
+	public:
+		static constexpr size_t streams = 2;
+
+		// holds at least capacity samples per channel of audio at rate
+		AudioTap(size_t capacity, int32_t rate) :
+			m_capacity{bits::bit_ceil(capacity)},
+			m_mask{m_capacity-1},
+			m_rate{rate}
+		{
+			// left then right
+			for (Ring& ring : m_rings)
+				ring.samples = std::make_unique<float[]>(2*m_capacity);
+		}
+
+		AudioTap(const AudioTap&) = delete;
+		AudioTap& operator=(const AudioTap&) = delete;
+
+		size_t capacity() const noexcept { return m_capacity; }
+		int32_t rate() const noexcept { return m_rate; }
+
+		// returns false if another reader is attached already
+		bool attach() noexcept {
+			bool expected = false;
+			if (!m_attached.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+				return false;
+
+			// samples written while nobody was reading are skipped
+			for (Ring& ring : m_rings)
+				ring.read.store(ring.write.load(std::memory_order_acquire), std::memory_order_release);
+			return true;
+		}
+
+		void detach() noexcept { m_attached.store(false, std::memory_order_release); }
+		bool attached() const noexcept { return m_attached.load(std::memory_order_acquire); }
+
+		// writer side
+		size_t space(size_t stream) const noexcept {
+			const Ring& ring = m_rings[stream];
+			return m_capacity - (ring.write.load(std::memory_order_relaxed) - ring.read.load(std::memory_order_acquire));
+		}
+
+		// writes up to n samples per channel and returns how many fit
+		size_t write(size_t stream, const float* left, const float* right, size_t n) noexcept {
+			Ring& ring = m_rings[stream];
+			const size_t write = ring.write.load(std::memory_order_relaxed);
+			n = std::min(n, space(stream));
+
+			const size_t start = write & m_mask;
+			const size_t len = std::min(n, m_capacity - start);
+			float* const l = ring.samples.get();
+			float* const r = l + m_capacity;
+			std::copy_n(left, len, l + start);
+			std::copy_n(left + len, n - len, l);
+			std::copy_n(right, len, r + start);
+			std::copy_n(right + len, n - len, r);
+
+			ring.write.store(write + n, std::memory_order_release);
+			return n;
+		}
+
+		/*
+			reader side
+			Calls f(left, right, n) with the unread samples of stream in
+			at most two contiguous pieces and returns how many there were
+		*/
+		template <class F>
+		size_t read(size_t stream, F&& f) {
+			Ring& ring = m_rings[stream];
+			const size_t read = ring.read.load(std::memory_order_relaxed);
+			const size_t n = ring.write.load(std::memory_order_acquire) - read;
+
+			const size_t start = read & m_mask;
+			const size_t len = std::min(n, m_capacity - start);
+			const float* const l = ring.samples.get();
+			const float* const r = l + m_capacity;
+			if (len)
+				f(l + start, r + start, len);
+			if (n - len)
+				f(l, r, n - len);
+
+			ring.read.store(read + n, std::memory_order_release);
+			return n;
+		}
+
+	private:
+		// the indices only ever increase and are wrapped with m_mask
+		struct Ring {
+			std::unique_ptr<float[]> samples;
+			alignas(64) std::atomic<size_t> write = 0;
+			alignas(64) std::atomic<size_t> read = 0;
+		};
+
+		std::array<Ring, streams> m_rings = {};
+		size_t m_capacity;
+		size_t m_mask;
+		int32_t m_rate;
+		std::atomic<bool> m_attached = false;
+	};
+
+	// extension data through which the ui finds the tap of an instance
+	struct AudioTapInterface {
+		// lives as long as the instance
+		AudioTap* (*audio_tap)(LV2_Handle instance);
+	};
+}
+
+#endif
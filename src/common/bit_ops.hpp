@@ -9,6 +9,9 @@
 	#include <bit>
 #endif
 
+#include <cstring>
+#include <type_traits>
+
 namespace bits {
 
 #if __cpp_lib_int_pow2 == 202002L
@@ -45,6 +48,11 @@ namespace bits {
 	constexpr int countr_zero(T x) {
 		return std::countr_zero(static_cast<std::make_unsigned_t<T>>(x));
 	}
+
+	template <class T>
+	constexpr int bit_width(T x) {
+		return static_cast<int>(std::bit_width(static_cast<std::make_unsigned_t<T>>(x)));
+	}
 #else
 	template <class T>
 	constexpr int countr_zero(T x) {
@@ -55,6 +63,30 @@ namespace bits {
 		}
 		return count;
 	}
+
+	template <class T>
+	constexpr int bit_width(T x) {
+		int width = 0;
+		for (; x; x >>= 1)
+			++width;
+		return width;
+	}
+#endif
+
+
+#if __cpp_lib_bit_cast >= 201806L
+	template <class To, class From>
+	constexpr To bit_cast(const From& x) noexcept {
+		return std::bit_cast<To>(x);
+	}
+#else
+	template <class To, class From>
+	inline To bit_cast(const From& x) noexcept {
+		static_assert(sizeof(To) == sizeof(From));
+		To y;
+		std::memcpy(&y, &x, sizeof(y));
+		return y;
+	}
 #endif
 }
 
@@ -9,6 +9,14 @@ namespace constants {
 	template <typename T>
 	inline constexpr T pi_v = T(3.141592653589793238462643383279502884l);
 	inline constexpr double pi = pi_v<double>;
+
+	template <typename T>
+	inline constexpr T log2e_v = T(1.442695040888963407359924681001892137l);
+	inline constexpr double log2e = log2e_v<double>;
+
+	template <typename T>
+	inline constexpr T log2_10_v = T(3.321928094887362347870319429489390175l);
+	inline constexpr double log2_10 = log2_10_v<double>;
 }
 
 #endif
@@ -0,0 +1,41 @@
+#ifndef URIS_HPP
+#define URIS_HPP
+
+#include <array>
+#include <string_view>
+
+/*
+	URIs of the plugin and of the messages its dsp and ui exchange,
+	everything but plugin is appended to plugin. Shared by the dsp and
+	ui libraries, so the ui does not need any of the dsp headers
+*/
+namespace Aether::uri {
+	inline constexpr std::string_view plugin = "http://github.com/Dougal-s/Aether";
+
+	inline constexpr std::string_view ui_open = "#uiOpen";
+	inline constexpr std::string_view ui_close = "#uiClose";
+
+	inline constexpr std::string_view peak_data = "#peakData";
+	inline constexpr std::string_view sample_count = "#sampleCount";
+	inline constexpr std::string_view peaks = "#peaks";
+
+	inline constexpr std::string_view profile_data = "#profileData";
+	inline constexpr std::string_view profile_stats = "#profileStats";
+	// stages whose minimum, average, 99th percentile and maximum time in
+	// microseconds profile_stats holds, in this order
+	inline constexpr std::array<std::string_view, 9> profile_stages = {
+		"parameters", "predelay", "early_filters", "multitap",
+		"early_diffuser", "late", "mix", "metering", "atoms"
+	};
+
+	inline constexpr std::string_view sample_data = "#sampleData";
+	inline constexpr std::string_view rate = "#rate";
+	inline constexpr std::string_view channel = "#channel";
+	inline constexpr std::string_view l_samples = "#lSamples";
+	inline constexpr std::string_view r_samples = "#rSamples";
+
+	// extension data holding an AudioTapInterface
+	inline constexpr std::string_view audio_tap = "#audioTap";
+}
+
+#endif
@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "audio_file.hpp"
+#include "preset.hpp"
+
+#include "DSP/engine.hpp"
+#include "DSP/architecture.hpp"
+
+/*
+	Renders audio files through the dsp without an lv2 host,
+	one file per worker thread at a time
+*/
+
+namespace {
+	constexpr std::string_view usage =
+		"usage: aether_render [options] -o <directory> <files...>\n"
+		"\n"
+		"Processes every file with the same parameters and writes the result\n"
+		"as 32 bit float stereo to a file of the same name in <directory>\n"
+		"\n"
+		"options:\n"
+		"  -o, --output <directory>  where the rendered files are written\n"
+		"  -p, --preset <file>       json object or name=value lines of parameters\n"
+		"  -s, --set <name=value>    sets a parameter after the preset, repeatable\n"
+		"  -j, --jobs <n>            files rendered in parallel, defaults to the core count\n"
+		"  -t, --tail <seconds>      longest reverb tail appended to each file, default 10\n"
+		"                            rendering stops once the tail has decayed\n"
+		"  -r, --rate <hz>           sample rate of .raw and .f32 files (interleaved\n"
+		"                            stereo floats), default 48000\n"
+		"  -l, --list                lists the parameter names and defaults\n"
+		"  -h, --help                shows this message\n";
+
+	struct Options {
+		std::filesystem::path output = {};
+		Render::Preset preset = Render::default_preset();
+		unsigned jobs = std::max(1u, std::thread::hardware_concurrency());
+		float tail = 10.f;
+		float raw_rate = 48000.f;
+		std::vector<std::filesystem::path> inputs = {};
+	};
+
+	// samples handed to the engine per call
+	constexpr uint32_t block_size = 4096;
+
+	float parse_number(std::string_view option, const std::string& value) {
+		char* end = nullptr;
+		const float number = std::strtof(value.c_str(), &end);
+		if (value.empty() || end != value.c_str() + value.size() || number < 0.f)
+			throw std::runtime_error("invalid value `" + value + "` for " + std::string(option));
+		return number;
+	}
+
+	std::string read_text(const std::filesystem::path& path) {
+		std::ifstream file(path);
+		if (!file) throw std::runtime_error(path.string() + ": cannot open file");
+		return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+	}
+
+	/*
+		Returns false if the program should exit without rendering
+		Throws std::runtime_error on invalid arguments
+	*/
+	bool parse_options(int argc, char** argv, Options& options) {
+		for (int i = 1; i < argc; ++i) {
+			const std::string_view arg = argv[i];
+			const auto value = [&]() -> std::string {
+				if (i + 1 >= argc)
+					throw std::runtime_error("missing value for " + std::string(arg));
+				return argv[++i];
+			};
+
+			if (arg == "-h" || arg == "--help") {
+				std::fputs(usage.data(), stdout);
+				return false;
+			} else if (arg == "-l" || arg == "--list") {
+				const Render::Preset defaults = Render::default_preset();
+				for (size_t p = 0; p < defaults.size(); ++p)
+					std::printf("%s=%g\n", Render::parameter_names[p].data(), static_cast<double>(defaults[p]));
+				return false;
+			} else if (arg == "-o" || arg == "--output") {
+				options.output = value();
+			} else if (arg == "-p" || arg == "--preset") {
+				const std::string path = value();
+				try {
+					Render::parse_preset(read_text(path), options.preset);
+				} catch (const std::runtime_error& e) {
+					throw std::runtime_error(path + ": " + e.what());
+				}
+			} else if (arg == "-s" || arg == "--set") {
+				Render::parse_assignment(value(), options.preset);
+			} else if (arg == "-j" || arg == "--jobs") {
+				options.jobs = std::max(1u, static_cast<unsigned>(parse_number(arg, value())));
+			} else if (arg == "-t" || arg == "--tail") {
+				options.tail = parse_number(arg, value());
+			} else if (arg == "-r" || arg == "--rate") {
+				options.raw_rate = parse_number(arg, value());
+			} else if (arg.size() > 1 && arg[0] == '-') {
+				throw std::runtime_error("unknown option " + std::string(arg));
+			} else {
+				options.inputs.emplace_back(arg);
+			}
+		}
+
+		if (options.output.empty())
+			throw std::runtime_error("no output directory given");
+		if (options.inputs.empty())
+			throw std::runtime_error("no input files given");
+		return true;
+	}
+
+	// processes the audio and appends a tail of up to tail_seconds
+	void render(const Render::Preset& preset, float tail_seconds, Render::Audio& audio) {
+		const size_t length = audio.left.size();
+		const auto max_tail = static_cast<size_t>(tail_seconds*audio.rate);
+		audio.left.resize(length + max_tail, 0.f);
+		audio.right.resize(length + max_tail, 0.f);
+
+		// the variants are loaded from where they were built
+		auto engine = Aether::create_engine(Aether::select_isa(), audio.rate, nullptr, AETHER_ISA_MODULE_DIR);
+
+		// the misc ports precede the parameters, see Engine::connect_port
+		constexpr uint32_t misc_ports = 6;
+		for (uint32_t p = 0; p < preset.size(); ++p)
+			engine->connect_port(misc_ports + p, const_cast<float*>(&preset[p]));
+		engine->reset_parameters();
+
+		// processed in place
+		size_t pos = 0;
+		while (pos < audio.left.size()) {
+			if (pos >= length && engine->sleeping()) break;
+
+			const auto n = static_cast<uint32_t>(std::min<size_t>(block_size, audio.left.size() - pos));
+			engine->connect_port(2, audio.left.data() + pos);
+			engine->connect_port(3, audio.right.data() + pos);
+			engine->connect_port(4, audio.left.data() + pos);
+			engine->connect_port(5, audio.right.data() + pos);
+			engine->process(n);
+			pos += n;
+		}
+
+		audio.left.resize(pos);
+		audio.right.resize(pos);
+	}
+
+	// the progress of every worker
+	struct Batch {
+		const Options& options;
+		std::atomic<size_t> next = 0;
+		std::atomic<size_t> failed = 0;
+		// length of the rendered files, guarded by output_mutex
+		double seconds = 0;
+		std::mutex output_mutex = {};
+	};
+
+	void work(Batch& batch) {
+	#ifdef FORCE_DISABLE_DENORMALS
+		disable_denormals();
+	#endif
+
+		const Options& options = batch.options;
+		for (size_t i = batch.next++; i < options.inputs.size(); i = batch.next++) {
+			const std::filesystem::path& input = options.inputs[i];
+			const std::filesystem::path output = options.output / input.filename();
+			try {
+				std::error_code ec;
+				if (std::filesystem::equivalent(input, output, ec))
+					throw std::runtime_error(input.string() + ": would overwrite the input");
+
+				Render::Audio audio = Render::read_audio(input, options.raw_rate);
+				render(options.preset, options.tail, audio);
+				Render::write_audio(output, audio);
+
+				std::lock_guard lock(batch.output_mutex);
+				batch.seconds += static_cast<double>(audio.left.size()) / static_cast<double>(audio.rate);
+			} catch (const std::exception& e) {
+				++batch.failed;
+				std::lock_guard lock(batch.output_mutex);
+				std::fprintf(stderr, "error: %s\n", e.what());
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	Options options;
+	try {
+		if (!parse_options(argc, argv, options))
+			return EXIT_SUCCESS;
+		std::filesystem::create_directories(options.output);
+	} catch (const std::exception& e) {
+		std::fprintf(stderr, "error: %s\n\n%s", e.what(), usage.data());
+		return EXIT_FAILURE;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+
+	Batch batch{options};
+	const auto jobs = static_cast<unsigned>(std::min<size_t>(options.jobs, options.inputs.size()));
+	std::vector<std::thread> workers;
+	for (unsigned i = 1; i < jobs; ++i)
+		workers.emplace_back(work, std::ref(batch));
+	work(batch);
+	for (auto& worker : workers)
+		worker.join();
+
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	std::fprintf(stderr, "rendered %zu of %zu files, %.1f s of audio in %.1f s (%.0fx real time)\n",
+		options.inputs.size() - batch.failed, options.inputs.size(),
+		batch.seconds, elapsed.count(), batch.seconds / elapsed.count());
+
+	return batch.failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "audio_file.hpp"
+
+namespace Render {
+
+	namespace {
+		constexpr uint16_t format_pcm = 1;
+		constexpr uint16_t format_float = 3;
+		constexpr uint16_t format_extensible = 0xfffe;
+
+		[[noreturn]] void fail(const std::filesystem::path& path, const std::string& what) {
+			throw std::runtime_error(path.string() + ": " + what);
+		}
+
+		std::vector<uint8_t> read_file(const std::filesystem::path& path) {
+			std::ifstream file(path, std::ios::binary);
+			if (!file) fail(path, "cannot open file");
+			return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+		}
+
+		// little endian reads and writes independent of the host
+		uint32_t read_le(const uint8_t* data, size_t bytes) noexcept {
+			uint32_t value = 0;
+			for (size_t i = 0; i < bytes; ++i)
+				value |= uint32_t{data[i]} << (8*i);
+			return value;
+		}
+
+		void write_le(std::vector<uint8_t>& out, uint32_t value, size_t bytes) {
+			for (size_t i = 0; i < bytes; ++i)
+				out.push_back(static_cast<uint8_t>(value >> (8*i)));
+		}
+
+		float read_float(const uint8_t* data) noexcept {
+			const uint32_t bits = read_le(data, 4);
+			float value;
+			std::memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+
+		double read_double(const uint8_t* data) noexcept {
+			const uint64_t bits = read_le(data, 4) | uint64_t{read_le(data + 4, 4)} << 32;
+			double value;
+			std::memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+
+		void write_float(std::vector<uint8_t>& out, float value) {
+			uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			write_le(out, bits, 4);
+		}
+
+		// one sample of the given format scaled to [-1, 1)
+		float read_sample(const uint8_t* data, uint16_t format, uint16_t bits) noexcept {
+			if (format == format_float)
+				return bits == 32 ? read_float(data) : static_cast<float>(read_double(data));
+
+			// sign extend from the top of a 32 bit integer
+			const auto value = static_cast<int32_t>(read_le(data, bits/8u) << (32u - bits));
+			return static_cast<float>(static_cast<double>(value) / 2147483648.0);
+		}
+
+		Audio read_wav(const std::filesystem::path& path, const std::vector<uint8_t>& file) {
+			if (file.size() < 12
+				|| std::memcmp(file.data(), "RIFF", 4) != 0
+				|| std::memcmp(file.data() + 8, "WAVE", 4) != 0)
+				fail(path, "not a wav file");
+
+			uint16_t format = 0;
+			uint16_t channels = 0;
+			uint32_t rate = 0;
+			uint16_t bits = 0;
+			const uint8_t* samples = nullptr;
+			size_t sample_bytes = 0;
+
+			// chunks are padded to an even size
+			for (size_t pos = 12; pos + 8 <= file.size();) {
+				const uint8_t* chunk = file.data() + pos;
+				const size_t size = std::min<size_t>(read_le(chunk + 4, 4), file.size() - pos - 8);
+
+				if (std::memcmp(chunk, "fmt ", 4) == 0) {
+					if (size < 16) fail(path, "invalid fmt chunk");
+					format = static_cast<uint16_t>(read_le(chunk + 8, 2));
+					channels = static_cast<uint16_t>(read_le(chunk + 10, 2));
+					rate = read_le(chunk + 12, 4);
+					bits = static_cast<uint16_t>(read_le(chunk + 22, 2));
+					// the sub format guid starts with the format tag
+					if (format == format_extensible && size >= 26)
+						format = static_cast<uint16_t>(read_le(chunk + 32, 2));
+				} else if (std::memcmp(chunk, "data", 4) == 0) {
+					samples = chunk + 8;
+					sample_bytes = size;
+				}
+
+				pos += 8 + size + (size & 1);
+			}
+
+			if (!samples) fail(path, "missing data chunk");
+			if (rate == 0) fail(path, "invalid sample rate");
+			if (channels != 1 && channels != 2)
+				fail(path, std::to_string(channels) + " channels, only mono and stereo are supported");
+			const bool supported = (format == format_pcm && (bits == 16 || bits == 24 || bits == 32))
+				|| (format == format_float && (bits == 32 || bits == 64));
+			if (!supported)
+				fail(path, "unsupported sample format " + std::to_string(format) + " with " + std::to_string(bits) + " bits");
+
+			const size_t frame_bytes = size_t{channels} * (bits/8u);
+			const size_t frames = sample_bytes / frame_bytes;
+
+			Audio audio;
+			audio.rate = static_cast<float>(rate);
+			audio.left.resize(frames);
+			audio.right.resize(frames);
+			for (size_t i = 0; i < frames; ++i) {
+				const uint8_t* frame = samples + i*frame_bytes;
+				audio.left[i] = read_sample(frame, format, bits);
+				audio.right[i] = channels == 2 ? read_sample(frame + bits/8u, format, bits) : audio.left[i];
+			}
+			return audio;
+		}
+
+		Audio read_raw(const std::filesystem::path& path, const std::vector<uint8_t>& file, float rate) {
+			if (rate <= 0.f) fail(path, "raw files need a sample rate");
+
+			const size_t frames = file.size() / (2*sizeof(float));
+			Audio audio;
+			audio.rate = rate;
+			audio.left.resize(frames);
+			audio.right.resize(frames);
+			for (size_t i = 0; i < frames; ++i) {
+				audio.left[i] = read_float(file.data() + 8*i);
+				audio.right[i] = read_float(file.data() + 8*i + 4);
+			}
+			return audio;
+		}
+	}
+
+	bool is_raw(const std::filesystem::path& path) {
+		const auto extension = path.extension();
+		return extension == ".raw" || extension == ".f32";
+	}
+
+	Audio read_audio(const std::filesystem::path& path, float raw_rate) {
+		const std::vector<uint8_t> file = read_file(path);
+		return is_raw(path) ? read_raw(path, file, raw_rate) : read_wav(path, file);
+	}
+
+	void write_audio(const std::filesystem::path& path, const Audio& audio) {
+		const size_t frames = audio.left.size();
+		const size_t data_bytes = 2*sizeof(float)*frames;
+		if (data_bytes > UINT32_MAX - 36)
+			fail(path, "too long for a wav file");
+		const auto data_size = static_cast<uint32_t>(data_bytes);
+
+		std::vector<uint8_t> out;
+		out.reserve(44 + data_bytes);
+		if (!is_raw(path)) {
+			const auto rate = static_cast<uint32_t>(audio.rate);
+			constexpr std::string_view riff = "RIFF", wave = "WAVE", fmt = "fmt ", data = "data";
+
+			out.insert(out.end(), riff.begin(), riff.end());
+			write_le(out, 36 + data_size, 4);
+			out.insert(out.end(), wave.begin(), wave.end());
+
+			out.insert(out.end(), fmt.begin(), fmt.end());
+			write_le(out, 16, 4);
+			write_le(out, format_float, 2);
+			write_le(out, 2, 2);                   // channels
+			write_le(out, rate, 4);
+			write_le(out, rate*2*4, 4);             // bytes per second
+			write_le(out, 2*4, 2);                 // bytes per frame
+			write_le(out, 32, 2);                  // bits per sample
+
+			out.insert(out.end(), data.begin(), data.end());
+			write_le(out, data_size, 4);
+		}
+
+		for (size_t i = 0; i < frames; ++i) {
+			write_float(out, audio.left[i]);
+			write_float(out, audio.right[i]);
+		}
+
+		std::ofstream file(path, std::ios::binary);
+		file.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+		if (!file) fail(path, "failed to write file");
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+namespace Render {
+
+	// non interleaved stereo audio
+	struct Audio {
+		float rate = 0.f;
+		std::vector<float> left = {};
+		std::vector<float> right = {};
+	};
+
+	/*
+		.raw and .f32 files hold interleaved stereo 32 bit floats
+		and carry no sample rate, anything else is read as a wav file
+	*/
+	bool is_raw(const std::filesystem::path& path);
+
+	/*
+		Reads 16, 24 and 32 bit integer or 32 and 64 bit float wav files
+		with one or two channels, mono is copied to both channels.
+		raw_rate is the sample rate of raw files
+
+		Throws std::runtime_error if the file cannot be read
+	*/
+	Audio read_audio(const std::filesystem::path& path, float raw_rate);
+
+	// writes 32 bit float wav or raw files
+	void write_audio(const std::filesystem::path& path, const Audio& audio);
+}
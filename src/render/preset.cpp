@@ -0,0 +1,207 @@
+#include <cctype>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#include "preset.hpp"
+#include "../common/parameters.hpp"
+
+namespace Render {
+
+	const std::array<std::string_view, Preset::size()> parameter_names = {
+		"mix",
+
+		"dry_level",
+		"predelay_level",
+		"early_level",
+		"late_level",
+
+		"interpolate",
+
+		"width",
+		"predelay",
+
+		"early_low_cut_enabled",
+		"early_low_cut_cutoff",
+		"early_high_cut_enabled",
+		"early_high_cut_cutoff",
+		"early_taps",
+		"early_tap_length",
+		"early_tap_mix",
+		"early_tap_decay",
+		"early_diffusion_stages",
+		"early_diffusion_delay",
+		"early_diffusion_mod_depth",
+		"early_diffusion_mod_rate",
+		"early_diffusion_feedback",
+
+		"late_order",
+		"late_delay_lines",
+		"late_delay",
+		"late_delay_mod_depth",
+		"late_delay_mod_rate",
+		"late_delay_line_feedback",
+		"late_diffusion_stages",
+		"late_diffusion_delay",
+		"late_diffusion_mod_depth",
+		"late_diffusion_mod_rate",
+		"late_diffusion_feedback",
+		"late_low_shelf_enabled",
+		"late_low_shelf_cutoff",
+		"late_low_shelf_gain",
+		"late_high_shelf_enabled",
+		"late_high_shelf_cutoff",
+		"late_high_shelf_gain",
+		"late_high_cut_enabled",
+		"late_high_cut_cutoff",
+
+		"seed_crossmix",
+		"tap_seed",
+		"early_diffusion_seed",
+		"delay_seed",
+		"late_diffusion_seed",
+
+		"early_diffusion_drive",
+		"late_diffusion_drive"
+	};
+
+	namespace {
+		std::string_view trim(std::string_view str) noexcept {
+			while (!str.empty() && std::isspace(static_cast<unsigned char>(str.front())))
+				str.remove_prefix(1);
+			while (!str.empty() && std::isspace(static_cast<unsigned char>(str.back())))
+				str.remove_suffix(1);
+			return str;
+		}
+
+		float parse_value(std::string_view name, std::string_view value) {
+			if (value == "true") return 1.f;
+			if (value == "false") return 0.f;
+
+			const std::string str(value);
+			char* end = nullptr;
+			const float result = std::strtof(str.c_str(), &end);
+			if (str.empty() || end != str.c_str() + str.size())
+				throw std::runtime_error("invalid value `" + str + "` for `" + std::string(name) + "`");
+			return result;
+		}
+
+		void set_parameter(std::string_view name, std::string_view value, Preset& preset) {
+			const auto idx = parameter_index(name);
+			if (!idx)
+				throw std::runtime_error("unknown parameter `" + std::string(name) + "`");
+			preset[*idx] = parse_value(name, value);
+		}
+
+		// a flat object of names and numbers or booleans
+		class JsonParser {
+		public:
+			explicit JsonParser(std::string_view text) : m_text{text} {}
+
+			void parse(Preset& preset) {
+				expect('{');
+				if (peek() == '}') {
+					++m_pos;
+				} else {
+					do {
+						const std::string_view name = string();
+						expect(':');
+						set_parameter(name, value(), preset);
+					} while (accept(','));
+					expect('}');
+				}
+
+				if (peek() != '\0')
+					error("trailing characters");
+			}
+
+		private:
+			std::string_view m_text;
+			size_t m_pos = 0;
+
+			[[noreturn]] void error(const std::string& what) const {
+				throw std::runtime_error("json: " + what + " at offset " + std::to_string(m_pos));
+			}
+
+			// next non whitespace character, '\0' at the end
+			char peek() noexcept {
+				while (m_pos < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_pos])))
+					++m_pos;
+				return m_pos < m_text.size() ? m_text[m_pos] : '\0';
+			}
+
+			bool accept(char c) noexcept {
+				if (peek() != c) return false;
+				++m_pos;
+				return true;
+			}
+
+			void expect(char c) {
+				if (!accept(c))
+					error(std::string("expected `") + c + "`");
+			}
+
+			std::string_view string() {
+				expect('"');
+				const size_t end = m_text.find('"', m_pos);
+				if (end == std::string_view::npos)
+					error("unterminated string");
+				const std::string_view str = m_text.substr(m_pos, end - m_pos);
+				m_pos = end + 1;
+				return str;
+			}
+
+			std::string_view value() {
+				peek();
+				const size_t begin = m_pos;
+				while (m_pos < m_text.size() && m_text[m_pos] != ',' && m_text[m_pos] != '}')
+					++m_pos;
+				return trim(m_text.substr(begin, m_pos - begin));
+			}
+		};
+	}
+
+	std::optional<size_t> parameter_index(std::string_view name) noexcept {
+		for (size_t p = 0; p < parameter_names.size(); ++p)
+			if (parameter_names[p] == name) return p;
+		return std::nullopt;
+	}
+
+	Preset default_preset() noexcept {
+		Preset preset = {};
+		for (size_t p = 0; p < preset.size(); ++p)
+			preset[p] = parameter_infos[p+6].dflt;
+		return preset;
+	}
+
+	void parse_preset(std::string_view text, Preset& preset) {
+		if (trim(text).substr(0, 1) == "{") {
+			JsonParser(text).parse(preset);
+			return;
+		}
+
+		size_t line_number = 0;
+		while (!text.empty()) {
+			++line_number;
+			const size_t end = text.find('\n');
+			std::string_view line = text.substr(0, end);
+			text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+
+			line = trim(line.substr(0, line.find('#')));
+			if (line.empty()) continue;
+
+			try {
+				parse_assignment(line, preset);
+			} catch (const std::runtime_error& e) {
+				throw std::runtime_error("line " + std::to_string(line_number) + ": " + e.what());
+			}
+		}
+	}
+
+	void parse_assignment(std::string_view assignment, Preset& preset) {
+		const size_t eq = assignment.find('=');
+		if (eq == std::string_view::npos)
+			throw std::runtime_error("expected name=value, got `" + std::string(assignment) + "`");
+		set_parameter(trim(assignment.substr(0, eq)), trim(assignment.substr(eq + 1)), preset);
+	}
+}
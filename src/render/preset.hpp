@@ -0,0 +1,32 @@
+#pragma once
+
+#include <array>
+#include <optional>
+#include <string_view>
+
+#include "DSP/aether_dsp.hpp"
+
+namespace Render {
+
+	// parameter values in the order of DSP::Parameters
+	using Preset = Aether::DSP::Parameters<float>;
+
+	// names of the members of DSP::Parameters
+	extern const std::array<std::string_view, Preset::size()> parameter_names;
+
+	std::optional<size_t> parameter_index(std::string_view name) noexcept;
+
+	// every parameter at its default value
+	Preset default_preset() noexcept;
+
+	/*
+		Sets the parameters named in text, which is either a flat json
+		object or one name=value pair per line with # starting a comment
+
+		Throws std::runtime_error on malformed input or unknown names
+	*/
+	void parse_preset(std::string_view text, Preset& preset);
+
+	// parses a single name=value pair
+	void parse_assignment(std::string_view assignment, Preset& preset);
+}
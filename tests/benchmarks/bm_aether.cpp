@@ -1,114 +1,24 @@
 #include <cstddef>
 #include <random>
+#include <string>
 
 #include <benchmark/benchmark.h>
 
 #include "DSP/aether_dsp.hpp"
 
+#include "ports.hpp"
+
 #include "../../src/DSP/architecture.hpp"
 
-struct Ports {
-	float mix = 100.f;
-	float dry_level = 80.f;
-	float predelay_level = 20.f;
-	float early_level = 10.f;
-	float late_level = 20.f;
-	float interpolate = 1.f;
-	float width = 100.f;
-	float predelay = 20.f;
-	float early_low_cut_enabled = 0.f;
-	float early_low_cut_cutoff = 15.f;
-	float early_high_cut_enabled = 0.f;
-	float early_high_cut_cutoff = 20000.f;
-	float early_taps = 12.f;
-	float early_tap_length = 200.f;
-	float early_tap_mix = 100.f;
-	float early_tap_decay = 0.5f;
-	float early_diffusion_stages = 7.f;
-	float early_diffusion_delay = 20.f;
-	float early_diffusion_mod_depth = 0.f;
-	float early_diffusion_mod_rate = 1.f;
-	float early_diffusion_feedback = 0.7f;
-	float late_order = 0.f;
-	float late_delay_lines = 3.f;
-	float late_delay = 100.f;
-	float late_delay_mod_depth = 0.2f;
-	float late_delay_mod_rate = 0.2f;
-	float late_delay_line_feedback = 0.7f;
-	float late_diffusion_stages = 7.f;
-	float late_diffusion_delay = 50.f;
-	float late_diffusion_mod_depth = 0.2f;
-	float late_diffusion_mod_rate = 0.5f;
-	float late_diffusion_feedback = 0.7f;
-	float late_low_shelf_enabled = 1.f;
-	float late_low_shelf_cutoff = 1000.f;
-	float late_low_shelf_gain = -3.f;
-	float late_high_shelf_enabled = 1.f;
-	float late_high_shelf_cutoff = 1000.f;
-	float late_high_shelf_gain = -2.f;
-	float late_high_cut_enabled = 1.f;
-	float late_high_cut_cutoff = 1000.f;
-	float seed_crossmix = 80.f;
-	float tap_seed = 10.f;
-	float early_diffusion_seed = 10.f;
-	float delay_seed = 10.f;
-	float late_diffusion_seed = 10.f;
-
-	float early_diffusion_drive = 10.f;
-	float late_diffusion_drive = 10.f;
-
-	std::array<const float*, 47> get_addresses() const noexcept {
-		return {
-			&mix,
-			&dry_level,
-			&predelay_level,
-			&early_level,
-			&late_level,
-			&interpolate,
-			&width,
-			&predelay,
-			&early_low_cut_enabled,
-			&early_low_cut_cutoff,
-			&early_high_cut_enabled,
-			&early_high_cut_cutoff,
-			&early_taps,
-			&early_tap_length,
-			&early_tap_mix,
-			&early_tap_decay,
-			&early_diffusion_stages,
-			&early_diffusion_delay,
-			&early_diffusion_mod_depth,
-			&early_diffusion_mod_rate,
-			&early_diffusion_feedback,
-			&late_order,
-			&late_delay_lines,
-			&late_delay,
-			&late_delay_mod_depth,
-			&late_delay_mod_rate,
-			&late_delay_line_feedback,
-			&late_diffusion_stages,
-			&late_diffusion_delay,
-			&late_diffusion_mod_depth,
-			&late_diffusion_mod_rate,
-			&late_diffusion_feedback,
-			&late_low_shelf_enabled,
-			&late_low_shelf_cutoff,
-			&late_low_shelf_gain,
-			&late_high_shelf_enabled,
-			&late_high_shelf_cutoff,
-			&late_high_shelf_gain,
-			&late_high_cut_enabled,
-			&late_high_cut_cutoff,
-			&seed_crossmix,
-			&tap_seed,
-			&early_diffusion_seed,
-			&delay_seed,
-			&late_diffusion_seed,
-			&early_diffusion_drive,
-			&late_diffusion_drive
-		};
+// average time per block of every stage when built with PROFILE_STAGES
+static void profile_counters(benchmark::State& state, const Aether::DSP& dsp) {
+	if constexpr (Aether::DSP::Profiler::enabled) {
+		for (size_t s = 0; s < Aether::DSP::profile_stage_names.size(); ++s) {
+			const auto stats = dsp.profiler().stats(static_cast<Aether::DSP::ProfileStage>(s));
+			state.counters[std::string(Aether::DSP::profile_stage_names[s]) + "_ns"] = stats.avg;
+		}
 	}
-};
+}
 
 static void bm_aether_zeroes(benchmark::State& state) {
 	disable_denormals();
@@ -141,6 +51,12 @@ static void bm_aether_zeroes(benchmark::State& state) {
 	for (auto _ : state)
 		dsp.process(buffer_size);
 
+	state.counters["delay_memory"] = benchmark::Counter(
+		static_cast<double>(dsp.delay_memory()),
+		benchmark::Counter::kDefaults,
+		benchmark::Counter::kIs1024
+	);
+
 	delete[] in_buf;
 	delete[] out_buf;
 }
@@ -172,6 +88,148 @@ static void bm_aether_white_noise(benchmark::State& state) {
 		dsp.params[i] = *dsp.param_ports[i];
 	dsp.process(1);
 
+	dsp.profiler().reset();
+	for (auto _ : state)
+		dsp.process(buffer_size);
+
+	state.counters["delay_memory"] = benchmark::Counter(
+		static_cast<double>(dsp.delay_memory()),
+		benchmark::Counter::kDefaults,
+		benchmark::Counter::kIs1024
+	);
+	profile_counters(state, dsp);
+
+	delete[] in_buf;
+	delete[] out_buf;
+}
+
+// silence after the tail of a burst of noise has decayed
+static void bm_aether_sleeping(benchmark::State& state) {
+	disable_denormals();
+
+	static constexpr size_t buffer_size = 1024;
+	float* in_buf = new float[buffer_size];
+	float* out_buf = new float[buffer_size];
+
+	std::mt19937 rng;
+	std::uniform_real_distribution<float> dist(-1.f, 1.f);
+	for (size_t i = 0; i < buffer_size; ++i)
+		in_buf[i] = dist(rng);
+
+	Aether::DSP dsp(48000);
+	dsp.ports.audio_in_left = in_buf;
+	dsp.ports.audio_in_right = in_buf;
+	dsp.ports.audio_out_left = out_buf;
+	dsp.ports.audio_out_right = out_buf;
+
+	Ports ports = {};
+	dsp.param_ports = ports.get_addresses();
+
+	for (size_t i = 0; i < dsp.param_ports.size(); ++i)
+		dsp.params[i] = *dsp.param_ports[i];
+	dsp.process(buffer_size);
+
+	// wait for at most a minute of audio for the tail to decay
+	for (size_t i = 0; i < buffer_size; ++i)
+		in_buf[i] = 0;
+	for (size_t i = 0; i < 60*48000/buffer_size && !dsp.sleeping(); ++i)
+		dsp.process(buffer_size);
+	if (!dsp.sleeping())
+		state.SkipWithError("the tail did not decay");
+
+	for (auto _ : state)
+		dsp.process(buffer_size);
+
+	delete[] in_buf;
+	delete[] out_buf;
+}
+
+// stages that do not contribute to the output are skipped
+static void bm_aether_stages(benchmark::State& state) {
+	disable_denormals();
+
+	static constexpr size_t buffer_size = 1024;
+	float* in_buf = new float[buffer_size];
+	float* out_buf = new float[buffer_size];
+
+	std::mt19937 rng;
+	std::uniform_real_distribution<float> dist(-1.f, 1.f);
+	for (size_t i = 0; i < buffer_size; ++i)
+		in_buf[i] = dist(rng);
+
+	Aether::DSP dsp(48000);
+	dsp.ports.audio_in_left = in_buf;
+	dsp.ports.audio_in_right = in_buf;
+	dsp.ports.audio_out_left = out_buf;
+	dsp.ports.audio_out_right = out_buf;
+
+	Ports ports = {};
+	switch (state.range(0)) {
+		case 0:
+			state.SetLabel("early only");
+			ports.late_level = 0.f;
+			break;
+		case 1:
+			state.SetLabel("early without taps");
+			ports.late_level = 0.f;
+			ports.early_tap_mix = 0.f;
+			break;
+		case 2:
+			state.SetLabel("predelay only");
+			ports.early_level = 0.f;
+			ports.late_level = 0.f;
+			break;
+		case 3:
+			state.SetLabel("dry");
+			ports.mix = 0.f;
+			break;
+	}
+	dsp.param_ports = ports.get_addresses();
+
+	for (size_t i = 0; i < dsp.param_ports.size(); ++i)
+		dsp.params[i] = *dsp.param_ports[i];
+	dsp.process(1);
+
+	// clear the skipped stages before measuring
+	for (size_t i = 0; i < 100; ++i)
+		dsp.process(buffer_size);
+
+	for (auto _ : state)
+		dsp.process(buffer_size);
+
+	delete[] in_buf;
+	delete[] out_buf;
+}
+
+// the late delay lines spread over additional threads
+static void bm_aether_threads(benchmark::State& state) {
+	disable_denormals();
+
+	static constexpr size_t buffer_size = 1024;
+	float* in_buf = new float[buffer_size];
+	float* out_buf = new float[buffer_size];
+
+	std::mt19937 rng;
+	std::uniform_real_distribution<float> dist(-1.f, 1.f);
+	for (size_t i = 0; i < buffer_size; ++i)
+		in_buf[i] = dist(rng);
+
+	Aether::DSP dsp(48000);
+	dsp.set_threads(static_cast<uint32_t>(state.range(0)));
+	dsp.ports.audio_in_left = in_buf;
+	dsp.ports.audio_in_right = in_buf;
+	dsp.ports.audio_out_left = out_buf;
+	dsp.ports.audio_out_right = out_buf;
+
+	Ports ports = {};
+	ports.late_delay_lines = 12.f;
+	dsp.param_ports = ports.get_addresses();
+
+	// the calls only span blocks once the seed changes have been applied
+	dsp.reset_parameters();
+	for (size_t i = 0; i < 10; ++i)
+		dsp.process(buffer_size);
+
 	for (auto _ : state)
 		dsp.process(buffer_size);
 
@@ -181,5 +239,8 @@ static void bm_aether_white_noise(benchmark::State& state) {
 
 BENCHMARK(bm_aether_zeroes)->Unit(benchmark::kMicrosecond);
 BENCHMARK(bm_aether_white_noise)->Unit(benchmark::kMicrosecond);
+BENCHMARK(bm_aether_sleeping)->Unit(benchmark::kMicrosecond);
+BENCHMARK(bm_aether_stages)->DenseRange(0, 3)->Unit(benchmark::kMicrosecond);
+BENCHMARK(bm_aether_threads)->DenseRange(0, 3)->Unit(benchmark::kMicrosecond)->UseRealTime();
 
 BENCHMARK_MAIN();
@@ -1,4 +1,6 @@
+#include <array>
 #include <cstddef>
+#include <cstdint>
 
 #include <benchmark/benchmark.h>
 
@@ -27,8 +29,24 @@ static void multitapdelay_push(benchmark::State& state) {
 		);
 }
 
+static void multitapdelay_process_block(benchmark::State& state) {
+	MultitapDelay delay(48000);
+	const auto taps = static_cast<uint32_t>(state.range(0));
+
+	std::array<float, 256> in;
+	std::array<float, 256> out;
+	in.fill(0.5f);
+	for (auto _ : state) {
+		delay.process_block(in.data(), out.data(), in.size(), taps, 0.25f*48000);
+		benchmark::DoNotOptimize(out.data());
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations()*static_cast<int64_t>(in.size()));
+}
+
 BENCHMARK(delay_push)->Unit(benchmark::kNanosecond);
 BENCHMARK(multitapdelay_push)->Unit(benchmark::kNanosecond);
+BENCHMARK(multitapdelay_process_block)->Arg(10)->Arg(MultitapDelay::max_taps)->Unit(benchmark::kMicrosecond);
 BENCHMARK(modulated_delay_push)->Unit(benchmark::kNanosecond);
 
 BENCHMARK_MAIN();
@@ -0,0 +1,119 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include <benchmark/benchmark.h>
+
+#include "DSP/filters.hpp"
+#include "DSP/utils/denormals.hpp"
+
+#include "../../src/DSP/architecture.hpp"
+
+/*
+	Feedback loops fed a tail that has decayed into the denormal range,
+	the time per block shows how much each way of handling denormals
+	saves over doing nothing
+
+	bm_strategy  a four lane one pole loop guarded by every strategy,
+	             only the hardware strategy flushes in hardware
+	bm_lowpass   the damping filters as compiled, with and without
+	bm_biquad    flushing in hardware, see denormals::strategy
+*/
+
+namespace {
+	constexpr size_t block_size = 4096;
+
+	// the largest denormal float, about 1.2e-38
+	constexpr float tail_start = std::numeric_limits<float>::min()*0.99f;
+
+	void flush_denormals(bool flush) noexcept {
+	#ifdef ARCH_FLUSH_DENORMALS
+		const FpControl control = fp_control();
+		set_fp_control(flush ? control | fp_flush_bits : control & ~fp_flush_bits);
+	#else
+		static_cast<void>(flush);
+	#endif
+	}
+
+	template <denormals::Strategy S>
+	void decay(std::array<float, 4>& y) noexcept {
+		for (size_t i = 0; i < block_size; ++i) {
+			for (float& lane : y)
+				lane = denormals::guard<S>(lane*0.9999f);
+			benchmark::DoNotOptimize(y);
+		}
+	}
+}
+
+// none, flush, offset and hardware
+static void bm_strategy(benchmark::State& state) {
+	using denormals::Strategy;
+	const auto strategy = state.range(0);
+	flush_denormals(strategy == 3);
+
+	std::array<float, 4> y;
+	for (auto _ : state) {
+		y.fill(tail_start);
+		switch (strategy) {
+			case 0: decay<Strategy::hardware>(y); break;
+			case 1: decay<Strategy::flush>(y); break;
+			case 2: decay<Strategy::offset>(y); break;
+			case 3: decay<Strategy::hardware>(y); break;
+		}
+		benchmark::DoNotOptimize(y);
+	}
+	flush_denormals(false);
+
+	state.SetLabel(std::array{"none", "flush", "offset", "hardware"}[strategy]);
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()*block_size));
+}
+
+static void bm_lowpass(benchmark::State& state) {
+	flush_denormals(state.range(0));
+
+	// decays by about 0.1% per sample
+	Lowpass6dBBank<float, 4> lp(48000, 8);
+	Lowpass6dBBank<float, 4>::Frame frame;
+	for (auto _ : state) {
+		frame.fill(tail_start*1000.f);
+		lp.push(frame);
+		for (size_t i = 1; i < block_size; ++i) {
+			frame = {};
+			lp.push(frame);
+			benchmark::DoNotOptimize(frame);
+		}
+		benchmark::DoNotOptimize(frame);
+	}
+	flush_denormals(false);
+
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()*block_size));
+}
+
+static void bm_biquad(benchmark::State& state) {
+	flush_denormals(state.range(0));
+
+	const auto coefs = BiquadCoefs<float>::generate<LowshelfGenerator>(48000.f, 20.f, 2.f);
+	BiquadBank<float, 4> bq;
+	BiquadBank<float, 4>::Frame frame;
+	for (auto _ : state) {
+		bq.clear();
+		frame.fill(tail_start);
+		bq.push(frame, coefs);
+		for (size_t i = 1; i < block_size; ++i) {
+			frame = {};
+			bq.push(frame, coefs);
+			benchmark::DoNotOptimize(frame);
+		}
+		benchmark::DoNotOptimize(frame);
+	}
+	flush_denormals(false);
+
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()*block_size));
+}
+
+BENCHMARK(bm_strategy)->DenseRange(0, 3)->ArgName("strategy")->Unit(benchmark::kMicrosecond);
+BENCHMARK(bm_lowpass)->DenseRange(0, 1)->ArgName("ftz")->Unit(benchmark::kMicrosecond);
+BENCHMARK(bm_biquad)->DenseRange(0, 1)->ArgName("ftz")->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
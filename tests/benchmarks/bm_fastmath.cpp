@@ -0,0 +1,78 @@
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <random>
+
+#include <benchmark/benchmark.h>
+
+#include "DSP/utils/fastmath.hpp"
+
+/*
+	fastmath against libm over a block of control values,
+	state.range(0) selects libm (0) or fastmath (1)
+*/
+
+namespace {
+	constexpr size_t size = 256;
+
+	std::array<float, size> random_values(float min, float max) {
+		std::mt19937 rng;
+		std::uniform_real_distribution<float> dist(min, max);
+		std::array<float, size> values;
+		for (float& value : values)
+			value = dist(rng);
+		return values;
+	}
+
+	template <class Libm, class Fast>
+	void run(benchmark::State& state, const std::array<float, size>& in, Libm&& libm, Fast&& fast) {
+		std::array<float, size> out;
+		for (auto _ : state) {
+			if (state.range(0)) {
+				for (size_t i = 0; i < size; ++i)
+					out[i] = fast(in[i]);
+			} else {
+				for (size_t i = 0; i < size; ++i)
+					out[i] = libm(in[i]);
+			}
+			benchmark::DoNotOptimize(out);
+			benchmark::ClobberMemory();
+		}
+		state.SetItemsProcessed(static_cast<int64_t>(state.iterations()*size));
+	}
+}
+
+static void bm_exp(benchmark::State& state) {
+	run(state, random_values(-10.f, 0.f),
+		[](float x) { return std::exp(x); },
+		[](float x) { return fastmath::exp(x); }
+	);
+}
+
+static void bm_pow(benchmark::State& state) {
+	run(state, random_values(0.5f, 1.5f),
+		[](float x) { return std::pow(0.7f, x); },
+		[](float x) { return fastmath::pow(0.7f, x); }
+	);
+}
+
+static void bm_db_to_gain(benchmark::State& state) {
+	run(state, random_values(-24.f, 24.f),
+		[](float x) { return std::pow(10.f, x/20.f); },
+		[](float x) { return fastmath::db_to_gain(x); }
+	);
+}
+
+static void bm_tan(benchmark::State& state) {
+	run(state, random_values(0.f, 1.5f),
+		[](float x) { return std::tan(x); },
+		[](float x) { return fastmath::tan(x); }
+	);
+}
+
+BENCHMARK(bm_exp)->DenseRange(0, 1)->ArgName("fast");
+BENCHMARK(bm_pow)->DenseRange(0, 1)->ArgName("fast");
+BENCHMARK(bm_db_to_gain)->DenseRange(0, 1)->ArgName("fast");
+BENCHMARK(bm_tan)->DenseRange(0, 1)->ArgName("fast");
+
+BENCHMARK_MAIN();
@@ -0,0 +1,60 @@
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "UI/utils/fft.hpp"
+
+/*
+	One windowed magnitude spectrum of the analyser, over the sizes it
+	uses at common rates
+
+	bm_reference  window_function followed by magnitudes
+	bm_plan       fft::Plan::spectrum
+*/
+
+namespace {
+	std::vector<float> noise(size_t size) {
+		std::mt19937 rng;
+		std::uniform_real_distribution<float> dist(-1.f, 1.f);
+		std::vector<float> samples(size);
+		for (float& sample : samples)
+			sample = dist(rng);
+		return samples;
+	}
+}
+
+static void bm_reference(benchmark::State& state) {
+	const auto size = static_cast<size_t>(state.range(0));
+	const auto input = noise(size);
+	std::vector<float> buf(size);
+	for (auto _ : state) {
+		buf = input;
+		fft::window_function(buf);
+		fft::magnitudes(buf);
+		benchmark::DoNotOptimize(buf.data());
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()*size));
+}
+
+static void bm_plan(benchmark::State& state) {
+	const auto size = static_cast<size_t>(state.range(0));
+	const auto input = noise(size);
+	std::vector<float> buf(size);
+	fft::Plan plan(size);
+	for (auto _ : state) {
+		buf = input;
+		plan.spectrum(buf.data(), buf.data());
+		benchmark::DoNotOptimize(buf.data());
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations()*size));
+}
+
+BENCHMARK(bm_reference)->RangeMultiplier(2)->Range(1024, 32768)->Unit(benchmark::kMicrosecond);
+BENCHMARK(bm_plan)->RangeMultiplier(2)->Range(1024, 32768)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
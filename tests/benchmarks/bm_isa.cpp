@@ -0,0 +1,71 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "DSP/engine.hpp"
+#include "common/parameters.hpp"
+
+#include "../../src/DSP/architecture.hpp"
+
+namespace {
+	constexpr size_t param_count = 47;
+	// control, notify, audio in & audio out
+	constexpr uint32_t misc_port_count = 6;
+}
+
+/*
+	Whole plugin through the runtime dispatch
+	state.range(0) is the instruction set variant
+*/
+static void bm_isa(benchmark::State& state) {
+	const auto isa = static_cast<Aether::ISA>(state.range(0));
+	state.SetLabel(std::string(Aether::isa_name(isa)));
+	if (!Aether::isa_available(isa)) {
+		state.SkipWithError("instruction set not available");
+		return;
+	}
+
+	disable_denormals();
+
+	static constexpr size_t buffer_size = 1024;
+	std::vector<float> in_buf(buffer_size);
+	std::vector<float> out_buf(buffer_size);
+
+	std::mt19937 rng;
+	std::uniform_real_distribution<float> dist(-1.f, 1.f);
+	for (float& sample : in_buf)
+		sample = dist(rng);
+
+	std::array<float, param_count> params;
+	for (size_t p = 0; p < param_count; ++p)
+		params[p] = parameter_infos[p+misc_port_count].dflt;
+
+	auto engine = Aether::create_engine(isa, 48000, nullptr, AETHER_ISA_MODULE_DIR);
+	if (engine->isa() != isa) {
+		state.SkipWithError("module not found");
+		return;
+	}
+	engine->connect_port(2, in_buf.data());
+	engine->connect_port(3, in_buf.data());
+	engine->connect_port(4, out_buf.data());
+	engine->connect_port(5, out_buf.data());
+	for (uint32_t p = 0; p < param_count; ++p)
+		engine->connect_port(p+misc_port_count, &params[p]);
+
+	// let the parameter smoothing settle
+	for (size_t i = 0; i < 100; ++i)
+		engine->process(buffer_size);
+
+	for (auto _ : state)
+		engine->process(buffer_size);
+}
+
+BENCHMARK(bm_isa)->DenseRange(0, static_cast<int>(std::size(Aether::isas))-1)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
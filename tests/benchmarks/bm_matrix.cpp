@@ -0,0 +1,159 @@
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <set>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "DSP/aether_dsp.hpp"
+
+#include "ports.hpp"
+
+#include "../../src/DSP/architecture.hpp"
+
+/*
+	The whole dsp over the configurations it runs in
+
+	Each axis is swept on its own around a reference configuration.
+	Besides the time per block every case reports
+	  ns_per_sample  time spent per stereo sample
+	  rt_factor      seconds of audio processed per second
+
+	For a machine readable report run
+	  bm_matrix --benchmark_out=matrix.json --benchmark_out_format=json
+	and compare it to an earlier one with
+	  extern/benchmark/tools/compare.py benchmarks baseline.json matrix.json
+	or build the benchmark_matrix target, see CMakeLists.txt
+*/
+
+namespace {
+	struct Config {
+		int64_t block_size;
+		int64_t rate;
+		int64_t lines;
+		int64_t stages;
+		int64_t interpolate;
+		int64_t drive;
+		int64_t automation;
+
+		std::vector<int64_t> args() const {
+			return {block_size, rate, lines, stages, interpolate, drive, automation};
+		}
+	};
+
+	constexpr Config reference = {256, 48000, 6, 4, 1, 0, 0};
+
+	constexpr int64_t block_sizes[] = {16, 32, 64, 128, 256, 512, 1024, 2048, 4096};
+	constexpr int64_t rates[] = {44100, 48000, 88200, 96000, 176400, 192000};
+}
+
+static void bm_matrix(benchmark::State& state) {
+	disable_denormals();
+
+	const auto block_size = static_cast<uint32_t>(state.range(0));
+	const auto rate = static_cast<float>(state.range(1));
+
+	std::vector<float> in_buf(block_size);
+	std::vector<float> out_buf(block_size);
+
+	std::mt19937 rng;
+	std::uniform_real_distribution<float> dist(-1.f, 1.f);
+	for (float& sample : in_buf)
+		sample = dist(rng);
+
+	Aether::DSP dsp(rate);
+	dsp.ports.audio_in_left = in_buf.data();
+	dsp.ports.audio_in_right = in_buf.data();
+	dsp.ports.audio_out_left = out_buf.data();
+	dsp.ports.audio_out_right = out_buf.data();
+
+	Ports ports = {};
+	ports.late_delay_lines = static_cast<float>(state.range(2));
+	ports.early_diffusion_stages = static_cast<float>(state.range(3));
+	ports.late_diffusion_stages = static_cast<float>(state.range(3));
+	ports.interpolate = static_cast<float>(state.range(4));
+	ports.early_diffusion_drive = state.range(5) ? 10.f : 0.f;
+	ports.late_diffusion_drive = state.range(5) ? 10.f : 0.f;
+	const bool automation = state.range(6);
+	dsp.param_ports = ports.get_addresses();
+
+	dsp.reset_parameters();
+	// a second of audio to fill the delay lines
+	for (uint32_t n = 0; n < static_cast<uint32_t>(rate); n += block_size)
+		dsp.process(block_size);
+
+	// sweeps the delays back and forth over about a second
+	const float step = static_cast<float>(block_size)/rate;
+	float phase = 0.f;
+	for (auto _ : state) {
+		if (automation) {
+			phase += step;
+			const float t = 0.5f + 0.5f*std::sin(6.2831853f*phase);
+			ports.mix = 50.f + 50.f*t;
+			ports.predelay = 20.f + 80.f*t;
+			ports.early_diffusion_delay = 10.f + 40.f*t;
+			ports.late_delay = 50.f + 150.f*t;
+			ports.late_diffusion_delay = 10.f + 60.f*t;
+		}
+		dsp.process(block_size);
+	}
+
+	// 1e-9 turns the inverted rate into nanoseconds
+	state.counters["ns_per_sample"] = benchmark::Counter(
+		1e-9*block_size,
+		benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert
+	);
+	state.counters["rt_factor"] = benchmark::Counter(
+		static_cast<double>(block_size)/static_cast<double>(rate),
+		benchmark::Counter::kIsIterationInvariantRate
+	);
+}
+
+// every axis on its own, the reference configuration is only run once
+static void matrix_args(benchmark::internal::Benchmark* bm) {
+	std::set<std::vector<int64_t>> cases;
+	const auto add = [&](Config config) {
+		if (cases.insert(config.args()).second)
+			bm->Args(config.args());
+	};
+
+	add(reference);
+	for (int64_t block_size : block_sizes) {
+		Config config = reference;
+		config.block_size = block_size;
+		add(config);
+	}
+	for (int64_t rate : rates) {
+		Config config = reference;
+		config.rate = rate;
+		add(config);
+	}
+	for (int64_t lines = 1; lines <= 12; ++lines) {
+		Config config = reference;
+		config.lines = lines;
+		add(config);
+	}
+	for (int64_t stages = 0; stages <= 8; ++stages) {
+		Config config = reference;
+		config.stages = stages;
+		add(config);
+	}
+	for (int64_t flags = 0; flags < 8; ++flags) {
+		Config config = reference;
+		config.interpolate = flags & 1;
+		config.drive = (flags >> 1) & 1;
+		config.automation = (flags >> 2) & 1;
+		add(config);
+	}
+}
+
+BENCHMARK(bm_matrix)
+	->Apply(matrix_args)
+	->ArgNames({"block", "rate", "lines", "stages", "interpolate", "drive", "automation"})
+	->UseRealTime()
+	->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
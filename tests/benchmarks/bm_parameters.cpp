@@ -0,0 +1,130 @@
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "DSP/aether_dsp.hpp"
+#include "DSP/utils/smoother.hpp"
+#include "common/parameters.hpp"
+
+#include "../../src/DSP/architecture.hpp"
+
+namespace {
+	constexpr size_t param_count = 47;
+	constexpr uint32_t block_size = Aether::DSP::max_block_size;
+
+	// parameters that get automated, one cheap and a few with expensive setters
+	constexpr std::array<size_t, 4> automated = {
+		0,  // mix
+		15, // early_tap_decay
+		23, // late_delay
+		33  // late_low_shelf_cutoff
+	};
+
+	ParameterSmoother<param_count> make_smoother() {
+		ParameterSmoother<param_count> smoother{block_size};
+		for (size_t p = 0; p < param_count; ++p) {
+			const ParameterInfo& info = parameter_infos[p+6];
+			smoother.set_smoothing(p, info.integer ? 0.f : 0.999f, 1e-5f*info.range());
+			smoother.reset(p, info.dflt);
+		}
+		return smoother;
+	}
+
+	std::array<float, param_count> default_values() {
+		std::array<float, param_count> values;
+		for (size_t p = 0; p < param_count; ++p)
+			values[p] = parameter_infos[p+6].dflt;
+		return values;
+	}
+}
+
+/*
+	Smoother only
+	state.range(0) is the host buffer size
+*/
+
+static void bm_smoother_idle(benchmark::State& state) {
+	const auto n = static_cast<uint32_t>(state.range(0));
+	auto smoother = make_smoother();
+	auto values = default_values();
+	std::array<bool, param_count> modified = {};
+
+	for (auto _ : state) {
+		for (uint32_t offset = 0; offset < n; offset += block_size)
+			benchmark::DoNotOptimize(smoother.advance(block_size, values.data(), modified.data()));
+	}
+}
+
+static void bm_smoother_automated(benchmark::State& state) {
+	const auto n = static_cast<uint32_t>(state.range(0));
+	auto smoother = make_smoother();
+	auto values = default_values();
+	std::array<bool, param_count> modified = {};
+
+	bool flip = false;
+	for (auto _ : state) {
+		// move every automated parameter each buffer
+		flip = !flip;
+		for (size_t p : automated) {
+			const ParameterInfo& info = parameter_infos[p+6];
+			smoother.set_target(p, flip ? info.min : info.max);
+		}
+
+		for (uint32_t offset = 0; offset < n; offset += block_size)
+			benchmark::DoNotOptimize(smoother.advance(block_size, values.data(), modified.data()));
+		modified = {};
+	}
+}
+
+/*
+	Whole plugin, the difference between the two
+	is the cost of the parameter path
+*/
+
+static void bm_aether_parameters(benchmark::State& state, bool automate) {
+	disable_denormals();
+
+	const auto n = static_cast<uint32_t>(state.range(0));
+	std::vector<float> in_buf(n, 0.f);
+	std::vector<float> out_buf(n, 0.f);
+
+	Aether::DSP dsp(48000);
+	dsp.ports.audio_in_left = in_buf.data();
+	dsp.ports.audio_in_right = in_buf.data();
+	dsp.ports.audio_out_left = out_buf.data();
+	dsp.ports.audio_out_right = out_buf.data();
+
+	auto ports = default_values();
+	for (size_t p = 0; p < param_count; ++p)
+		dsp.param_ports[p] = &ports[p];
+
+	bool flip = false;
+	for (auto _ : state) {
+		if (automate) {
+			flip = !flip;
+			for (size_t p : automated) {
+				const ParameterInfo& info = parameter_infos[p+6];
+				ports[p] = info.dflt + (flip ? 0.01f : -0.01f)*info.range();
+			}
+		}
+
+		dsp.process(n);
+	}
+}
+
+static void bm_aether_static_parameters(benchmark::State& state) {
+	bm_aether_parameters(state, false);
+}
+
+static void bm_aether_automated_parameters(benchmark::State& state) {
+	bm_aether_parameters(state, true);
+}
+
+BENCHMARK(bm_smoother_idle)->Arg(32)->Arg(64)->Unit(benchmark::kNanosecond);
+BENCHMARK(bm_smoother_automated)->Arg(32)->Arg(64)->Unit(benchmark::kNanosecond);
+BENCHMARK(bm_aether_static_parameters)->Arg(32)->Arg(64)->Unit(benchmark::kMicrosecond);
+BENCHMARK(bm_aether_automated_parameters)->Arg(32)->Arg(64)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+
+// parameter values shared by the benchmarks of the whole dsp
+struct Ports {
+	float mix = 100.f;
+	float dry_level = 80.f;
+	float predelay_level = 20.f;
+	float early_level = 10.f;
+	float late_level = 20.f;
+	float interpolate = 1.f;
+	float width = 100.f;
+	float predelay = 20.f;
+	float early_low_cut_enabled = 0.f;
+	float early_low_cut_cutoff = 15.f;
+	float early_high_cut_enabled = 0.f;
+	float early_high_cut_cutoff = 20000.f;
+	float early_taps = 12.f;
+	float early_tap_length = 200.f;
+	float early_tap_mix = 100.f;
+	float early_tap_decay = 0.5f;
+	float early_diffusion_stages = 7.f;
+	float early_diffusion_delay = 20.f;
+	float early_diffusion_mod_depth = 0.f;
+	float early_diffusion_mod_rate = 1.f;
+	float early_diffusion_feedback = 0.7f;
+	float late_order = 0.f;
+	float late_delay_lines = 3.f;
+	float late_delay = 100.f;
+	float late_delay_mod_depth = 0.2f;
+	float late_delay_mod_rate = 0.2f;
+	float late_delay_line_feedback = 0.7f;
+	float late_diffusion_stages = 7.f;
+	float late_diffusion_delay = 50.f;
+	float late_diffusion_mod_depth = 0.2f;
+	float late_diffusion_mod_rate = 0.5f;
+	float late_diffusion_feedback = 0.7f;
+	float late_low_shelf_enabled = 1.f;
+	float late_low_shelf_cutoff = 1000.f;
+	float late_low_shelf_gain = -3.f;
+	float late_high_shelf_enabled = 1.f;
+	float late_high_shelf_cutoff = 1000.f;
+	float late_high_shelf_gain = -2.f;
+	float late_high_cut_enabled = 1.f;
+	float late_high_cut_cutoff = 1000.f;
+	float seed_crossmix = 80.f;
+	float tap_seed = 10.f;
+	float early_diffusion_seed = 10.f;
+	float delay_seed = 10.f;
+	float late_diffusion_seed = 10.f;
+
+	float early_diffusion_drive = 10.f;
+	float late_diffusion_drive = 10.f;
+
+	std::array<const float*, 47> get_addresses() const noexcept {
+		return {
+			&mix,
+			&dry_level,
+			&predelay_level,
+			&early_level,
+			&late_level,
+			&interpolate,
+			&width,
+			&predelay,
+			&early_low_cut_enabled,
+			&early_low_cut_cutoff,
+			&early_high_cut_enabled,
+			&early_high_cut_cutoff,
+			&early_taps,
+			&early_tap_length,
+			&early_tap_mix,
+			&early_tap_decay,
+			&early_diffusion_stages,
+			&early_diffusion_delay,
+			&early_diffusion_mod_depth,
+			&early_diffusion_mod_rate,
+			&early_diffusion_feedback,
+			&late_order,
+			&late_delay_lines,
+			&late_delay,
+			&late_delay_mod_depth,
+			&late_delay_mod_rate,
+			&late_delay_line_feedback,
+			&late_diffusion_stages,
+			&late_diffusion_delay,
+			&late_diffusion_mod_depth,
+			&late_diffusion_mod_rate,
+			&late_diffusion_feedback,
+			&late_low_shelf_enabled,
+			&late_low_shelf_cutoff,
+			&late_low_shelf_gain,
+			&late_high_shelf_enabled,
+			&late_high_shelf_cutoff,
+			&late_high_shelf_gain,
+			&late_high_cut_enabled,
+			&late_high_cut_cutoff,
+			&seed_crossmix,
+			&tap_seed,
+			&early_diffusion_seed,
+			&delay_seed,
+			&late_diffusion_seed,
+			&early_diffusion_drive,
+			&late_diffusion_drive
+		};
+	}
+};
@@ -0,0 +1,15 @@
+// LV2
+#include <lv2/core/lv2.h>
+
+#include "DSP/engine.hpp"
+
+/*
+	Stands in for the module of a variant whose engine cannot be
+	created, see dispatch.failing_module
+*/
+extern "C" LV2_SYMBOL_EXPORT Aether::Engine* aether_make_engine(
+	float,
+	const LV2_Worker_Schedule*
+) noexcept {
+	return nullptr;
+}
@@ -0,0 +1,97 @@
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "UI/utils/analyser.hpp"
+
+using Aether::SpectrumAnalyser;
+
+namespace {
+	// pushes n samples of a sine of the given frequency to both channels of stream
+	void push_sine(SpectrumAnalyser& analyser, size_t stream, float freq, size_t n, size_t& phase) {
+		std::vector<float> samples(n);
+		for (float& sample : samples) {
+			const float t = static_cast<float>(phase++) / static_cast<float>(analyser.rate());
+			sample = std::sin(2.f * constants::pi_v<float> * freq * t);
+		}
+		analyser.push(stream, samples.data(), samples.data(), n);
+	}
+}
+
+// a new spectrum once per hop of new audio, and none without
+TEST(analyser, hop) {
+	SpectrumAnalyser analyser;
+	EXPECT_EQ(analyser.size(), 0u);
+	EXPECT_FALSE(analyser.update(0));
+
+	analyser.set_rate(48000);
+	ASSERT_EQ(analyser.size(), 8192u);
+	ASSERT_EQ(analyser.hop(), analyser.size() / SpectrumAnalyser::overlap);
+	EXPECT_EQ(analyser.spectrum(0, 0).size(), analyser.size()/2);
+
+	size_t phase = 0;
+	push_sine(analyser, 0, 1000.f, analyser.hop()-1, phase);
+	EXPECT_EQ(analyser.frames_available(0), 0u);
+	EXPECT_FALSE(analyser.update(0));
+
+	push_sine(analyser, 0, 1000.f, 1, phase);
+	EXPECT_EQ(analyser.frames_available(0), 1u);
+	EXPECT_EQ(analyser.frames_available(1), 0u);
+	EXPECT_TRUE(analyser.update(0));
+	EXPECT_FALSE(analyser.update(0));
+	EXPECT_FALSE(analyser.update(1));
+
+	// a ui that falls behind only transforms the latest window, keeping the hop phase
+	push_sine(analyser, 0, 1000.f, 3*analyser.hop() + 5, phase);
+	EXPECT_EQ(analyser.frames_available(0), 3u);
+	EXPECT_TRUE(analyser.update(0));
+	EXPECT_EQ(analyser.frames_available(0), 0u);
+	push_sine(analyser, 0, 1000.f, analyser.hop()-5, phase);
+	EXPECT_EQ(analyser.frames_available(0), 1u);
+
+	// a new rate starts over
+	analyser.set_rate(44100);
+	EXPECT_EQ(analyser.frames_available(0), 0u);
+	for (float magnitude : analyser.spectrum(0, 1))
+		ASSERT_EQ(magnitude, 0.f);
+}
+
+// the spectrum of the latest window with the tilt applied
+TEST(analyser, spectrum) {
+	SpectrumAnalyser analyser;
+	analyser.set_rate(48000);
+
+	size_t phase = 0;
+	push_sine(analyser, 1, 1000.f, 3*analyser.size(), phase);
+	ASSERT_TRUE(analyser.update(1));
+
+	std::vector<float> window(analyser.size());
+	for (size_t i = 0; i < window.size(); ++i) {
+		const float t = static_cast<float>(phase - window.size() + i) / static_cast<float>(analyser.rate());
+		window[i] = std::sin(2.f * constants::pi_v<float> * 1000.f * t);
+	}
+	fft::Plan plan(analyser.size());
+	std::vector<float> expected(analyser.size()/2);
+	plan.spectrum(window.data(), expected.data());
+
+	const float middle_freq = SpectrumAnalyser::freq_min
+		* std::sqrt(SpectrumAnalyser::freq_max/SpectrumAnalyser::freq_min);
+	const auto& spectrum = analyser.spectrum(1, 0);
+	ASSERT_EQ(spectrum.size(), expected.size());
+	EXPECT_EQ(spectrum[0], expected[0]);
+	for (size_t i = 1; i < spectrum.size(); ++i) {
+		const float freq = static_cast<float>(i) * analyser.bin_size();
+		const float tilt = std::pow(10.f, 3.f/20.f * std::log2(freq/middle_freq));
+		ASSERT_NEAR(spectrum[i], expected[i]*tilt, 1e-4f*(expected[i]*tilt) + 1e-7f) << i;
+	}
+
+	// the sine peaks at its bin
+	const size_t bin = static_cast<size_t>(std::lround(1000.f / analyser.bin_size()));
+	for (size_t i = 0; i < spectrum.size(); ++i)
+		if (i + 2 < bin || i > bin + 2)
+			ASSERT_LT(spectrum[i], spectrum[bin]) << i;
+
+	EXPECT_EQ(analyser.spectrum(1, 1), spectrum);
+}
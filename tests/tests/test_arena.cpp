@@ -0,0 +1,81 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+#include "DSP/utils/arena.hpp"
+#include "DSP/utils/ringbuffer.hpp"
+
+// allocations are aligned and carved out of the arena one after another
+TEST(arena, allocate) {
+	Arena arena{4*Arena::alignment};
+
+	float* a = arena.allocate<float>(3);
+	double* b = arena.allocate<double>(Arena::alignment/sizeof(double) + 1);
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % Arena::alignment, 0u);
+	EXPECT_EQ(reinterpret_cast<unsigned char*>(b) - reinterpret_cast<unsigned char*>(a), Arena::alignment);
+	EXPECT_EQ(arena.used(), 3*Arena::alignment);
+
+	arena.deallocate(a, 3);
+	arena.deallocate(b, Arena::alignment/sizeof(double) + 1);
+	EXPECT_EQ(arena.used(), 3*Arena::alignment);
+}
+
+// allocations that don't fit go to the heap
+TEST(arena, overflow) {
+	Arena arena{Arena::alignment};
+
+	// the capacity may be rounded up to whole pages
+	const size_t n = arena.capacity()/sizeof(float) + 1;
+	float* a = arena.allocate<float>(n);
+	ASSERT_NE(a, nullptr);
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % Arena::alignment, 0u);
+	EXPECT_EQ(arena.used(), 0u);
+	a[n-1] = 1.f;
+	arena.deallocate(a, n);
+}
+
+TEST(arena, prefault) {
+	Arena arena{1 << 20};
+	float* a = arena.allocate<float>(1 << 18);
+	a[1024] = 5.f;
+	arena.prefault();
+	EXPECT_EQ(a[1024], 5.f);
+	arena.deallocate(a, 1 << 18);
+}
+
+// buffers take up exactly what they report
+TEST(arena, ringbuffer) {
+	using Frame = std::array<double, 4>;
+	const size_t size = Ringbuffer<Frame>::memory_required(1000, 8);
+
+	Arena arena{size};
+	Ringbuffer<Frame> buf{1000, 8, arena};
+	EXPECT_EQ(arena.used(), size);
+	EXPECT_GE(arena.capacity(), size);
+}
+
+// detached buffers may outlive their arena
+TEST(arena, detach) {
+	using Frame = std::array<double, 4>;
+	const size_t size = Ringbuffer<Frame>::memory_required(1000);
+
+	Ringbuffer<Frame> owned;
+	Ringbuffer<Frame> overflow;
+	{
+		Arena arena{size};
+		Ringbuffer<Frame> a{1000, 1, arena};
+		// does not fit and comes from the heap
+		Ringbuffer<Frame> b{4*arena.capacity(), 1, arena};
+		EXPECT_TRUE(arena.owns(a.buf));
+		EXPECT_FALSE(arena.owns(b.buf));
+
+		a.detach();
+		b.detach();
+		owned.swap(a);
+		overflow.swap(b);
+	}
+	overflow.push({1., 2., 3., 4.});
+	EXPECT_EQ(overflow[0][3], 4.);
+}
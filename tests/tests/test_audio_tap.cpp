@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "common/audio_tap.hpp"
+
+using Aether::AudioTap;
+
+namespace {
+	// appends everything read from stream to out
+	void read_all(AudioTap& tap, size_t stream, std::vector<float>& left, std::vector<float>& right) {
+		tap.read(stream, [&](const float* l, const float* r, size_t n) {
+			left.insert(left.end(), l, l+n);
+			right.insert(right.end(), r, r+n);
+		});
+	}
+}
+
+// samples are read in the order they were written, across the end of the ring
+TEST(audio_tap, fifo) {
+	AudioTap tap{12, 48000};
+	EXPECT_EQ(tap.capacity(), 16u);
+	EXPECT_EQ(tap.rate(), 48000);
+	ASSERT_TRUE(tap.attach());
+
+	float next_in = 0.f;
+	float next_out = 0.f;
+	for (size_t n : {5u, 9u, 3u, 12u, 7u, 16u, 1u}) {
+		std::array<float, 16> l, r;
+		for (size_t i = 0; i < n; ++i) {
+			l[i] = next_in;
+			r[i] = -next_in;
+			++next_in;
+		}
+		ASSERT_EQ(tap.write(1, l.data(), r.data(), n), n);
+
+		std::vector<float> left, right;
+		read_all(tap, 1, left, right);
+		ASSERT_EQ(left.size(), n);
+		for (size_t i = 0; i < n; ++i) {
+			ASSERT_EQ(left[i], next_out);
+			ASSERT_EQ(right[i], -next_out);
+			++next_out;
+		}
+	}
+	EXPECT_EQ(tap.read(0, [](const float*, const float*, size_t) {}), 0u);
+}
+
+// a full ring drops the newest samples instead of overwriting unread ones
+TEST(audio_tap, full) {
+	AudioTap tap{8, 48000};
+	ASSERT_TRUE(tap.attach());
+
+	std::array<float, 12> samples;
+	for (size_t i = 0; i < samples.size(); ++i)
+		samples[i] = static_cast<float>(i);
+	EXPECT_EQ(tap.write(0, samples.data(), samples.data(), 12), 8u);
+	EXPECT_EQ(tap.space(0), 0u);
+	EXPECT_EQ(tap.space(1), 8u);
+
+	std::vector<float> left, right;
+	read_all(tap, 0, left, right);
+	ASSERT_EQ(left.size(), 8u);
+	for (size_t i = 0; i < left.size(); ++i)
+		EXPECT_EQ(left[i], static_cast<float>(i));
+	EXPECT_EQ(tap.space(0), 8u);
+}
+
+// one reader at a time, which skips whatever was written before it attached
+TEST(audio_tap, attach) {
+	AudioTap tap{8, 48000};
+	EXPECT_FALSE(tap.attached());
+
+	std::array<float, 4> samples = {1.f, 2.f, 3.f, 4.f};
+	tap.write(0, samples.data(), samples.data(), 4);
+
+	ASSERT_TRUE(tap.attach());
+	EXPECT_TRUE(tap.attached());
+	EXPECT_FALSE(tap.attach());
+	EXPECT_EQ(tap.space(0), 8u);
+	EXPECT_EQ(tap.read(0, [](const float*, const float*, size_t) {}), 0u);
+
+	tap.detach();
+	EXPECT_FALSE(tap.attached());
+	EXPECT_TRUE(tap.attach());
+}
+
+// a reader on another thread sees every sample exactly once
+TEST(audio_tap, threads) {
+	constexpr size_t total = 1 << 18;
+	AudioTap tap{64, 48000};
+	ASSERT_TRUE(tap.attach());
+
+	std::thread writer([&] {
+		std::array<float, 37> l, r;
+		size_t written = 0;
+		while (written < total) {
+			const size_t n = std::min(l.size(), total - written);
+			for (size_t i = 0; i < n; ++i) {
+				l[i] = static_cast<float>(written + i);
+				r[i] = -l[i];
+			}
+			// waits for space rather than dropping samples
+			size_t done = 0;
+			while (done < n) {
+				done += tap.write(0, l.data() + done, r.data() + done, n - done);
+				std::this_thread::yield();
+			}
+			written += n;
+		}
+	});
+
+	std::vector<float> left, right;
+	left.reserve(total);
+	right.reserve(total);
+	while (left.size() < total) {
+		read_all(tap, 0, left, right);
+		std::this_thread::yield();
+	}
+	writer.join();
+
+	ASSERT_EQ(left.size(), total);
+	for (size_t i = 0; i < total; ++i) {
+		ASSERT_EQ(left[i], static_cast<float>(i));
+		ASSERT_EQ(right[i], -static_cast<float>(i));
+	}
+}
@@ -1,3 +1,5 @@
+#include <cmath>
+#include <cstdint>
 #include <random>
 
 #include <gtest/gtest.h>
@@ -8,6 +10,8 @@
 TEST(constants, value_check) {
 	ASSERT_FLOAT_EQ(constants::sqrt2_v<float>, 1.414213562373095048801688724209698079f);
 	ASSERT_FLOAT_EQ(constants::pi_v<float>, 3.141592653589793238462643383279502884f);
+	ASSERT_DOUBLE_EQ(constants::log2e, std::log2(std::exp(1.0)));
+	ASSERT_DOUBLE_EQ(constants::log2_10, std::log2(10.0));
 }
 
 TEST(bit_ops, has_single_bit) {
@@ -37,3 +41,19 @@ TEST(bit_ops, countr_zero) {
 	ASSERT_EQ(bits::countr_zero(4), 2);
 	ASSERT_EQ(bits::countr_zero(2), 1);
 }
+
+TEST(bit_ops, bit_width) {
+	ASSERT_EQ(bits::bit_width(0u), 0);
+	ASSERT_EQ(bits::bit_width(1u), 1);
+	ASSERT_EQ(bits::bit_width(2u), 2);
+	ASSERT_EQ(bits::bit_width(3u), 2);
+	ASSERT_EQ(bits::bit_width(255u), 8);
+	ASSERT_EQ(bits::bit_width(256u), 9);
+	ASSERT_EQ(bits::bit_width(uint64_t{1} << 40), 41);
+}
+
+TEST(bit_ops, bit_cast) {
+	ASSERT_EQ(bits::bit_cast<uint32_t>(1.f), 0x3f800000u);
+	ASSERT_EQ(bits::bit_cast<float>(0x40000000u), 2.f);
+	ASSERT_EQ(bits::bit_cast<uint64_t>(-2.0), 0xc000000000000000u);
+}
@@ -0,0 +1,77 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include <gtest/gtest.h>
+
+#include "DSP/utils/denormals.hpp"
+
+namespace {
+	// every float between 0 and 2^-60 of both signs, in steps of stride bit patterns
+	template <class F>
+	void for_each_small_float(uint32_t stride, F&& f) {
+		for (uint32_t bits = 0; bits < 0x21800000u; bits += stride) {
+			for (uint32_t sign : {0u, 0x80000000u}) {
+				const uint32_t pattern = bits | sign;
+				float x;
+				std::memcpy(&x, &pattern, sizeof(x));
+				f(x);
+			}
+		}
+	}
+}
+
+TEST(denormals, flush) {
+	using denormals::Strategy;
+	for_each_small_float(97, [](float x) {
+		const float y = denormals::guard<Strategy::flush>(x);
+		EXPECT_TRUE(y == 0.f || std::fabs(y) >= denormals::threshold<float>) << x;
+		// anything above the threshold is left untouched
+		if (std::fabs(x) >= denormals::threshold<float>)
+			EXPECT_EQ(y, x);
+	});
+
+	EXPECT_EQ(denormals::guard<Strategy::flush>(0.5), 0.5);
+	EXPECT_EQ(denormals::guard<Strategy::flush>(std::numeric_limits<double>::denorm_min()), 0.0);
+}
+
+TEST(denormals, decay) {
+	using denormals::Strategy;
+	float flushed = 1.f, offset = 1.f;
+	for (int i = 0; i < 200000; ++i) {
+		flushed = denormals::guard<Strategy::flush>(flushed*0.999f);
+		offset = denormals::guard<Strategy::offset>(offset*0.999f);
+		ASSERT_NE(std::fpclassify(flushed), FP_SUBNORMAL);
+		ASSERT_NE(std::fpclassify(offset), FP_SUBNORMAL);
+	}
+	EXPECT_LT(flushed, 1e-25f);
+	EXPECT_LT(offset, 1e-25f);
+}
+
+TEST(denormals, hardware) {
+	const float x = std::numeric_limits<float>::denorm_min();
+	EXPECT_EQ(denormals::guard<denormals::Strategy::hardware>(x), x);
+
+#ifdef ARCH_FLUSH_DENORMALS
+	const FpControl before = fp_control();
+	{
+		DenormalGuard guard;
+		EXPECT_EQ(fp_control() & fp_flush_bits, fp_flush_bits);
+
+		volatile float tiny = std::numeric_limits<float>::min();
+		EXPECT_EQ(tiny*0.5f, 0.f);
+	}
+	EXPECT_EQ(fp_control(), before);
+#endif
+}
+
+TEST(denormals, strategy) {
+#ifndef FORCE_DISABLE_DENORMALS
+	// nothing sets the control register, so the state is guarded in software
+	EXPECT_NE(denormals::strategy, denormals::Strategy::hardware);
+#elif defined(ARCH_FLUSH_DENORMALS) && !defined(AETHER_DENORMAL_FLUSH) && !defined(AETHER_DENORMAL_OFFSET)
+	// the plugin as shipped relies on the control register where it can be set
+	EXPECT_EQ(denormals::strategy, denormals::Strategy::hardware);
+#endif
+}
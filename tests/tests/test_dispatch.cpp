@@ -0,0 +1,58 @@
+#include <cstdlib>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "DSP/engine.hpp"
+
+TEST(dispatch, names) {
+	for (Aether::ISA isa : Aether::isas)
+		EXPECT_EQ(Aether::parse_isa(Aether::isa_name(isa)), isa);
+	EXPECT_FALSE(Aether::parse_isa("mmx"));
+}
+
+TEST(dispatch, baseline_available) {
+	EXPECT_TRUE(Aether::isa_available(Aether::ISA::baseline));
+	auto engine = Aether::create_engine(Aether::ISA::baseline, 48000);
+	ASSERT_TRUE(engine);
+	EXPECT_EQ(engine->isa(), Aether::ISA::baseline);
+}
+
+// every available variant is loaded from its module
+TEST(dispatch, modules) {
+	for (Aether::ISA isa : Aether::isas) {
+		if (!Aether::isa_available(isa)) continue;
+		auto engine = Aether::create_engine(isa, 48000, nullptr, AETHER_ISA_MODULE_DIR);
+		ASSERT_TRUE(engine);
+		EXPECT_EQ(engine->isa(), isa);
+	}
+}
+
+// the baseline is used when the module of a variant is missing
+TEST(dispatch, missing_module) {
+	auto engine = Aether::create_engine(Aether::ISA::avx2, 48000, nullptr, "missing/");
+	ASSERT_TRUE(engine);
+	EXPECT_EQ(engine->isa(), Aether::ISA::baseline);
+}
+
+// the baseline is used when the module of a variant fails to create its engine
+TEST(dispatch, failing_module) {
+	auto engine = Aether::create_engine(Aether::ISA::avx2, 48000, nullptr, FAILING_MODULE_DIR);
+	ASSERT_TRUE(engine);
+	EXPECT_EQ(engine->isa(), Aether::ISA::baseline);
+}
+
+#ifndef _WIN32
+// AETHER_FORCE_ISA overrides the best available instruction set
+TEST(dispatch, forced_isa) {
+	setenv("AETHER_FORCE_ISA", "baseline", 1);
+	EXPECT_EQ(Aether::select_isa(), Aether::ISA::baseline);
+
+	// unknown instruction sets are ignored
+	setenv("AETHER_FORCE_ISA", "mmx", 1);
+	const Aether::ISA isa = Aether::select_isa();
+	unsetenv("AETHER_FORCE_ISA");
+	EXPECT_EQ(isa, Aether::select_isa());
+	EXPECT_TRUE(Aether::isa_available(isa));
+}
+#endif
@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+#include <gtest/gtest.h>
+
+#include "DSP/utils/fastmath.hpp"
+
+namespace {
+	constexpr size_t steps = 100000;
+
+	// largest relative error of approx against exact over [a, b]
+	template <class FpType, class Approx, class Exact>
+	double max_error(double a, double b, Approx&& approx, Exact&& exact) {
+		double error = 0.0;
+		for (size_t i = 0; i <= steps; ++i) {
+			const auto x = static_cast<FpType>(a + (b-a)*static_cast<double>(i)/steps);
+			const double expected = exact(static_cast<double>(x));
+			const double actual = static_cast<double>(approx(x));
+			error = std::max(error, std::abs(actual - expected) / std::max(std::abs(expected), 1e-300));
+		}
+		return error;
+	}
+}
+
+TEST(fastmath, exp2) {
+	const auto exact = [](double x) { return std::exp2(x); };
+	EXPECT_LT(max_error<float>(-126, 127, fastmath::exp2<float>, exact), 3e-7);
+	EXPECT_LT(max_error<double>(-100, 100, fastmath::exp2<double>, exact), 3e-7);
+	EXPECT_LT(max_error<float>(-1, 1, fastmath::exp2<float>, exact), 3e-7);
+
+	EXPECT_EQ(fastmath::exp2(0.f), 1.f);
+	EXPECT_EQ(fastmath::exp2(3.f), 8.f);
+	EXPECT_EQ(fastmath::exp2(-3.f), 0.125f);
+	// clamped to the normal range
+	EXPECT_EQ(fastmath::exp2(-1000.f), std::numeric_limits<float>::min());
+	EXPECT_TRUE(std::isfinite(fastmath::exp2(1000.f)));
+}
+
+TEST(fastmath, exp) {
+	const auto exact = [](double x) { return std::exp(x); };
+	EXPECT_LT(max_error<float>(-10, 10, fastmath::exp<float>, exact), 3e-7 + 10*6e-8);
+	EXPECT_LT(max_error<double>(-10, 10, fastmath::exp<double>, exact), 3e-7);
+}
+
+TEST(fastmath, log2) {
+	// absolute error, log2 crosses zero at 1
+	for (double x = 1e-30; x < 1e30; x *= 1.001) {
+		EXPECT_NEAR(fastmath::log2(static_cast<float>(x)), std::log2(static_cast<float>(x)), 2e-7*std::max(1.0, std::abs(std::log2(x))));
+		EXPECT_NEAR(fastmath::log2(x), std::log2(x), 2e-7);
+	}
+
+	// relative near 1
+	const auto exact = [](double x) { return std::log2(x); };
+	EXPECT_LT(max_error<float>(0.5, 0.999, fastmath::log2<float>, exact), 3e-7);
+	EXPECT_LT(max_error<float>(1.001, 2, fastmath::log2<float>, exact), 3e-7);
+
+	EXPECT_EQ(fastmath::log2(1.f), 0.f);
+	EXPECT_EQ(fastmath::log2(1024.f), 10.f);
+}
+
+TEST(fastmath, pow) {
+	// the feedback of the late delay lines, see LateRev::generate_feedback
+	for (double base = 0.01; base < 1; base += 0.01) {
+		const auto approx = [&](double x) { return fastmath::pow(static_cast<float>(base), static_cast<float>(x)); };
+		const auto exact = [&](double x) { return std::pow(static_cast<double>(static_cast<float>(base)), x); };
+		const double bound = 3e-7 + 4*std::abs(std::log2(base))*2e-7;
+		EXPECT_LT(max_error<float>(0, 4, approx, exact), bound) << base;
+	}
+
+	// smoothing coefficients raised to the block size
+	EXPECT_NEAR(fastmath::pow(0.99999f, 32.f), std::pow(0.99999f, 32.f), 3e-7);
+	EXPECT_EQ(fastmath::pow(0.f, 32.f), 0.f);
+}
+
+TEST(fastmath, db_to_gain) {
+	const auto exact = [](double db) { return std::pow(10.0, db/20); };
+	EXPECT_LT(max_error<float>(-60, 60, fastmath::db_to_gain<float>, exact), 3e-7 + 60*1e-8);
+	EXPECT_EQ(fastmath::db_to_gain(0.f), 1.f);
+}
+
+TEST(fastmath, tan) {
+	constexpr double pi_2 = 1.5707963267948966;
+	const auto exact = [](double x) { return std::tan(x); };
+	EXPECT_LT(max_error<float>(-1.5, 1.5, fastmath::tan<float>, exact), 3e-7);
+	EXPECT_LT(max_error<double>(0, pi_2 - 1e-6, fastmath::tan<double>, exact), 3e-7);
+
+	// the shelves run up to the nyquist frequency
+	EXPECT_LT(max_error<float>(1.5, 1.5707f, fastmath::tan<float>, exact), 3e-7);
+	EXPECT_EQ(fastmath::tan(0.f), 0.f);
+}
@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "UI/utils/fft.hpp"
+
+namespace {
+	std::vector<float> noise(size_t size) {
+		std::mt19937 rng(size);
+		std::uniform_real_distribution<float> dist(-1.f, 1.f);
+		std::vector<float> samples(size);
+		for (float& sample : samples)
+			sample = dist(rng);
+		return samples;
+	}
+
+	// magnitudes of the first size/2 bins of the hann windowed input in double precision
+	std::vector<double> exact_spectrum(const std::vector<float>& input) {
+		const size_t size = input.size();
+		std::vector<double> windowed(size);
+		double sum = 0.0;
+		for (size_t i = 0; i < size; ++i) {
+			const double s = std::sin(constants::pi * static_cast<double>(i+1) / static_cast<double>(size-1));
+			windowed[i] = s*s*input[i];
+			sum += s*s;
+		}
+
+		std::vector<double> magnitudes(size/2);
+		for (size_t k = 0; k < size/2; ++k) {
+			std::complex<double> bin = 0.0;
+			for (size_t i = 0; i < size; ++i)
+				bin += windowed[i] * std::polar(1.0, -2*constants::pi * static_cast<double>(i*k % size) / static_cast<double>(size));
+			magnitudes[k] = std::abs(bin) / sum;
+		}
+		return magnitudes;
+	}
+}
+
+// every bin is within float precision of a dft, for odd and even log2(size/2)
+TEST(fft, plan) {
+	for (size_t size = 8; size <= 2048; size *= 2) {
+		const auto input = noise(size);
+		const auto exact = exact_spectrum(input);
+
+		fft::Plan plan(size);
+		ASSERT_EQ(plan.size(), size);
+		std::vector<float> output(size/2);
+		plan.spectrum(input.data(), output.data());
+
+		const double peak = *std::max_element(exact.begin(), exact.end());
+		for (size_t k = 0; k < size/2; ++k)
+			ASSERT_NEAR(output[k], exact[k], 1e-5*peak) << "size " << size << " bin " << k;
+	}
+}
+
+// matches window_function followed by magnitudes, and may work in place
+TEST(fft, reference) {
+	for (size_t size : {1024u, 8192u, 32768u}) {
+		auto reference = noise(size);
+		auto output = reference;
+
+		fft::window_function(reference);
+		fft::magnitudes(reference);
+
+		fft::Plan plan(size);
+		plan.spectrum(output.data(), output.data());
+
+		const float peak = *std::max_element(output.begin(), output.begin() + size/2);
+		// the dc bin of magnitudes is not normalized
+		for (size_t k = 1; k < size/2; ++k)
+			ASSERT_NEAR(output[k], reference[k], 1e-3f*peak) << "size " << size << " bin " << k;
+	}
+}
+
+// a sine lands in its bin
+TEST(fft, sine) {
+	constexpr size_t size = 4096;
+	constexpr size_t bin = 100;
+	std::vector<float> input(size);
+	for (size_t i = 0; i < size; ++i)
+		input[i] = static_cast<float>(std::sin(2*constants::pi * static_cast<double>(bin*i) / size));
+
+	fft::Plan plan(size);
+	std::vector<float> output(size/2);
+	plan.spectrum(input.data(), output.data());
+
+	EXPECT_EQ(std::max_element(output.begin(), output.end()) - output.begin(), static_cast<std::ptrdiff_t>(bin));
+	EXPECT_NEAR(output[bin], 0.5f, 1e-3f);
+}
@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "DSP/utils/incremental_clear.hpp"
+
+namespace {
+	struct Buffers {
+		std::vector<float> a = std::vector<float>(100, 1.f);
+		std::vector<float> b = std::vector<float>(30, 1.f);
+		std::vector<float> c = std::vector<float>(50, 1.f);
+
+		template <class F>
+		void for_each_buffer(F&& f) {
+			f(a.data(), a.size()*sizeof(float));
+			f(b.data(), b.size()*sizeof(float));
+			f(c.data(), c.size()*sizeof(float));
+		}
+
+		size_t zeros() const {
+			auto count = [](const std::vector<float>& v) {
+				return static_cast<size_t>(std::count(v.begin(), v.end(), 0.f));
+			};
+			return count(a) + count(b) + count(c);
+		}
+	};
+}
+
+// every step clears the budget in order until everything is cleared
+TEST(incremental_clear, step) {
+	Buffers buffers;
+	auto for_each_buffer = [&](auto&& f) { buffers.for_each_buffer(f); };
+
+	IncrementalClear clear;
+	clear.step(for_each_buffer, 40*sizeof(float));
+	EXPECT_EQ(buffers.zeros(), 0u);
+
+	clear.start();
+	for (size_t step = 1; step <= 4; ++step) {
+		EXPECT_TRUE(clear.pending());
+		clear.step(for_each_buffer, 40*sizeof(float));
+		EXPECT_EQ(buffers.zeros(), std::min<size_t>(step*40, 180));
+	}
+	// 160 floats: all of a and b and 30 of c
+	EXPECT_EQ(buffers.b.back(), 0.f);
+	EXPECT_EQ(buffers.c[29], 0.f);
+	EXPECT_EQ(buffers.c[30], 1.f);
+
+	clear.step(for_each_buffer, 40*sizeof(float));
+	EXPECT_FALSE(clear.pending());
+	EXPECT_EQ(buffers.zeros(), 180u);
+}
+
+// finish clears whatever the steps left
+TEST(incremental_clear, finish) {
+	Buffers buffers;
+	auto for_each_buffer = [&](auto&& f) { buffers.for_each_buffer(f); };
+
+	IncrementalClear clear;
+	clear.start();
+	clear.step(for_each_buffer, 10*sizeof(float));
+	clear.finish(for_each_buffer);
+	EXPECT_FALSE(clear.pending());
+	EXPECT_EQ(buffers.zeros(), 180u);
+}
+
+// stop leaves whatever the steps have not reached
+TEST(incremental_clear, stop) {
+	Buffers buffers;
+	auto for_each_buffer = [&](auto&& f) { buffers.for_each_buffer(f); };
+
+	IncrementalClear clear;
+	clear.start();
+	clear.step(for_each_buffer, 10*sizeof(float));
+	clear.stop();
+	EXPECT_FALSE(clear.pending());
+	clear.step(for_each_buffer, 10*sizeof(float));
+	clear.finish(for_each_buffer);
+	EXPECT_EQ(buffers.zeros(), 10u);
+}
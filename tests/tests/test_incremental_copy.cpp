@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <cstddef>
+
+#include <gtest/gtest.h>
+
+#include "DSP/utils/incremental_copy.hpp"
+#include "DSP/utils/ringbuffer.hpp"
+
+// copying into a larger buffer keeps every delay of the smaller one
+TEST(incremental_copy, history) {
+	Ringbuffer<float> small{16, 4};
+	for (size_t i = 0; i < 21; ++i)
+		small.push(static_cast<float>(i));
+
+	Ringbuffer<float> large{64, 4};
+	IncrementalCopy<float> copy;
+	copy.start(small);
+	EXPECT_EQ(copy.pending(), 16u);
+	EXPECT_EQ(copy.step(small, large, 100), 16u);
+	copy.finish(large);
+	for (size_t delay = 0; delay < 16; ++delay)
+		ASSERT_EQ(large[delay], small[delay]);
+	for (size_t delay = 16; delay < 64; ++delay)
+		ASSERT_EQ(large[delay], 0.f);
+
+	for (size_t i = 21; i < 100; ++i) {
+		large.push(static_cast<float>(i));
+		const float* window = large.window(10);
+		for (size_t j = 0; j < 4; ++j)
+			ASSERT_EQ(window[j], static_cast<float>(i - 10 + j));
+	}
+}
+
+// only the history is copied, the grown part is not written at all
+TEST(incremental_copy, grown_region) {
+	Ringbuffer<float> small{16, 4};
+	for (size_t i = 0; i < 21; ++i)
+		small.push(static_cast<float>(i+1));
+
+	const size_t older = small.capacity - small.end - 1;
+	Ringbuffer<float> large{64, 4};
+	std::fill(large.buf + small.end + 1, large.buf + large.capacity - older, -1.f);
+
+	IncrementalCopy<float> copy;
+	copy.start(small);
+	copy.step(small, large, 16);
+	copy.finish(large);
+	for (size_t i = small.end + 1; i < large.capacity - older; ++i)
+		ASSERT_EQ(large.buf[i], -1.f);
+	for (size_t delay = 0; delay < 16; ++delay)
+		ASSERT_EQ(large[delay], small[delay]);
+}
+
+// elements written while copying are copied as well, the oldest first
+TEST(incremental_copy, written_while_copying) {
+	Ringbuffer<float> small{16, 4};
+	for (size_t i = 0; i < 21; ++i)
+		small.push(static_cast<float>(i+1));
+
+	Ringbuffer<float> large{64, 4};
+	IncrementalCopy<float> copy;
+	copy.start(small);
+
+	size_t pushed = 21;
+	for (size_t step = 0; step < 4; ++step) {
+		EXPECT_EQ(copy.step(small, large, 5), 5u);
+		for (size_t i = 0; i < 3; ++i)
+			small.push(static_cast<float>(++pushed));
+		copy.update(small);
+	}
+	// 16 - 4*5 + 4*3
+	EXPECT_EQ(copy.pending(), 8u);
+	copy.step(small, large, 100);
+	EXPECT_EQ(copy.pending(), 0u);
+	copy.finish(large);
+
+	// older elements are either zero or where they would have been written
+	for (size_t delay = 0; delay < 16; ++delay)
+		ASSERT_EQ(large[delay], small[delay]);
+	for (size_t delay = 16; delay < 64; ++delay)
+		ASSERT_TRUE(large[delay] == 0.f || large[delay] == static_cast<float>(pushed - delay));
+
+	large.push(static_cast<float>(++pushed));
+	for (size_t j = 0; j < 4; ++j)
+		ASSERT_EQ(large.window(4)[j], static_cast<float>(pushed - 4 + j));
+}
+
+// elements pushed out of the source before they are copied are not waited for
+TEST(incremental_copy, overwritten) {
+	Ringbuffer<float> small{16, 4};
+	Ringbuffer<float> large{64, 4};
+	IncrementalCopy<float> copy;
+	copy.start(small);
+	copy.step(small, large, 4);
+
+	for (size_t i = 0; i < 2; ++i) {
+		for (size_t j = 0; j < 10; ++j)
+			small.push(1.f);
+		copy.update(small);
+	}
+	EXPECT_EQ(copy.pending(), 16u);
+}
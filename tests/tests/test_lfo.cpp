@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <random>
 
 #include <gtest/gtest.h>
@@ -46,3 +49,86 @@ TEST(lfo, value_check_randomized) {
 		0.001f
 	);
 }
+
+TEST(lfo_bank, value_check_randomized) {
+	using namespace constants;
+
+	std::uniform_real_distribution<float> dist{0.f, 1.f};
+	std::array<float, 4> phases;
+	std::array<float, 4> rates;
+
+	LFOBank<4> lfo;
+	for (size_t lane = 0; lane < 4; ++lane) {
+		phases[lane] = dist(rng);
+		rates[lane] = dist(rng);
+		lfo.set_rate(lane, rates[lane]);
+		lfo.set_phase(lane, phases[lane]);
+	}
+
+	static constexpr size_t steps = 1'000;
+	for (size_t i = 0; i < steps; ++i)
+		lfo.next();
+
+	for (size_t lane = 0; lane < 4; ++lane) {
+		ASSERT_NEAR(
+			lfo.depth(lane),
+			std::sin(2*pi*(phases[lane] + std::fmod(rates[lane]*steps, 1.f))),
+			0.001f
+		);
+	}
+}
+
+// the rotators must not drift away from the unit circle
+TEST(lfo_bank, bounds_check) {
+	LFOBank<2> lfo;
+	lfo.set_rate(0, 0.25f);
+	lfo.set_rate(1, 0.1234f);
+
+	float max = 0.f;
+	for (size_t i = 0; i < 100'000'000; ++i) {
+		lfo.next();
+		max = std::max({max, std::abs(lfo.depth(0)), std::abs(lfo.depth(1))});
+	}
+	ASSERT_LE(max, 1.f);
+	ASSERT_GE(max, 0.999f);
+}
+
+// lanes too fast to interpolate are evaluated every sample
+TEST(lfo_bank, fast_rates) {
+	LFOBank<2> lfo;
+	lfo.set_interval(16);
+	lfo.set_rate(0, 5.f/48000.f);
+	lfo.set_rate(1, 5.f/48000.f);
+	EXPECT_EQ(lfo.interval(), 16u);
+
+	lfo.set_rate(1, 0.1f);
+	EXPECT_EQ(lfo.interval(), 1u);
+	// aliases to a slow rate
+	lfo.set_rate(1, 1.f - 5.f/48000.f);
+	EXPECT_EQ(lfo.interval(), 16u);
+}
+
+// control rate evaluation stays close to the exact lfo for modulation rates
+TEST(lfo_bank, control_rate) {
+	// 5Hz at 48kHz
+	constexpr float rate = 5.f/48000.f;
+	constexpr uint32_t interval = 16;
+
+	LFOBank<1> exact;
+	LFOBank<1> control;
+	exact.set_interval(1);
+	control.set_interval(interval);
+	exact.set_rate(0, rate);
+	control.set_rate(0, rate);
+	exact.set_phase(0, 0.3f);
+	control.set_phase(0, 0.3f);
+
+	std::array<LFOBank<1>::Frame, 64> exact_depths;
+	std::array<LFOBank<1>::Frame, 64> control_depths;
+	for (size_t block = 0; block < 10'000; ++block) {
+		exact.process_block(exact_depths.data(), exact_depths.size());
+		control.process_block(control_depths.data(), control_depths.size());
+		for (size_t i = 0; i < exact_depths.size(); ++i)
+			ASSERT_NEAR(exact_depths[i][0], control_depths[i][0], 0.0001f);
+	}
+}
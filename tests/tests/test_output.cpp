@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
 #include <vector>
 
 #include <gtest/gtest.h>
@@ -114,3 +118,196 @@ TEST(output, silence) {
 	EXPECT_FLOAT_EQ(std::accumulate(l_buf.begin(), l_buf.end(), 0.f), 0.f);
 	EXPECT_FLOAT_EQ(std::accumulate(r_buf.begin(), r_buf.end(), 0.f), 0.f);
 }
+
+namespace {
+	// runs the requests of a block synchronously once it has been processed
+	struct Worker {
+		std::vector<std::vector<uint8_t>> requests;
+		std::vector<std::vector<uint8_t>> responses;
+
+		static LV2_Worker_Status schedule(LV2_Worker_Schedule_Handle handle, uint32_t size, const void* data) {
+			auto bytes = static_cast<const uint8_t*>(data);
+			static_cast<Worker*>(handle)->requests.emplace_back(bytes, bytes+size);
+			return LV2_WORKER_SUCCESS;
+		}
+
+		static LV2_Worker_Status respond(LV2_Worker_Respond_Handle handle, uint32_t size, const void* data) {
+			auto bytes = static_cast<const uint8_t*>(data);
+			static_cast<Worker*>(handle)->responses.emplace_back(bytes, bytes+size);
+			return LV2_WORKER_SUCCESS;
+		}
+
+		void run(Aether::DSP& dsp) {
+			for (const auto& request : requests)
+				dsp.work(respond, this, static_cast<uint32_t>(request.size()), request.data());
+			requests.clear();
+			for (const auto& response : responses)
+				dsp.work_response(static_cast<uint32_t>(response.size()), response.data());
+			responses.clear();
+		}
+	};
+}
+
+// the late delay memory grows with late_delay
+TEST(output, grow_delay_memory) {
+	static constexpr size_t buffer_size = 1024;
+	std::vector<float> in(buffer_size, 0.f);
+	std::vector<float> l_out(buffer_size, 0.f);
+	std::vector<float> r_out(buffer_size, 0.f);
+	in[0] = 1.f;
+
+	Worker worker;
+	const LV2_Worker_Schedule schedule = {&worker, Worker::schedule};
+	Aether::DSP dsp(48000, &schedule);
+	dsp.ports.audio_in_left = in.data();
+	dsp.ports.audio_in_right = in.data();
+	dsp.ports.audio_out_left = l_out.data();
+	dsp.ports.audio_out_right = r_out.data();
+
+	const size_t initial_memory = dsp.delay_memory();
+	EXPECT_LT(initial_memory, Aether::DSP(48000).delay_memory());
+
+	// every other parameter keeps its default
+	float late_delay = 1000.f;
+	dsp.param_ports[23] = &late_delay; // late_delay
+
+	dsp.process(buffer_size);
+	EXPECT_EQ(worker.requests.size(), 1u);
+	worker.run(dsp);
+	// swapped in once the following blocks have copied the history
+	EXPECT_EQ(dsp.delay_memory(), initial_memory);
+	for (int i = 0; i < 10 && dsp.delay_memory() == initial_memory; ++i)
+		dsp.process(buffer_size);
+	const size_t grown_memory = dsp.delay_memory();
+	EXPECT_GT(grown_memory, initial_memory);
+
+	in[0] = 0.f;
+	for (int i = 0; i < 100; ++i) {
+		dsp.process(buffer_size);
+		worker.run(dsp);
+		for (size_t j = 0; j < buffer_size; ++j) {
+			ASSERT_TRUE(std::isfinite(l_out[j]));
+			ASSERT_TRUE(std::isfinite(r_out[j]));
+		}
+	}
+	// large enough for the longest delay
+	EXPECT_EQ(dsp.delay_memory(), grown_memory);
+}
+
+// memory stays with the instance when the host drops requests or responses
+TEST(output, dropped_work) {
+	static constexpr size_t buffer_size = 1024;
+	std::vector<float> in(buffer_size, 0.f);
+	std::vector<float> l_out(buffer_size, 0.f);
+	std::vector<float> r_out(buffer_size, 0.f);
+
+	float late_delay = 1000.f;
+	for (int drop_response = 0; drop_response < 2; ++drop_response) {
+		Worker worker;
+		const LV2_Worker_Schedule schedule = {&worker, Worker::schedule};
+		Aether::DSP dsp(48000, &schedule);
+		dsp.ports.audio_in_left = in.data();
+		dsp.ports.audio_in_right = in.data();
+		dsp.ports.audio_out_left = l_out.data();
+		dsp.ports.audio_out_right = r_out.data();
+		dsp.param_ports[23] = &late_delay; // late_delay
+
+		dsp.process(buffer_size);
+		ASSERT_EQ(worker.requests.size(), 1u);
+		if (drop_response) {
+			dsp.work(Worker::respond, &worker, static_cast<uint32_t>(worker.requests[0].size()), worker.requests[0].data());
+			continue;
+		}
+		worker.run(dsp);
+
+		// the previous buffers are handed to the worker, which never frees them
+		for (int i = 0; i < 10 && worker.requests.empty(); ++i)
+			dsp.process(buffer_size);
+		EXPECT_EQ(worker.requests.size(), 1u);
+	}
+}
+
+// sleeps once the tail has decayed and wakes up on the first non-zero sample
+TEST(output, sleep) {
+	static constexpr size_t buffer_size = 1024;
+	std::vector<float> in(buffer_size, 0.f);
+	std::vector<float> l_out(buffer_size, 0.f);
+	std::vector<float> r_out(buffer_size, 0.f);
+
+	// every parameter keeps its default
+	Aether::DSP dsp(48000);
+	dsp.ports.audio_in_left = in.data();
+	dsp.ports.audio_in_right = in.data();
+	dsp.ports.audio_out_left = l_out.data();
+	dsp.ports.audio_out_right = r_out.data();
+
+	in[0] = 1.f;
+	dsp.process(buffer_size);
+	EXPECT_FALSE(dsp.sleeping());
+
+	in[0] = 0.f;
+	for (size_t i = 0; i < 60*48000/buffer_size && !dsp.sleeping(); ++i)
+		dsp.process(buffer_size);
+	ASSERT_TRUE(dsp.sleeping());
+
+	dsp.process(buffer_size);
+	EXPECT_EQ(std::accumulate(l_out.begin(), l_out.end(), 0.f), 0.f);
+	EXPECT_EQ(std::accumulate(r_out.begin(), r_out.end(), 0.f), 0.f);
+
+	in[buffer_size/2] = 1.f;
+	dsp.process(buffer_size);
+	EXPECT_FALSE(dsp.sleeping());
+	EXPECT_NE(l_out[buffer_size/2], 0.f);
+}
+
+// a late stage that is turned off and right back on carries on with its tail
+TEST(output, late_level_toggle) {
+	static constexpr size_t buffer_size = 1024;
+	std::vector<float> in(buffer_size, 0.f);
+	std::vector<float> l_out(buffer_size, 0.f);
+	std::vector<float> r_out(buffer_size, 0.f);
+
+	Aether::DSP dsp(48000);
+	dsp.ports.audio_in_left = in.data();
+	dsp.ports.audio_in_right = in.data();
+	dsp.ports.audio_out_left = l_out.data();
+	dsp.ports.audio_out_right = r_out.data();
+
+	// only the late stage reaches the output
+	float zero = 0.f;
+	float late_level = 20.f;
+	dsp.param_ports[1] = &zero; // dry_level
+	dsp.param_ports[2] = &zero; // predelay_level
+	dsp.param_ports[3] = &zero; // early_level
+	dsp.param_ports[4] = &late_level; // late_level
+	dsp.reset_parameters();
+
+	auto peak = [&] {
+		float peak = 0.f;
+		for (size_t i = 0; i < buffer_size; ++i)
+			peak = std::max({peak, std::abs(l_out[i]), std::abs(r_out[i])});
+		return peak;
+	};
+
+	in[0] = 1.f;
+	dsp.process(buffer_size);
+	in[0] = 0.f;
+	for (int i = 0; i < 8; ++i)
+		dsp.process(buffer_size);
+	ASSERT_GT(peak(), 0.f);
+
+	late_level = 0.f;
+	for (int i = 0; i < 4; ++i)
+		dsp.process(buffer_size);
+	EXPECT_EQ(peak(), 0.f);
+
+	late_level = 20.f;
+	for (int i = 0; i < 2; ++i) {
+		dsp.process(buffer_size);
+		for (size_t j = 0; j < buffer_size; ++j) {
+			ASSERT_TRUE(std::isfinite(l_out[j]));
+			ASSERT_TRUE(std::isfinite(r_out[j]));
+		}
+	}
+	EXPECT_GT(peak(), 1e-4f);
+}
@@ -0,0 +1,57 @@
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+#define AETHER_PROFILE
+#include "DSP/utils/profiler.hpp"
+
+namespace {
+	enum class Stage { a, b, count };
+}
+
+TEST(profiler, stats) {
+	StageProfiler<Stage> profiler;
+	EXPECT_EQ(profiler.stats(Stage::a).count, 0u);
+
+	for (uint64_t ns = 1; ns <= 1000; ++ns)
+		profiler.record(Stage::a, ns);
+	profiler.record(Stage::b, 7);
+
+	const auto a = profiler.stats(Stage::a);
+	EXPECT_EQ(a.count, 1000u);
+	EXPECT_EQ(a.min, 1u);
+	EXPECT_EQ(a.max, 1000u);
+	EXPECT_DOUBLE_EQ(a.avg, 500.5);
+	// the histogram overestimates by at most a quarter
+	EXPECT_GE(a.p99, 990u);
+	EXPECT_LE(a.p99, 1000u);
+
+	const auto b = profiler.stats(Stage::b);
+	EXPECT_EQ(b.count, 1u);
+	EXPECT_EQ(b.p99, 7u);
+
+	profiler.reset();
+	EXPECT_EQ(profiler.stats(Stage::a).count, 0u);
+}
+
+TEST(profiler, p99) {
+	StageProfiler<Stage> profiler;
+	for (int i = 0; i < 990; ++i)
+		profiler.record(Stage::a, 100);
+	for (int i = 0; i < 10; ++i)
+		profiler.record(Stage::a, 100000);
+
+	const auto a = profiler.stats(Stage::a);
+	EXPECT_GE(a.p99, 100u);
+	EXPECT_LT(a.p99, 125u);
+	EXPECT_EQ(a.max, 100000u);
+}
+
+TEST(profiler, lap) {
+	StageProfiler<Stage> profiler;
+	auto start = StageProfiler<Stage>::now();
+	start = profiler.lap(Stage::a, start);
+	profiler.lap(Stage::b, start);
+	EXPECT_EQ(profiler.stats(Stage::a).count, 1u);
+	EXPECT_EQ(profiler.stats(Stage::b).count, 1u);
+}
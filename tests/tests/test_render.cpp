@@ -0,0 +1,56 @@
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include "render/audio_file.hpp"
+#include "render/preset.hpp"
+
+// every member of DSP::Parameters has a name
+TEST(render, parameter_names) {
+	Render::Preset preset = {};
+	for (size_t p = 0; p < preset.size(); ++p)
+		EXPECT_EQ(Render::parameter_index(Render::parameter_names[p]), p);
+	EXPECT_EQ(Render::parameter_names[Render::parameter_index("late_delay").value()], "late_delay");
+	EXPECT_FALSE(Render::parameter_index("late_Delay"));
+}
+
+TEST(render, parse_preset) {
+	Render::Preset preset = Render::default_preset();
+	Render::parse_preset("# comment\n mix = 50\n\nlate_delay=250 # ms\n", preset);
+	EXPECT_EQ(preset.mix, 50.f);
+	EXPECT_EQ(preset.late_delay, 250.f);
+
+	Render::parse_preset(R"({"mix": 25, "interpolate": false, "late_delay_lines": 12})", preset);
+	EXPECT_EQ(preset.mix, 25.f);
+	EXPECT_EQ(preset.interpolate, 0.f);
+	EXPECT_EQ(preset.late_delay_lines, 12.f);
+
+	EXPECT_THROW(Render::parse_preset("mix\n", preset), std::runtime_error);
+	EXPECT_THROW(Render::parse_preset("unknown=1\n", preset), std::runtime_error);
+	EXPECT_THROW(Render::parse_preset("mix=abc\n", preset), std::runtime_error);
+	EXPECT_THROW(Render::parse_preset(R"({"mix": 1)", preset), std::runtime_error);
+	EXPECT_THROW(Render::parse_preset(R"({"mix": {"a": 1}})", preset), std::runtime_error);
+}
+
+// float wav files are written and read back unchanged
+TEST(render, wav_round_trip) {
+	Render::Audio audio;
+	audio.rate = 44100.f;
+	for (int i = 0; i < 1000; ++i) {
+		audio.left.push_back(static_cast<float>(i)/1000.f);
+		audio.right.push_back(-static_cast<float>(i)/1000.f);
+	}
+
+	const auto path = std::filesystem::temp_directory_path() / "aether_test_render.wav";
+	Render::write_audio(path, audio);
+	const Render::Audio read = Render::read_audio(path, 0.f);
+	std::filesystem::remove(path);
+
+	EXPECT_EQ(read.rate, audio.rate);
+	EXPECT_EQ(read.left, audio.left);
+	EXPECT_EQ(read.right, audio.right);
+
+	EXPECT_THROW(Render::read_audio(path, 0.f), std::runtime_error);
+}
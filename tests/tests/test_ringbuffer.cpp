@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+#include <gtest/gtest.h>
+
+#include "DSP/delay.hpp"
+#include "DSP/utils/ringbuffer.hpp"
+
+// the capacity is rounded up to a power of two
+TEST(ringbuffer, capacity) {
+	Ringbuffer<float> buf{100, 8};
+	EXPECT_EQ(buf.capacity, 128u);
+	EXPECT_EQ(buf.mask, 127u);
+	EXPECT_EQ(buf.allocated(), 136u);
+}
+
+// elements are read back delay elements after they were pushed
+TEST(ringbuffer, push) {
+	Ringbuffer<float> buf{16, 4};
+	for (size_t i = 0; i < 100; ++i) {
+		buf.push(static_cast<float>(i));
+		for (size_t delay = 0; delay < std::min<size_t>(i+1, 16); ++delay)
+			ASSERT_EQ(buf[delay], static_cast<float>(i - delay));
+	}
+}
+
+// windows stay contiguous across the end of the buffer
+TEST(ringbuffer, window) {
+	Ringbuffer<float> buf{16, 4};
+	for (size_t i = 0; i < 100; ++i) {
+		buf.push(static_cast<float>(i));
+		if (i < 16) continue;
+
+		for (size_t delay = 3; delay < 16; ++delay) {
+			const float* window = buf.window(delay);
+			for (size_t j = 0; j < 4; ++j)
+				ASSERT_EQ(window[j], static_cast<float>(i - delay + j));
+		}
+	}
+}
+
+// block writes match pushing every element
+TEST(ringbuffer, write) {
+	Ringbuffer<float> pushed{16, 4};
+	Ringbuffer<float> written{16, 4};
+
+	float value = 0.f;
+	for (size_t n : {3u, 7u, 16u, 1u, 5u, 11u, 9u}) {
+		std::array<float, 16> block;
+		for (size_t i = 0; i < n; ++i) {
+			block[i] = ++value;
+			pushed.push(block[i]);
+		}
+		written.write(block.data(), n);
+
+		ASSERT_EQ(written.end, pushed.end);
+		for (size_t i = 0; i < pushed.allocated(); ++i)
+			ASSERT_EQ(written.buf[i], pushed.buf[i]);
+	}
+}
+
+// block processing matches processing sample by sample
+TEST(delay, process_block) {
+	Delay pushed(48000);
+	Delay blocked(48000);
+
+	for (size_t delay : {0u, 1u, 63u, 64u, 1000u, 24000u}) {
+		std::array<float, 200> in;
+		std::array<float, 200> out;
+		for (size_t i = 0; i < in.size(); ++i)
+			in[i] = static_cast<float>(i+1);
+
+		blocked.process_block(in.data(), out.data(), in.size(), delay);
+		for (size_t i = 0; i < in.size(); ++i)
+			ASSERT_EQ(out[i], pushed.push(in[i], delay));
+	}
+}
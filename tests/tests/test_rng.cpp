@@ -26,3 +26,37 @@ TEST(rng, sequence) {
 	for (auto count : counts)
 		EXPECT_LE(std::abs(count - expected), 5*expected/100);
 }
+
+// Checks that the cached sequence matches Random::generate
+TEST(rng, crossmixed_sequence) {
+	constexpr size_t size = 100;
+	Random::CrossmixedSequence<size> sequence;
+
+	for (uint32_t seed : {0u, 1u, 12345u}) {
+		for (float crossmix : {0.f, 0.3f, 1.f}) {
+			sequence.set_seed(seed);
+			sequence.set_crossmix(crossmix);
+			// seed changes bypass the rate limit
+			ASSERT_TRUE(sequence.update(0));
+
+			std::array<float, size> expected;
+			Random::generate(expected, seed, crossmix);
+			for (size_t i = 0; i < size; ++i)
+				EXPECT_EQ(sequence[i], expected[i]);
+		}
+	}
+}
+
+// Checks that crossmix changes are rate limited
+TEST(rng, crossmixed_sequence_rate_limit) {
+	using Sequence = Random::CrossmixedSequence<8>;
+	Sequence sequence(1, 0.f);
+
+	sequence.set_crossmix(0.5f);
+	ASSERT_TRUE(sequence.update(1));
+
+	sequence.set_crossmix(0.6f);
+	EXPECT_FALSE(sequence.update(Sequence::refresh_interval-1));
+	EXPECT_TRUE(sequence.update(1));
+	EXPECT_FALSE(sequence.update(Sequence::refresh_interval));
+}
@@ -0,0 +1,50 @@
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "UI/utils/sample_history.hpp"
+
+using Aether::SampleHistory;
+
+// matches the latest samples of everything pushed, whatever the size of each push
+TEST(sample_history, push) {
+	SampleHistory history;
+	history.resize(16);
+	ASSERT_EQ(history.size(), 16u);
+
+	std::deque<float> expected(16, 0.f);
+	float next = 1.f;
+	for (size_t n : {1u, 5u, 15u, 16u, 3u, 40u, 7u, 0u, 9u}) {
+		std::vector<float> samples(n);
+		for (float& sample : samples) {
+			sample = next++;
+			expected.push_back(sample);
+			expected.pop_front();
+		}
+		history.push(samples.data(), n);
+
+		std::vector<float> linear(history.size());
+		history.linearize(linear.data());
+		for (size_t i = 0; i < linear.size(); ++i)
+			ASSERT_EQ(linear[i], expected[i]);
+	}
+}
+
+// resizing starts over from silence
+TEST(sample_history, resize) {
+	SampleHistory history;
+	const float sample = 1.f;
+	history.push(&sample, 1);
+	EXPECT_EQ(history.size(), 0u);
+
+	history.resize(4);
+	history.push(&sample, 1);
+	history.resize(8);
+
+	std::vector<float> linear(8, 2.f);
+	history.linearize(linear.data());
+	for (float value : linear)
+		EXPECT_EQ(value, 0.f);
+}
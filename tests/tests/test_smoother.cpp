@@ -0,0 +1,81 @@
+#include <array>
+
+#include <gtest/gtest.h>
+
+#include "DSP/utils/smoother.hpp"
+
+namespace {
+	constexpr uint32_t block_size = 32;
+}
+
+// parameters without smoothing jump straight to their target
+TEST(smoother, unsmoothed) {
+	ParameterSmoother<2> smoother{block_size};
+	smoother.set_smoothing(0, 0.f, 0.f);
+	smoother.set_smoothing(1, 0.f, 0.f);
+
+	std::array<float, 2> values = {};
+	std::array<bool, 2> modified = {};
+
+	smoother.set_target(1, 5.f);
+	ASSERT_EQ(smoother.active_count(), 1u);
+	ASSERT_TRUE(smoother.advance(block_size, values.data(), modified.data()));
+
+	EXPECT_EQ(values[1], 5.f);
+	EXPECT_TRUE(modified[1]);
+	EXPECT_FALSE(modified[0]);
+	EXPECT_EQ(smoother.active_count(), 0u);
+}
+
+// smoothed parameters converge, snap to their target and leave the active list
+TEST(smoother, converges) {
+	ParameterSmoother<3> smoother{block_size};
+	for (size_t p = 0; p < 3; ++p)
+		smoother.set_smoothing(p, 0.99f, 1e-4f);
+
+	std::array<float, 3> values = {};
+	smoother.set_target(0, 1.f);
+	smoother.set_target(2, -1.f);
+	ASSERT_EQ(smoother.active_count(), 2u);
+
+	size_t blocks = 0;
+	while (smoother.active_count() != 0 && blocks < 1000) {
+		std::array<bool, 3> modified = {};
+		smoother.advance(block_size, values.data(), modified.data());
+		EXPECT_FALSE(modified[1]);
+		++blocks;
+	}
+
+	EXPECT_LT(blocks, 1000u);
+	EXPECT_EQ(values[0], 1.f);
+	EXPECT_EQ(values[1], 0.f);
+	EXPECT_EQ(values[2], -1.f);
+
+	// nothing left to do
+	std::array<bool, 3> modified = {};
+	EXPECT_FALSE(smoother.advance(block_size, values.data(), modified.data()));
+}
+
+// changes smaller than the threshold are not reported
+TEST(smoother, threshold) {
+	ParameterSmoother<1> smoother{block_size};
+	smoother.set_smoothing(0, 0.999f, 0.1f);
+
+	std::array<float, 1> values = {};
+	std::array<bool, 1> modified = {};
+	smoother.set_target(0, 1.f);
+
+	// 1 - 0.999^32 ~= 0.031
+	EXPECT_FALSE(smoother.advance(block_size, values.data(), modified.data()));
+	EXPECT_GT(values[0], 0.f);
+	EXPECT_FALSE(modified[0]);
+
+	size_t reports = 0;
+	while (smoother.active_count() != 0) {
+		modified = {};
+		reports += smoother.advance(block_size, values.data(), modified.data());
+	}
+
+	EXPECT_EQ(values[0], 1.f);
+	EXPECT_LE(reports, 10u);
+}
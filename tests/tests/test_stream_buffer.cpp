@@ -0,0 +1,84 @@
+#include <array>
+#include <cstddef>
+
+#include <gtest/gtest.h>
+
+#include "DSP/utils/stream_buffer.hpp"
+
+// samples are popped in the order they were pushed, across the end of the buffer
+TEST(stream_buffer, fifo) {
+	StreamBuffer buf{16};
+	EXPECT_EQ(buf.capacity(), 16u);
+
+	float next_in = 0.f;
+	float next_out = 0.f;
+	for (size_t n : {5u, 9u, 3u, 12u, 7u, 16u, 1u}) {
+		std::array<float, 16> l, r;
+		for (size_t i = 0; i < n; ++i) {
+			l[i] = next_in;
+			r[i] = -next_in;
+			++next_in;
+		}
+		buf.push(l.data(), r.data(), n);
+		ASSERT_EQ(buf.size(), n);
+
+		ASSERT_EQ(buf.pop(l.data(), r.data(), 16), n);
+		for (size_t i = 0; i < n; ++i) {
+			ASSERT_EQ(l[i], next_out);
+			ASSERT_EQ(r[i], -next_out);
+			++next_out;
+		}
+		ASSERT_EQ(buf.size(), 0u);
+	}
+}
+
+// a full buffer keeps the newest samples
+TEST(stream_buffer, overwrite) {
+	StreamBuffer buf{8};
+	std::array<float, 20> l, r;
+	for (size_t i = 0; i < l.size(); ++i)
+		l[i] = r[i] = static_cast<float>(i);
+	buf.push(l.data(), r.data(), l.size());
+	ASSERT_EQ(buf.size(), 8u);
+
+	// popped a few at a time like the atoms sent to the ui
+	for (size_t i = 12; i < 20; i += 3) {
+		const size_t n = buf.pop(l.data(), r.data(), 3);
+		ASSERT_EQ(n, std::min<size_t>(3, 20-i));
+		for (size_t j = 0; j < n; ++j)
+			ASSERT_EQ(l[j], static_cast<float>(i+j));
+	}
+	EXPECT_EQ(buf.pop(l.data(), r.data(), 3), 0u);
+}
+
+// every decimation samples are averaged into one, even across pushes
+TEST(stream_buffer, decimation) {
+	StreamBuffer buf{16, 4};
+	std::array<float, 6> l = {1.f, 2.f, 3.f, 4.f, 5.f, 6.f};
+	std::array<float, 6> r = {0.f, 0.f, 0.f, 4.f, 4.f, 4.f};
+	buf.push(l.data(), r.data(), 6);
+	ASSERT_EQ(buf.size(), 1u);
+	buf.push(l.data(), r.data(), 2);
+	ASSERT_EQ(buf.size(), 2u);
+
+	std::array<float, 2> l_out, r_out;
+	ASSERT_EQ(buf.pop(l_out.data(), r_out.data(), 2), 2u);
+	EXPECT_FLOAT_EQ(l_out[0], 2.5f);
+	EXPECT_FLOAT_EQ(r_out[0], 1.f);
+	EXPECT_FLOAT_EQ(l_out[1], 3.5f);
+	EXPECT_FLOAT_EQ(r_out[1], 2.f);
+}
+
+// clear drops a partly summed sample too
+TEST(stream_buffer, clear) {
+	StreamBuffer buf{16, 2};
+	std::array<float, 3> l = {1.f, 1.f, 8.f};
+	buf.push(l.data(), l.data(), 3);
+	buf.clear();
+	EXPECT_EQ(buf.size(), 0u);
+
+	std::array<float, 2> zeros = {};
+	buf.push(zeros.data(), zeros.data(), 2);
+	ASSERT_EQ(buf.pop(l.data(), l.data(), 2), 1u);
+	EXPECT_EQ(l[0], 0.f);
+}
@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "DSP/delayline.hpp"
+#include "DSP/utils/worker_pool.hpp"
+
+// every task runs exactly once per call
+TEST(worker_pool, run) {
+	WorkerPool pool(3);
+	EXPECT_EQ(pool.threads(), 3u);
+
+	std::array<std::atomic<uint32_t>, 64> counts = {};
+	for (int awake = 0; awake < 2; ++awake) {
+		if (awake) pool.wake();
+		for (uint32_t n = 0; n <= counts.size(); ++n) {
+			for (auto& count : counts) count = 0;
+			pool.run(n, [](void* context, uint32_t task) {
+				(*static_cast<std::array<std::atomic<uint32_t>, 64>*>(context))[task]++;
+			}, &counts);
+			for (uint32_t i = 0; i < counts.size(); ++i)
+				ASSERT_EQ(counts[i], i < n ? 1u : 0u);
+		}
+		pool.sleep();
+	}
+}
+
+// processing the late delay lines in parallel does not change the output
+TEST(worker_pool, late_rev) {
+	static constexpr float rate = 48000;
+	static constexpr size_t block_size = 32;
+
+	std::mt19937 rng_serial{1};
+	std::mt19937 rng_parallel{1};
+	LateRev serial(rate, rng_serial);
+	LateRev parallel(rate, rng_parallel);
+
+	for (LateRev* late : {&serial, &parallel}) {
+		late->set_delay_lines(12);
+		late->set_delay(0.1f*rate);
+		late->set_delay_mod_depth(0.0005f*rate);
+		late->set_delay_mod_rate(0.5f/rate);
+		late->set_delay_feedback(0.8f);
+		late->set_delay_seed(1);
+		late->set_diffusion_delay(0.01f*rate);
+		late->set_diffusion_mod_depth(0.0005f*rate);
+		late->set_diffusion_mod_rate(0.5f/rate);
+		late->set_diffusion_seed(1);
+		late->set_high_cut_cutoff(8000.f);
+	}
+
+	LateRev::PushInfo info = {};
+	info.order = LateRev::Order::pre;
+	info.diffuser_info = {4, 0.5f, true};
+	info.damping_info = {false, false, true};
+
+	WorkerPool pool(2);
+	pool.wake();
+	parallel.set_parallel(true);
+
+	// the pool gets whole calls at once once they are settled, like DSP::process
+	static constexpr size_t call_size = LateRev::parallel_size + 1000;
+	std::uniform_real_distribution<float> dist(-1.f, 1.f);
+	std::vector<LateRev::StereoFrame> in(call_size);
+	std::vector<LateRev::StereoFrame> out_serial(call_size);
+	std::vector<LateRev::StereoFrame> out_parallel(call_size);
+	int spans = 0;
+	for (int call = 0; call < 40; ++call) {
+		// the line count changes while processing
+		if (call == 20) {
+			serial.set_delay_lines(7);
+			parallel.set_delay_lines(7);
+		}
+
+		for (auto& frame : in)
+			frame = {dist(rng_serial), dist(rng_serial)};
+
+		const bool span = parallel.settled();
+		for (size_t offset = 0; offset < call_size; offset += block_size) {
+			const size_t n = std::min(block_size, call_size - offset);
+			serial.process_block(in.data() + offset, out_serial.data() + offset, n, info);
+			if (!span)
+				parallel.process_block(in.data() + offset, out_parallel.data() + offset, n, info, &pool);
+		}
+		if (span) {
+			parallel.process_block(in.data(), out_parallel.data(), call_size, info, &pool);
+			++spans;
+		}
+
+		for (size_t i = 0; i < call_size; ++i) {
+			ASSERT_EQ(out_serial[i][0], out_parallel[i][0]);
+			ASSERT_EQ(out_serial[i][1], out_parallel[i][1]);
+		}
+	}
+	EXPECT_GT(spans, 0);
+
+	pool.sleep();
+}